@@ -97,7 +97,19 @@ void AirbourneBoard::serial_write(const uint8_t *src, size_t len)
   current_serial_->write(src, len);
 }
 
-uint16_t AirbourneBoard::serial_bytes_available()
+uint8_t *AirbourneBoard::serial_reserve(size_t len)
+{
+  // The airbourne Serial drivers only accept copies into their own ring, so let the caller stage the frame
+  (void)len;
+  return nullptr;
+}
+
+void AirbourneBoard::serial_commit(size_t len)
+{
+  (void)len;
+}
+
+void AirbourneBoard::select_serial()
 {
   if (vcp_.connected() || secondary_serial_device_ == SERIAL_DEVICE_VCP)
   {
@@ -115,7 +127,11 @@ uint16_t AirbourneBoard::serial_bytes_available()
       break;
     }
   }
+}
 
+uint16_t AirbourneBoard::serial_bytes_available()
+{
+  select_serial();
   return current_serial_->rx_bytes_waiting();
 }
 
@@ -124,6 +140,18 @@ uint8_t AirbourneBoard::serial_read()
   return current_serial_->read_byte();
 }
 
+size_t AirbourneBoard::serial_read(uint8_t *dest, size_t len)
+{
+  // the port is chosen once per chunk rather than once per byte
+  select_serial();
+  size_t waiting = current_serial_->rx_bytes_waiting();
+  if (len > waiting)
+    len = waiting;
+  for (size_t i = 0; i < len; i++)
+    dest[i] = current_serial_->read_byte();
+  return len;
+}
+
 void AirbourneBoard::serial_flush()
 {
   current_serial_->flush();
@@ -402,14 +430,38 @@ void AirbourneBoard::pwm_disable()
   }
 }
 
-void AirbourneBoard::pwm_write(uint8_t channel, float value)
+void AirbourneBoard::pwm_write_all(const float *value, const Mixer::output_type_t *type, uint8_t count)
 {
-  if (channel < PWM_NUM_OUTPUTS)
+  for (int i = 0; i < count && i < PWM_NUM_OUTPUTS; i++)
   {
-    esc_out_[channel].write(value);
+    if (type[i] == Mixer::S || type[i] == Mixer::M)
+      esc_out_[i].write(value[i]);
   }
 }
 
+// DShot
+bool AirbourneBoard::dshot_init(uint16_t bitrate_kbps, bool bidirectional, uint16_t channel_mask)
+{
+  (void)bitrate_kbps;
+  (void)bidirectional;
+  (void)channel_mask;
+  // Needs a DMA burst timer driver in airbourne, until then the mixer falls back to PWM
+  return false;
+}
+
+void AirbourneBoard::dshot_write(const uint16_t *frames, uint8_t count)
+{
+  (void)frames;
+  (void)count;
+}
+
+bool AirbourneBoard::dshot_read_telemetry(uint8_t channel, uint32_t *gcr_frame)
+{
+  (void)channel;
+  (void)gcr_frame;
+  return false;
+}
+
 bool AirbourneBoard::rc_lost()
 {
   return rc_->lost();
@@ -431,6 +483,68 @@ bool AirbourneBoard::memory_write(const void *data, size_t len)
   return flash_.write_config(reinterpret_cast<const uint8_t *>(data), len);
 }
 
+size_t AirbourneBoard::param_journal_sector_size()
+{
+  // the M25P16 driver only exposes the config image so far, so parameters are stored through memory_write()
+  return 0;
+}
+
+bool AirbourneBoard::param_journal_erase(uint8_t sector)
+{
+  (void)sector;
+  return false;
+}
+
+bool AirbourneBoard::param_journal_read(uint8_t sector, size_t offset, void *dest, size_t len)
+{
+  (void)sector;
+  (void)offset;
+  (void)dest;
+  (void)len;
+  return false;
+}
+
+bool AirbourneBoard::param_journal_program(uint8_t sector, size_t offset, const void *src, size_t len)
+{
+  (void)sector;
+  (void)offset;
+  (void)src;
+  (void)len;
+  return false;
+}
+
+size_t AirbourneBoard::log_storage_size()
+{
+  // the M25P16 driver has no page program or DMA interface yet, so there is nowhere to put a flight log
+  return 0;
+}
+
+bool AirbourneBoard::log_storage_busy()
+{
+  return false;
+}
+
+bool AirbourneBoard::log_storage_erase()
+{
+  return false;
+}
+
+bool AirbourneBoard::log_storage_write(size_t offset, const void *src, size_t len)
+{
+  (void)offset;
+  (void)src;
+  (void)len;
+  return false;
+}
+
+bool AirbourneBoard::log_storage_read(size_t offset, void *dest, size_t len)
+{
+  (void)offset;
+  (void)dest;
+  (void)len;
+  return false;
+}
+
 // LED
 void AirbourneBoard::led0_on()
 {
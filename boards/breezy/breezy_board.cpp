@@ -92,6 +92,18 @@ void BreezyBoard::serial_write(const uint8_t *src, size_t len)
   }
 }
 
+uint8_t *BreezyBoard::serial_reserve(size_t len)
+{
+  // breezystm32 only queues single bytes, so let the caller stage the frame
+  (void)len;
+  return nullptr;
+}
+
+void BreezyBoard::serial_commit(size_t len)
+{
+  (void)len;
+}
+
 uint16_t BreezyBoard::serial_bytes_available()
 {
   return serialTotalBytesWaiting(Serial1);
@@ -102,6 +114,16 @@ uint8_t BreezyBoard::serial_read()
   return serialRead(Serial1);
 }
 
+size_t BreezyBoard::serial_read(uint8_t *dest, size_t len)
+{
+  size_t waiting = serialTotalBytesWaiting(Serial1);
+  if (len > waiting)
+    len = waiting;
+  for (size_t i = 0; i < len; i++)
+    dest[i] = serialRead(Serial1);
+  return len;
+}
+
 void BreezyBoard::serial_flush()
 {
   return;
@@ -355,9 +377,36 @@ float BreezyBoard::rc_read(uint8_t channel)
   return (float)(pwmRead(channel) - 1000) / 1000.0;
 }
 
-void BreezyBoard::pwm_write(uint8_t channel, float value)
+void BreezyBoard::pwm_write_all(const float *value, const Mixer::output_type_t *type, uint8_t count)
+{
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (type[i] == Mixer::S || type[i] == Mixer::M)
+      pwmWriteMotor(i, static_cast<uint16_t>(value[i] * 1000) + 1000);
+  }
+}
+
+// DShot
+bool BreezyBoard::dshot_init(uint16_t bitrate_kbps, bool bidirectional, uint16_t channel_mask)
 {
-  pwmWriteMotor(channel, static_cast<uint16_t>(value * 1000) + 1000);
+  (void)bitrate_kbps;
+  (void)bidirectional;
+  (void)channel_mask;
+  // breezystm32 has no DMA timer output driver, so the mixer falls back to PWM
+  return false;
+}
+
+void BreezyBoard::dshot_write(const uint16_t *frames, uint8_t count)
+{
+  (void)frames;
+  (void)count;
+}
+
+bool BreezyBoard::dshot_read_telemetry(uint8_t channel, uint32_t *gcr_frame)
+{
+  (void)channel;
+  (void)gcr_frame;
+  return false;
 }
 
 bool BreezyBoard::rc_lost()
@@ -382,6 +431,68 @@ bool BreezyBoard::memory_write(const void *src, size_t len)
   return writeEEPROM(src, len);
 }
 
+size_t BreezyBoard::param_journal_sector_size()
+{
+  // the three 1 kB config pages can't hold two sectors big enough for the journal
+  return 0;
+}
+
+bool BreezyBoard::param_journal_erase(uint8_t sector)
+{
+  (void)sector;
+  return false;
+}
+
+bool BreezyBoard::param_journal_read(uint8_t sector, size_t offset, void *dest, size_t len)
+{
+  (void)sector;
+  (void)offset;
+  (void)dest;
+  (void)len;
+  return false;
+}
+
+bool BreezyBoard::param_journal_program(uint8_t sector, size_t offset, const void *src, size_t len)
+{
+  (void)sector;
+  (void)offset;
+  (void)src;
+  (void)len;
+  return false;
+}
+
+size_t BreezyBoard::log_storage_size()
+{
+  // no external flash, and the internal pages are taken by the config
+  return 0;
+}
+
+bool BreezyBoard::log_storage_busy()
+{
+  return false;
+}
+
+bool BreezyBoard::log_storage_erase()
+{
+  return false;
+}
+
+bool BreezyBoard::log_storage_write(size_t offset, const void *src, size_t len)
+{
+  (void)offset;
+  (void)src;
+  (void)len;
+  return false;
+}
+
+bool BreezyBoard::log_storage_read(size_t offset, void *dest, size_t len)
+{
+  (void)offset;
+  (void)dest;
+  (void)len;
+  return false;
+}
+
 // GNSS is not supported on breezy boards
 GNSSData BreezyBoard::gnss_read()
 {
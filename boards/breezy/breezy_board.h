@@ -93,8 +93,11 @@ public:
   // serial
   void serial_init(uint32_t baud_rate, uint32_t dev) override;
   void serial_write(const uint8_t *src, size_t len) override;
+  uint8_t *serial_reserve(size_t len) override;
+  void serial_commit(size_t len) override;
   uint16_t serial_bytes_available() override;
   uint8_t serial_read() override;
+  size_t serial_read(uint8_t *dest, size_t len) override;
   void serial_flush() override;
 
   // sensors
@@ -144,12 +147,26 @@ public:
 
   void pwm_init(uint32_t refresh_rate, uint16_t idle_pwm) override;
   void pwm_disable() override;
-  void pwm_write(uint8_t channel, float value) override;
+  void pwm_write_all(const float *value, const Mixer::output_type_t *type, uint8_t count) override;
+
+  // DShot
+  bool dshot_init(uint16_t bitrate_kbps, bool bidirectional, uint16_t channel_mask) override;
+  void dshot_write(const uint16_t *frames, uint8_t count) override;
+  bool dshot_read_telemetry(uint8_t channel, uint32_t *gcr_frame) override;
 
   // non-volatile memory
   void memory_init() override;
   bool memory_read(void *dest, size_t len) override;
   bool memory_write(const void *src, size_t len) override;
+  size_t param_journal_sector_size() override;
+  bool param_journal_erase(uint8_t sector) override;
+  bool param_journal_read(uint8_t sector, size_t offset, void *dest, size_t len) override;
+  bool param_journal_program(uint8_t sector, size_t offset, const void *src, size_t len) override;
+  size_t log_storage_size() override;
+  bool log_storage_busy() override;
+  bool log_storage_erase() override;
+  bool log_storage_write(size_t offset, const void *src, size_t len) override;
+  bool log_storage_read(size_t offset, void *dest, size_t len) override;
 
   // LEDs
   void led0_on() override;
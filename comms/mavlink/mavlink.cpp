@@ -33,23 +33,332 @@
 #include "board.h"
 
 #include <cstdint>
+#include <cstring>
+
+mavlink_system_t mavlink_system;
+
+// ROSFLIGHT_IMU_BATCH is not part of the generated dialect yet, so its wire layout is spelled out here. Fields are
+// in MAVLink wire order (largest type first); the CRC extra is computed from the equivalent XML definition:
+//   uint64_t time_usec   timestamp of the first sample
+//   uint8_t count        number of valid samples
+//   uint16_t dt_us[10]   time since the previous sample (dt_us[0] is always 0)
+//   int16_t accel[30]    x, y, z per sample, ROSFLIGHT_IMU_BATCH_ACCEL_LSB m/s^2 per count
+//   int16_t gyro[30]     x, y, z per sample, ROSFLIGHT_IMU_BATCH_GYRO_LSB rad/s per count
+#define MAVLINK_MSG_ID_ROSFLIGHT_IMU_BATCH 210
+#define MAVLINK_MSG_ID_ROSFLIGHT_IMU_BATCH_LEN 149
+#define MAVLINK_MSG_ID_ROSFLIGHT_IMU_BATCH_CRC 63
+#define ROSFLIGHT_IMU_BATCH_SAMPLES 10
+#define ROSFLIGHT_IMU_BATCH_ACCEL_LSB 0.005f // +/- 16 g
+#define ROSFLIGHT_IMU_BATCH_GYRO_LSB 0.001f  // +/- 1875 deg/s
+
+#pragma pack(push, 1)
+struct mavlink_rosflight_imu_batch_t
+{
+  uint64_t time_usec;
+  uint16_t dt_us[ROSFLIGHT_IMU_BATCH_SAMPLES];
+  int16_t accel[3 * ROSFLIGHT_IMU_BATCH_SAMPLES];
+  int16_t gyro[3 * ROSFLIGHT_IMU_BATCH_SAMPLES];
+  uint8_t count;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(mavlink_rosflight_imu_batch_t) == MAVLINK_MSG_ID_ROSFLIGHT_IMU_BATCH_LEN,
+              "ROSFLIGHT_IMU_BATCH layout does not match its wire length");
+
+// ROSFLIGHT_PARAM_TABLE summarizes the parameter table so a ground station can tell which parts of its cached copy
+// are stale, then fetch only those with ROSFLIGHT_PARAM_REQUEST_RANGE. Checksums are Params::checksum().
+//   uint16_t param_count
+//   uint16_t table_checksum        over every parameter
+//   uint8_t block_size             parameters per block
+//   uint8_t block_count            number of valid block checksums
+//   uint16_t block_checksums[32]   block i covers IDs [i * block_size, (i + 1) * block_size)
+#define MAVLINK_MSG_ID_ROSFLIGHT_PARAM_TABLE 211
+#define MAVLINK_MSG_ID_ROSFLIGHT_PARAM_TABLE_LEN 70
+#define MAVLINK_MSG_ID_ROSFLIGHT_PARAM_TABLE_CRC 43
+#define ROSFLIGHT_PARAM_TABLE_BLOCKS 32
+
+#pragma pack(push, 1)
+struct mavlink_rosflight_param_table_t
+{
+  uint16_t param_count;
+  uint16_t table_checksum;
+  uint16_t block_checksums[ROSFLIGHT_PARAM_TABLE_BLOCKS];
+  uint8_t block_size;
+  uint8_t block_count;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(mavlink_rosflight_param_table_t) == MAVLINK_MSG_ID_ROSFLIGHT_PARAM_TABLE_LEN,
+              "ROSFLIGHT_PARAM_TABLE layout does not match its wire length");
+
+// ROSFLIGHT_PARAM_REQUEST_RANGE asks for PARAM_VALUE messages for a range of parameter IDs. A count of 0 asks for
+// ROSFLIGHT_PARAM_TABLE instead.
+//   uint8_t target_system
+//   uint16_t first_index
+//   uint16_t count
+#define MAVLINK_MSG_ID_ROSFLIGHT_PARAM_REQUEST_RANGE 212
+#define MAVLINK_MSG_ID_ROSFLIGHT_PARAM_REQUEST_RANGE_LEN 5
+#define MAVLINK_MSG_ID_ROSFLIGHT_PARAM_REQUEST_RANGE_CRC 35
+
+#pragma pack(push, 1)
+struct mavlink_rosflight_param_request_range_t
+{
+  uint16_t first_index;
+  uint16_t count;
+  uint8_t target_system;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(mavlink_rosflight_param_request_range_t) == MAVLINK_MSG_ID_ROSFLIGHT_PARAM_REQUEST_RANGE_LEN,
+              "ROSFLIGHT_PARAM_REQUEST_RANGE layout does not match its wire length");
+
+// ROSFLIGHT_LOG carries a log message as its ID and arguments, to be formatted on the host with the table generated
+// from log_messages.h (see scripts/log_decoder.py)
+//   int32_t args[3]      arguments in format order, unused ones are 0
+//   uint16_t log_id      row of the message in log_messages.h
+//   uint8_t severity     MAV_SEVERITY
+//   uint8_t arg_count    number of valid arguments
+#define MAVLINK_MSG_ID_ROSFLIGHT_LOG 213
+#define MAVLINK_MSG_ID_ROSFLIGHT_LOG_LEN 16
+#define MAVLINK_MSG_ID_ROSFLIGHT_LOG_CRC 92
+#define ROSFLIGHT_LOG_ARGS 3
+
+#pragma pack(push, 1)
+struct mavlink_rosflight_log_t
+{
+  int32_t args[ROSFLIGHT_LOG_ARGS];
+  uint16_t log_id;
+  uint8_t severity;
+  uint8_t arg_count;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(mavlink_rosflight_log_t) == MAVLINK_MSG_ID_ROSFLIGHT_LOG_LEN,
+              "ROSFLIGHT_LOG layout does not match its wire length");
+
+// ROSFLIGHT_BLACKBOX_REQUEST asks for the flight log bytes in [offset, offset + length) as ROSFLIGHT_BLACKBOX_DATA
+// messages. Only recorded bytes are sent, so a length of 0 just asks how many there are.
+//   uint32_t offset
+//   uint32_t length
+//   uint8_t target_system
+#define MAVLINK_MSG_ID_ROSFLIGHT_BLACKBOX_REQUEST 214
+#define MAVLINK_MSG_ID_ROSFLIGHT_BLACKBOX_REQUEST_LEN 9
+#define MAVLINK_MSG_ID_ROSFLIGHT_BLACKBOX_REQUEST_CRC 55
+
+#pragma pack(push, 1)
+struct mavlink_rosflight_blackbox_request_t
+{
+  uint32_t offset;
+  uint32_t length;
+  uint8_t target_system;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(mavlink_rosflight_blackbox_request_t) == MAVLINK_MSG_ID_ROSFLIGHT_BLACKBOX_REQUEST_LEN,
+              "ROSFLIGHT_BLACKBOX_REQUEST layout does not match its wire length");
+
+// ROSFLIGHT_BLACKBOX_DATA carries a chunk of the flight log
+//   uint32_t offset       of data[0] in the log
+//   uint32_t used_bytes   recorded so far
+//   uint8_t data[128]
+//   uint8_t count         number of valid bytes in data
+#define MAVLINK_MSG_ID_ROSFLIGHT_BLACKBOX_DATA 215
+#define MAVLINK_MSG_ID_ROSFLIGHT_BLACKBOX_DATA_LEN 137
+#define MAVLINK_MSG_ID_ROSFLIGHT_BLACKBOX_DATA_CRC 127
+#define ROSFLIGHT_BLACKBOX_DATA_BYTES 128
+
+#pragma pack(push, 1)
+struct mavlink_rosflight_blackbox_data_t
+{
+  uint32_t offset;
+  uint32_t used_bytes;
+  uint8_t data[ROSFLIGHT_BLACKBOX_DATA_BYTES];
+  uint8_t count;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(mavlink_rosflight_blackbox_data_t) == MAVLINK_MSG_ID_ROSFLIGHT_BLACKBOX_DATA_LEN,
+              "ROSFLIGHT_BLACKBOX_DATA layout does not match its wire length");
+
+// ROSFLIGHT_OFFBOARD_CONTROL_STAMPED is OFFBOARD_CONTROL with the companion time the setpoint was generated at, so its
+// age can be checked against the timesync estimate of the companion clock
+//   uint64_t time_usec   companion time (us)
+//   float x, y, z, F
+//   uint8_t mode         OFFBOARD_CONTROL_MODE
+//   uint8_t ignore       OFFBOARD_CONTROL_IGNORE bits
+#define MAVLINK_MSG_ID_ROSFLIGHT_OFFBOARD_CONTROL_STAMPED 216
+#define MAVLINK_MSG_ID_ROSFLIGHT_OFFBOARD_CONTROL_STAMPED_LEN 26
+#define MAVLINK_MSG_ID_ROSFLIGHT_OFFBOARD_CONTROL_STAMPED_CRC 32
+
+#pragma pack(push, 1)
+struct mavlink_rosflight_offboard_control_stamped_t
+{
+  uint64_t time_usec;
+  float x;
+  float y;
+  float z;
+  float F;
+  uint8_t mode;
+  uint8_t ignore;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(mavlink_rosflight_offboard_control_stamped_t)
+                  == MAVLINK_MSG_ID_ROSFLIGHT_OFFBOARD_CONTROL_STAMPED_LEN,
+              "ROSFLIGHT_OFFBOARD_CONTROL_STAMPED layout does not match its wire length");
+
+// not in the generated ROSFLIGHT_CMD enum yet
+#define ROSFLIGHT_CMD_BLACKBOX_ERASE 32
 
 namespace rosflight_firmware
 {
+static_assert(CommLinkInterface::IMU_BATCH_MAX_SAMPLES <= ROSFLIGHT_IMU_BATCH_SAMPLES,
+              "ROSFLIGHT_IMU_BATCH cannot carry a full batch");
+static_assert(CommLinkInterface::PARAM_TABLE_MAX_BLOCKS <= ROSFLIGHT_PARAM_TABLE_BLOCKS,
+              "ROSFLIGHT_PARAM_TABLE cannot carry every block checksum");
+static_assert(CommLinkInterface::LOG_MAX_ARGS <= ROSFLIGHT_LOG_ARGS, "ROSFLIGHT_LOG cannot carry every argument");
+static_assert(CommLinkInterface::BLACKBOX_DATA_MAX_BYTES <= ROSFLIGHT_BLACKBOX_DATA_BYTES,
+              "ROSFLIGHT_BLACKBOX_DATA cannot carry a whole chunk");
+
+static int16_t quantize(float value, float lsb)
+{
+  float counts = value / lsb;
+  if (counts >= 32767.0f)
+    return INT16_MAX;
+  if (counts <= -32768.0f)
+    return INT16_MIN;
+  return static_cast<int16_t>(counts + (counts >= 0.0f ? 0.5f : -0.5f));
+}
+
+static const uint8_t MESSAGE_CRC_EXTRA[256] = MAVLINK_MESSAGE_CRCS;
+static const uint8_t MESSAGE_LENGTHS[256] = MAVLINK_MESSAGE_LENGTHS;
+
+static uint8_t message_crc_extra(uint32_t msgid)
+{
+  switch (msgid)
+  {
+  case MAVLINK_MSG_ID_ROSFLIGHT_IMU_BATCH:
+    return MAVLINK_MSG_ID_ROSFLIGHT_IMU_BATCH_CRC;
+  case MAVLINK_MSG_ID_ROSFLIGHT_PARAM_TABLE:
+    return MAVLINK_MSG_ID_ROSFLIGHT_PARAM_TABLE_CRC;
+  case MAVLINK_MSG_ID_ROSFLIGHT_PARAM_REQUEST_RANGE:
+    return MAVLINK_MSG_ID_ROSFLIGHT_PARAM_REQUEST_RANGE_CRC;
+  case MAVLINK_MSG_ID_ROSFLIGHT_LOG:
+    return MAVLINK_MSG_ID_ROSFLIGHT_LOG_CRC;
+  case MAVLINK_MSG_ID_ROSFLIGHT_BLACKBOX_REQUEST:
+    return MAVLINK_MSG_ID_ROSFLIGHT_BLACKBOX_REQUEST_CRC;
+  case MAVLINK_MSG_ID_ROSFLIGHT_BLACKBOX_DATA:
+    return MAVLINK_MSG_ID_ROSFLIGHT_BLACKBOX_DATA_CRC;
+  case MAVLINK_MSG_ID_ROSFLIGHT_OFFBOARD_CONTROL_STAMPED:
+    return MAVLINK_MSG_ID_ROSFLIGHT_OFFBOARD_CONTROL_STAMPED_CRC;
+  default:
+    return (msgid <= UINT8_MAX) ? MESSAGE_CRC_EXTRA[msgid] : 0;
+  }
+}
+
+static uint8_t message_length(uint32_t msgid)
+{
+  switch (msgid)
+  {
+  case MAVLINK_MSG_ID_ROSFLIGHT_IMU_BATCH:
+    return MAVLINK_MSG_ID_ROSFLIGHT_IMU_BATCH_LEN;
+  case MAVLINK_MSG_ID_ROSFLIGHT_PARAM_TABLE:
+    return MAVLINK_MSG_ID_ROSFLIGHT_PARAM_TABLE_LEN;
+  case MAVLINK_MSG_ID_ROSFLIGHT_PARAM_REQUEST_RANGE:
+    return MAVLINK_MSG_ID_ROSFLIGHT_PARAM_REQUEST_RANGE_LEN;
+  case MAVLINK_MSG_ID_ROSFLIGHT_LOG:
+    return MAVLINK_MSG_ID_ROSFLIGHT_LOG_LEN;
+  case MAVLINK_MSG_ID_ROSFLIGHT_BLACKBOX_REQUEST:
+    return MAVLINK_MSG_ID_ROSFLIGHT_BLACKBOX_REQUEST_LEN;
+  case MAVLINK_MSG_ID_ROSFLIGHT_BLACKBOX_DATA:
+    return MAVLINK_MSG_ID_ROSFLIGHT_BLACKBOX_DATA_LEN;
+  case MAVLINK_MSG_ID_ROSFLIGHT_OFFBOARD_CONTROL_STAMPED:
+    return MAVLINK_MSG_ID_ROSFLIGHT_OFFBOARD_CONTROL_STAMPED_LEN;
+  default:
+    return (msgid <= UINT8_MAX) ? MESSAGE_LENGTHS[msgid] : 0;
+  }
+}
+
+uint8_t mavlink_message_crc(uint8_t msgid)
+{
+  return message_crc_extra(msgid);
+}
+
+// MAVLink serializes through global hooks, so they forward to the link that was last initialized
+static Mavlink *tx_link = nullptr;
+
+void mavlink_start_uart_send(mavlink_channel_t chan, uint16_t length)
+{
+  (void)chan;
+  if (tx_link != nullptr)
+    tx_link->start_frame(length);
+}
+
+void mavlink_send_uart_bytes(mavlink_channel_t chan, const uint8_t *buf, uint16_t len)
+{
+  (void)chan;
+  if (tx_link != nullptr)
+    tx_link->append_frame(buf, len);
+}
+
+void mavlink_end_uart_send(mavlink_channel_t chan, uint16_t length)
+{
+  (void)chan;
+  if (tx_link != nullptr)
+    tx_link->end_frame(length);
+}
+
 Mavlink::Mavlink(Board &board) : board_(board) {}
 
+Mavlink::~Mavlink()
+{
+  // don't leave the serialization hooks pointing at a link that no longer exists
+  if (tx_link == this)
+    tx_link = nullptr;
+}
+
 void Mavlink::init(uint32_t baud_rate, uint32_t dev)
 {
   board_.serial_init(baud_rate, dev);
+  tx_link = this;
   initialized_ = true;
 }
 
 void Mavlink::receive(void)
 {
-  while (board_.serial_bytes_available())
+  // Parse whatever has arrived a chunk at a time, but no more than RX_BYTES_PER_CALL, so a burst of uplink traffic
+  // is spread over several loops instead of stalling this one. The rest stays in the board's RX buffer.
+  uint8_t chunk[RX_CHUNK_SIZE];
+  size_t budget = RX_BYTES_PER_CALL;
+  while (budget > 0)
   {
-    if (mavlink_parse_char(MAVLINK_COMM_0, board_.serial_read(), &in_buf_, &status_))
-      handle_mavlink_message();
+    size_t len = RX_CHUNK_SIZE;
+    if (budget < len)
+      len = budget;
+    len = board_.serial_read(chunk, len);
+    if (len == 0)
+      break;
+    budget -= len;
+
+    for (size_t i = 0; i < len; i++)
+    {
+      uint8_t c = chunk[i];
+      // Both parsers see every byte. Whichever completes a frame resets the other, which may have locked onto a start
+      // byte inside that frame and would otherwise swallow the frames that follow it.
+      if (mavlink_parse_char(MAVLINK_COMM_0, c, &in_buf_, &status_))
+      {
+        rx2_state_ = Mavlink2ParseState::IDLE;
+        // answer in whichever framing the companion used last
+        mavlink2_ = false;
+        handle_mavlink_message();
+      }
+      else if (parse_mavlink2_char(c))
+      {
+        mavlink_get_channel_status(MAVLINK_COMM_0)->parse_state = MAVLINK_PARSE_STATE_IDLE;
+        mavlink2_ = true;
+        handle_mavlink_message();
+      }
+    }
   }
 }
 
@@ -58,23 +367,20 @@ void Mavlink::send_attitude_quaternion(uint8_t system_id,
                                        const turbomath::Quaternion &attitude,
                                        const turbomath::Vector &angular_velocity)
 {
-  mavlink_message_t msg;
-  mavlink_msg_attitude_quaternion_pack(system_id, compid_, &msg, timestamp_us / 1000, attitude.w, attitude.x,
-                                       attitude.y, attitude.z, angular_velocity.x, angular_velocity.y,
-                                       angular_velocity.z);
-  send_message(msg);
+  begin_send(system_id, compid_);
+  mavlink_msg_attitude_quaternion_send(MAVLINK_COMM_0, timestamp_us / 1000, attitude.w, attitude.x, attitude.y,
+                                       attitude.z, angular_velocity.x, angular_velocity.y, angular_velocity.z);
 }
 
 void Mavlink::send_baro(uint8_t system_id, float altitude, float pressure, float temperature)
 {
-  mavlink_message_t msg;
-  mavlink_msg_small_baro_pack(system_id, compid_, &msg, altitude, pressure, temperature);
-  send_message(msg);
+  begin_send(system_id, compid_);
+  mavlink_msg_small_baro_send(MAVLINK_COMM_0, altitude, pressure, temperature);
 }
 
 void Mavlink::send_command_ack(uint8_t system_id, Command command, bool success)
 {
-  ROSFLIGHT_CMD rosflight_cmd = ROSFLIGHT_CMD_ENUM_END;
+  uint8_t rosflight_cmd = ROSFLIGHT_CMD_ENUM_END;
   switch (command)
   {
   case CommLinkInterface::Command::COMMAND_READ_PARAMS:
@@ -110,27 +416,26 @@ void Mavlink::send_command_ack(uint8_t system_id, Command command, bool success)
   case CommLinkInterface::Command::COMMAND_SEND_VERSION:
     rosflight_cmd = ROSFLIGHT_CMD_SEND_VERSION;
     break;
+  case CommLinkInterface::Command::COMMAND_BLACKBOX_ERASE:
+    rosflight_cmd = ROSFLIGHT_CMD_BLACKBOX_ERASE;
+    break;
   }
 
-  mavlink_message_t msg;
-  mavlink_msg_rosflight_cmd_ack_pack(system_id, compid_, &msg, rosflight_cmd,
+  begin_send(system_id, compid_);
+  mavlink_msg_rosflight_cmd_ack_send(MAVLINK_COMM_0, rosflight_cmd,
                                      (success) ? ROSFLIGHT_CMD_SUCCESS : ROSFLIGHT_CMD_FAILED);
-  send_message(msg);
 }
 
 void Mavlink::send_diff_pressure(uint8_t system_id, float velocity, float pressure, float temperature)
 {
-  mavlink_message_t msg;
-  mavlink_msg_diff_pressure_pack(system_id, compid_, &msg, velocity, pressure, temperature);
-  send_message(msg);
+  begin_send(system_id, compid_);
+  mavlink_msg_diff_pressure_send(MAVLINK_COMM_0, velocity, pressure, temperature);
 }
 
 void Mavlink::send_heartbeat(uint8_t system_id, bool fixed_wing)
 {
-  mavlink_message_t msg;
-  mavlink_msg_heartbeat_pack(system_id, compid_, &msg, fixed_wing ? MAV_TYPE_FIXED_WING : MAV_TYPE_QUADROTOR, 0, 0, 0,
-                             0);
-  send_message(msg);
+  begin_send(system_id, compid_);
+  mavlink_msg_heartbeat_send(MAVLINK_COMM_0, fixed_wing ? MAV_TYPE_FIXED_WING : MAV_TYPE_QUADROTOR, 0, 0, 0, 0);
 }
 
 void Mavlink::send_imu(uint8_t system_id,
@@ -139,24 +444,21 @@ void Mavlink::send_imu(uint8_t system_id,
                        const turbomath::Vector &gyro,
                        float temperature)
 {
-  mavlink_message_t msg;
-  mavlink_msg_small_imu_pack(system_id, compid_, &msg, timestamp_us, accel.x, accel.y, accel.z, gyro.x, gyro.y, gyro.z,
+  begin_send(system_id, compid_);
+  mavlink_msg_small_imu_send(MAVLINK_COMM_0, timestamp_us, accel.x, accel.y, accel.z, gyro.x, gyro.y, gyro.z,
                              temperature);
-  send_message(msg);
 }
 void Mavlink::send_gnss(uint8_t system_id, const GNSSData &data)
 {
-  mavlink_message_t msg;
-  mavlink_msg_rosflight_gnss_pack(system_id, compid_, &msg, data.time_of_week, data.fix_type, data.time, data.nanos,
-                                  data.lat, data.lon, data.height, data.vel_n, data.vel_e, data.vel_d, data.h_acc,
-                                  data.v_acc, data.ecef.x, data.ecef.y, data.ecef.z, data.ecef.p_acc, data.ecef.vx,
-                                  data.ecef.vy, data.ecef.vz, data.ecef.s_acc, data.rosflight_timestamp);
-  send_message(msg);
+  begin_send(system_id, compid_);
+  mavlink_msg_rosflight_gnss_send(MAVLINK_COMM_0, data.time_of_week, data.fix_type, data.time, data.nanos, data.lat,
+                                  data.lon, data.height, data.vel_n, data.vel_e, data.vel_d, data.h_acc, data.v_acc,
+                                  data.ecef.x, data.ecef.y, data.ecef.z, data.ecef.p_acc, data.ecef.vx, data.ecef.vy,
+                                  data.ecef.vz, data.ecef.s_acc, data.rosflight_timestamp);
 }
 
 void Mavlink::send_gnss_full(uint8_t system_id, const GNSSFull &full)
 {
-  mavlink_message_t msg;
   mavlink_rosflight_gnss_full_t data = {};
   data.time_of_week = full.time_of_week;
   data.year = full.year;
@@ -185,11 +487,15 @@ void Mavlink::send_gnss_full(uint8_t system_id, const GNSSFull &full)
   data.head_acc = full.head_acc;
   data.p_dop = full.p_dop;
   data.rosflight_timestamp = full.rosflight_timestamp;
-  mavlink_msg_rosflight_gnss_full_encode(system_id, compid_, &msg, &data);
-  send_message(msg);
+
+  // Finalize straight from the packed struct rather than passing every field through the send helper
+  begin_send(system_id, compid_);
+  _mav_finalize_message_chan_send(MAVLINK_COMM_0, MAVLINK_MSG_ID_ROSFLIGHT_GNSS_FULL,
+                                  reinterpret_cast<const char *>(&data), MAVLINK_MSG_ID_ROSFLIGHT_GNSS_FULL_LEN,
+                                  MAVLINK_MSG_ID_ROSFLIGHT_GNSS_FULL_CRC);
 }
 
-void Mavlink::send_log_message(uint8_t system_id, LogSeverity severity, const char *text)
+static MAV_SEVERITY mavlink_severity(CommLinkInterface::LogSeverity severity)
 {
   MAV_SEVERITY mavlink_severity = MAV_SEVERITY_ENUM_END;
   switch (severity)
@@ -207,38 +513,57 @@ void Mavlink::send_log_message(uint8_t system_id, LogSeverity severity, const ch
     mavlink_severity = MAV_SEVERITY_CRITICAL;
     break;
   }
+  return mavlink_severity;
+}
+
+void Mavlink::send_log_message(uint8_t system_id, LogSeverity severity, const char *text)
+{
+  begin_send(system_id, compid_);
+  mavlink_msg_statustext_send(MAVLINK_COMM_0, static_cast<uint8_t>(mavlink_severity(severity)), text);
+}
+
+void Mavlink::send_log_record(uint8_t system_id,
+                              LogSeverity severity,
+                              uint16_t message_id,
+                              const int32_t *args,
+                              uint8_t arg_count)
+{
+  if (arg_count > ROSFLIGHT_LOG_ARGS)
+    arg_count = ROSFLIGHT_LOG_ARGS;
 
-  mavlink_message_t msg;
-  mavlink_msg_statustext_pack(system_id, compid_, &msg, static_cast<uint8_t>(mavlink_severity), text);
-  send_message(msg);
+  mavlink_rosflight_log_t record = {};
+  memcpy(record.args, args, arg_count * sizeof(int32_t));
+  record.log_id = message_id;
+  record.severity = static_cast<uint8_t>(mavlink_severity(severity));
+  record.arg_count = arg_count;
+
+  begin_send(system_id, compid_);
+  _mav_finalize_message_chan_send(MAVLINK_COMM_0, MAVLINK_MSG_ID_ROSFLIGHT_LOG, reinterpret_cast<const char *>(&record),
+                                  MAVLINK_MSG_ID_ROSFLIGHT_LOG_LEN, MAVLINK_MSG_ID_ROSFLIGHT_LOG_CRC);
 }
 
 void Mavlink::send_mag(uint8_t system_id, const turbomath::Vector &mag)
 {
-  mavlink_message_t msg;
-  mavlink_msg_small_mag_pack(system_id, compid_, &msg, mag.x, mag.y, mag.z);
-  send_message(msg);
+  begin_send(system_id, compid_);
+  mavlink_msg_small_mag_send(MAVLINK_COMM_0, mag.x, mag.y, mag.z);
 }
 
 void Mavlink::send_named_value_int(uint8_t system_id, uint32_t timestamp_ms, const char *const name, int32_t value)
 {
-  mavlink_message_t msg;
-  mavlink_msg_named_value_int_pack(system_id, compid_, &msg, timestamp_ms, name, value);
-  send_message(msg);
+  begin_send(system_id, compid_);
+  mavlink_msg_named_value_int_send(MAVLINK_COMM_0, timestamp_ms, name, value);
 }
 
 void Mavlink::send_named_value_float(uint8_t system_id, uint32_t timestamp_ms, const char *const name, float value)
 {
-  mavlink_message_t msg;
-  mavlink_msg_named_value_float_pack(system_id, compid_, &msg, timestamp_ms, name, value);
-  send_message(msg);
+  begin_send(system_id, compid_);
+  mavlink_msg_named_value_float_send(MAVLINK_COMM_0, timestamp_ms, name, value);
 }
 
 void Mavlink::send_output_raw(uint8_t system_id, uint32_t timestamp_ms, const float raw_outputs[14])
 {
-  mavlink_message_t msg;
-  mavlink_msg_rosflight_output_raw_pack(system_id, compid_, &msg, timestamp_ms, raw_outputs);
-  send_message(msg);
+  begin_send(system_id, compid_);
+  mavlink_msg_rosflight_output_raw_send(MAVLINK_COMM_0, timestamp_ms, raw_outputs);
 }
 
 void Mavlink::send_param_value_int(uint8_t system_id,
@@ -250,9 +575,8 @@ void Mavlink::send_param_value_int(uint8_t system_id,
   mavlink_param_union_t param;
   param.param_int32 = value;
 
-  mavlink_message_t msg;
-  mavlink_msg_param_value_pack(system_id, 0, &msg, name, param.param_float, MAV_PARAM_TYPE_INT32, param_count, index);
-  send_message(msg);
+  begin_send(system_id, 0);
+  mavlink_msg_param_value_send(MAVLINK_COMM_0, name, param.param_float, MAV_PARAM_TYPE_INT32, param_count, index);
 }
 
 void Mavlink::send_param_value_float(uint8_t system_id,
@@ -261,18 +585,15 @@ void Mavlink::send_param_value_float(uint8_t system_id,
                                      float value,
                                      uint16_t param_count)
 {
-  mavlink_message_t msg;
-  mavlink_msg_param_value_pack(system_id, 0, &msg, name, value, MAV_PARAM_TYPE_REAL32, param_count, index);
-  send_message(msg);
+  begin_send(system_id, 0);
+  mavlink_msg_param_value_send(MAVLINK_COMM_0, name, value, MAV_PARAM_TYPE_REAL32, param_count, index);
 }
 
 void Mavlink::send_rc_raw(uint8_t system_id, uint32_t timestamp_ms, const uint16_t channels[8])
 {
-  mavlink_message_t msg;
-  mavlink_msg_rc_channels_pack(system_id, compid_, &msg, timestamp_ms, 0, channels[0], channels[1], channels[2],
-                               channels[3], channels[4], channels[5], channels[6], channels[7], 0, 0, 0, 0, 0, 0, 0, 0,
-                               0, 0, 0);
-  send_message(msg);
+  begin_send(system_id, compid_);
+  mavlink_msg_rc_channels_send(MAVLINK_COMM_0, timestamp_ms, 0, channels[0], channels[1], channels[2], channels[3],
+                               channels[4], channels[5], channels[6], channels[7], 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
 }
 
 void Mavlink::send_sonar(uint8_t system_id,
@@ -282,9 +603,8 @@ void Mavlink::send_sonar(uint8_t system_id,
                          float min_range)
 {
   (void)type;
-  mavlink_message_t msg;
-  mavlink_msg_small_range_pack(system_id, compid_, &msg, /* TODO */ ROSFLIGHT_RANGE_SONAR, range, max_range, min_range);
-  send_message(msg);
+  begin_send(system_id, compid_);
+  mavlink_msg_small_range_send(MAVLINK_COMM_0, /* TODO */ ROSFLIGHT_RANGE_SONAR, range, max_range, min_range);
 }
 
 void Mavlink::send_status(uint8_t system_id,
@@ -297,48 +617,284 @@ void Mavlink::send_status(uint8_t system_id,
                           int16_t num_errors,
                           int16_t loop_time_us)
 {
-  mavlink_message_t msg;
-  mavlink_msg_rosflight_status_pack(system_id, compid_, &msg, armed, failsafe, rc_override, offboard, error_code,
-                                    control_mode, num_errors, loop_time_us);
-  send_message(msg);
+  begin_send(system_id, compid_);
+  mavlink_msg_rosflight_status_send(MAVLINK_COMM_0, armed, failsafe, rc_override, offboard, error_code, control_mode,
+                                    num_errors, loop_time_us);
 }
 
 void Mavlink::send_timesync(uint8_t system_id, int64_t tc1, int64_t ts1)
 {
-  mavlink_message_t msg;
-  mavlink_msg_timesync_pack(system_id, compid_, &msg, tc1, ts1);
-  send_message(msg);
+  begin_send(system_id, compid_);
+  mavlink_msg_timesync_send(MAVLINK_COMM_0, tc1, ts1);
 }
 
 void Mavlink::send_version(uint8_t system_id, const char *const version)
 {
-  mavlink_message_t msg;
-  mavlink_msg_rosflight_version_pack(system_id, compid_, &msg, version);
-  send_message(msg);
+  begin_send(system_id, compid_);
+  mavlink_msg_rosflight_version_send(MAVLINK_COMM_0, version);
 }
 void Mavlink::send_error_data(uint8_t system_id, const StateManager::BackupData &error_data)
 {
-  mavlink_message_t msg;
   bool rearm = (error_data.arm_flag == StateManager::BackupData::ARM_MAGIC);
-  mavlink_msg_rosflight_hard_error_pack(system_id, compid_, &msg, error_data.error_code, error_data.debug.pc,
+  begin_send(system_id, compid_);
+  mavlink_msg_rosflight_hard_error_send(MAVLINK_COMM_0, error_data.error_code, error_data.debug.pc,
                                         error_data.reset_count, rearm);
-  send_message(msg);
 }
 void Mavlink::send_battery_status(uint8_t system_id, float voltage, float current)
 {
-  mavlink_message_t msg;
-  mavlink_msg_rosflight_battery_status_pack(system_id, compid_, &msg, voltage, current);
-  send_message(msg);
+  begin_send(system_id, compid_);
+  mavlink_msg_rosflight_battery_status_send(MAVLINK_COMM_0, voltage, current);
 }
 
-void Mavlink::send_message(const mavlink_message_t &msg)
+void Mavlink::send_imu_batch(uint8_t system_id, const Sensors::ImuSample *samples, uint8_t count)
 {
-  if (initialized_)
+  if (count == 0)
+    return;
+  if (count > ROSFLIGHT_IMU_BATCH_SAMPLES)
+    count = ROSFLIGHT_IMU_BATCH_SAMPLES;
+
+  mavlink_rosflight_imu_batch_t batch = {};
+  batch.time_usec = samples[0].time_us;
+  batch.count = count;
+  for (uint8_t i = 0; i < count; i++)
   {
-    uint8_t data[MAVLINK_MAX_PACKET_LEN];
-    uint16_t len = mavlink_msg_to_send_buffer(data, &msg);
-    board_.serial_write(data, len);
+    if (i > 0)
+    {
+      uint64_t dt_us = samples[i].time_us - samples[i - 1].time_us;
+      batch.dt_us[i] = static_cast<uint16_t>((dt_us > UINT16_MAX) ? UINT16_MAX : dt_us);
+    }
+    batch.accel[3 * i + 0] = quantize(samples[i].accel.x, ROSFLIGHT_IMU_BATCH_ACCEL_LSB);
+    batch.accel[3 * i + 1] = quantize(samples[i].accel.y, ROSFLIGHT_IMU_BATCH_ACCEL_LSB);
+    batch.accel[3 * i + 2] = quantize(samples[i].accel.z, ROSFLIGHT_IMU_BATCH_ACCEL_LSB);
+    batch.gyro[3 * i + 0] = quantize(samples[i].gyro.x, ROSFLIGHT_IMU_BATCH_GYRO_LSB);
+    batch.gyro[3 * i + 1] = quantize(samples[i].gyro.y, ROSFLIGHT_IMU_BATCH_GYRO_LSB);
+    batch.gyro[3 * i + 2] = quantize(samples[i].gyro.z, ROSFLIGHT_IMU_BATCH_GYRO_LSB);
   }
+
+  begin_send(system_id, compid_);
+  _mav_finalize_message_chan_send(MAVLINK_COMM_0, MAVLINK_MSG_ID_ROSFLIGHT_IMU_BATCH,
+                                  reinterpret_cast<const char *>(&batch), MAVLINK_MSG_ID_ROSFLIGHT_IMU_BATCH_LEN,
+                                  MAVLINK_MSG_ID_ROSFLIGHT_IMU_BATCH_CRC);
+}
+
+void Mavlink::send_param_table(uint8_t system_id,
+                               uint16_t param_count,
+                               uint16_t table_checksum,
+                               const uint16_t *block_checksums,
+                               uint8_t block_count)
+{
+  if (block_count > ROSFLIGHT_PARAM_TABLE_BLOCKS)
+    block_count = ROSFLIGHT_PARAM_TABLE_BLOCKS;
+
+  mavlink_rosflight_param_table_t table = {};
+  table.param_count = param_count;
+  table.table_checksum = table_checksum;
+  memcpy(table.block_checksums, block_checksums, block_count * sizeof(uint16_t));
+  table.block_size = CommLinkInterface::PARAM_TABLE_BLOCK_SIZE;
+  table.block_count = block_count;
+
+  begin_send(system_id, compid_);
+  _mav_finalize_message_chan_send(MAVLINK_COMM_0, MAVLINK_MSG_ID_ROSFLIGHT_PARAM_TABLE,
+                                  reinterpret_cast<const char *>(&table), MAVLINK_MSG_ID_ROSFLIGHT_PARAM_TABLE_LEN,
+                                  MAVLINK_MSG_ID_ROSFLIGHT_PARAM_TABLE_CRC);
+}
+
+void Mavlink::send_blackbox_data(uint8_t system_id,
+                                 uint32_t offset,
+                                 uint32_t used_bytes,
+                                 const uint8_t *data,
+                                 uint8_t count)
+{
+  if (count > ROSFLIGHT_BLACKBOX_DATA_BYTES)
+    count = ROSFLIGHT_BLACKBOX_DATA_BYTES;
+
+  mavlink_rosflight_blackbox_data_t chunk = {};
+  chunk.offset = offset;
+  chunk.used_bytes = used_bytes;
+  memcpy(chunk.data, data, count);
+  chunk.count = count;
+
+  begin_send(system_id, compid_);
+  _mav_finalize_message_chan_send(MAVLINK_COMM_0, MAVLINK_MSG_ID_ROSFLIGHT_BLACKBOX_DATA,
+                                  reinterpret_cast<const char *>(&chunk), MAVLINK_MSG_ID_ROSFLIGHT_BLACKBOX_DATA_LEN,
+                                  MAVLINK_MSG_ID_ROSFLIGHT_BLACKBOX_DATA_CRC);
+}
+
+void Mavlink::begin_send(uint8_t system_id, uint8_t component_id)
+{
+  mavlink_system.sysid = system_id;
+  mavlink_system.compid = component_id;
+}
+
+void Mavlink::start_frame(uint16_t length)
+{
+  // The library always emits a MAVLink 1 frame. For MAVLink 2 it is written MAVLINK2_EXTRA_HEADER_LEN bytes in,
+  // which puts the payload exactly where the longer MAVLink 2 header ends, so end_frame() can reframe in place.
+  tx_len_ = 0;
+  if (mavlink2_)
+    tx_len_ = MAVLINK2_EXTRA_HEADER_LEN;
+  tx_frame_len_ = static_cast<uint16_t>(length + tx_len_);
+  tx_frame_ = nullptr;
+  tx_reserved_ = false;
+  if (!initialized_)
+    return;
+
+  tx_frame_ = board_.serial_reserve(tx_frame_len_);
+  if (tx_frame_ != nullptr)
+    tx_reserved_ = true;
+  else if (tx_frame_len_ <= sizeof(tx_buf_))
+    tx_frame_ = tx_buf_;
+}
+
+void Mavlink::append_frame(const uint8_t *buf, uint16_t len)
+{
+  if (tx_frame_ == nullptr || tx_len_ + len > tx_frame_len_)
+    return;
+  memcpy(tx_frame_ + tx_len_, buf, len);
+  tx_len_ = static_cast<uint16_t>(tx_len_ + len);
+}
+
+void Mavlink::end_frame(uint16_t length)
+{
+  // a frame that did not come out at the announced length is dropped rather than sent truncated
+  uint16_t send_len = 0;
+  if (tx_frame_ != nullptr && tx_len_ == tx_frame_len_)
+  {
+    if (tx_frame_len_ == length)
+      send_len = length;
+    else if (tx_frame_len_ == length + MAVLINK2_EXTRA_HEADER_LEN)
+      send_len = reframe_mavlink2(tx_frame_);
+  }
+
+  if (tx_reserved_)
+    board_.serial_commit(send_len);
+  else if (tx_frame_ != nullptr && send_len > 0)
+    board_.serial_write(tx_frame_, send_len);
+  if (tx_frame_ != nullptr)
+    tx_byte_count_ += send_len;
+
+  tx_frame_ = nullptr;
+  tx_reserved_ = false;
+}
+
+uint16_t Mavlink::reframe_mavlink2(uint8_t *frame)
+{
+  // pull the fields out of the MAVLink 1 header before the MAVLink 2 header overwrites it
+  const uint8_t *v1_header = frame + MAVLINK2_EXTRA_HEADER_LEN;
+  uint8_t payload_len = v1_header[1];
+  uint8_t seq = v1_header[2];
+  uint8_t sysid = v1_header[3];
+  uint8_t compid = v1_header[4];
+  uint8_t msgid = v1_header[5];
+
+  // trailing zero bytes are implied by the receiver, but at least one payload byte is always sent
+  const uint8_t *payload = frame + MAVLINK2_HEADER_LEN;
+  while (payload_len > 1 && payload[payload_len - 1] == 0)
+    payload_len--;
+
+  frame[0] = MAVLINK2_STX;
+  frame[1] = payload_len;
+  frame[2] = 0; // incompatibility flags
+  frame[3] = 0; // compatibility flags
+  frame[4] = seq;
+  frame[5] = sysid;
+  frame[6] = compid;
+  frame[7] = msgid; // 24-bit message ID, little endian
+  frame[8] = 0;
+  frame[9] = 0;
+
+  uint16_t crc = mavlink2_crc(frame + 1, msgid, payload_len);
+  frame[MAVLINK2_HEADER_LEN + payload_len] = static_cast<uint8_t>(crc & 0xFF);
+  frame[MAVLINK2_HEADER_LEN + payload_len + 1] = static_cast<uint8_t>(crc >> 8);
+  return static_cast<uint16_t>(MAVLINK2_HEADER_LEN + payload_len + MAVLINK_NUM_CHECKSUM_BYTES);
+}
+
+uint16_t Mavlink::mavlink2_crc(const uint8_t *header, uint32_t msgid, uint8_t payload_len)
+{
+  // covers the header after the start byte and the payload, which directly follows it
+  uint16_t crc;
+  crc_init(&crc);
+  crc_accumulate_buffer(&crc, reinterpret_cast<const char *>(header),
+                        static_cast<uint16_t>(MAVLINK2_HEADER_LEN - 1 + payload_len));
+  crc_accumulate(message_crc_extra(msgid), &crc);
+  return crc;
+}
+
+bool Mavlink::parse_mavlink2_char(uint8_t c)
+{
+  switch (rx2_state_)
+  {
+  case Mavlink2ParseState::IDLE:
+    if (c == MAVLINK2_STX)
+    {
+      rx2_index_ = 0;
+      rx2_state_ = Mavlink2ParseState::HEADER;
+    }
+    break;
+  case Mavlink2ParseState::HEADER:
+    rx2_buf_[rx2_index_++] = c;
+    if (rx2_index_ == MAVLINK2_HEADER_LEN - 1)
+      rx2_state_ = (rx2_buf_[0] > 0) ? Mavlink2ParseState::PAYLOAD : Mavlink2ParseState::CRC;
+    break;
+  case Mavlink2ParseState::PAYLOAD:
+    rx2_buf_[rx2_index_++] = c;
+    if (rx2_index_ == MAVLINK2_HEADER_LEN - 1 + rx2_buf_[0])
+      rx2_state_ = Mavlink2ParseState::CRC;
+    break;
+  case Mavlink2ParseState::CRC:
+    rx2_buf_[rx2_index_++] = c;
+    if (rx2_index_ == MAVLINK2_HEADER_LEN - 1 + rx2_buf_[0] + MAVLINK_NUM_CHECKSUM_BYTES)
+    {
+      rx2_state_ = Mavlink2ParseState::IDLE;
+      if (rx2_buf_[1] & MAVLINK2_IFLAG_SIGNED)
+      {
+        // signatures are not checked, just skipped
+        rx2_signature_bytes_ = MAVLINK2_SIGNATURE_LEN;
+        rx2_state_ = Mavlink2ParseState::SIGNATURE;
+      }
+      else
+        return handle_mavlink2_frame();
+    }
+    break;
+  case Mavlink2ParseState::SIGNATURE:
+    if (--rx2_signature_bytes_ == 0)
+    {
+      rx2_state_ = Mavlink2ParseState::IDLE;
+      return handle_mavlink2_frame();
+    }
+    break;
+  }
+  return false;
+}
+
+bool Mavlink::handle_mavlink2_frame()
+{
+  // rx2_buf_ holds the header without its start byte, the payload and the checksum
+  uint8_t payload_len = rx2_buf_[0];
+  uint32_t msgid = static_cast<uint32_t>(rx2_buf_[6]) | (static_cast<uint32_t>(rx2_buf_[7]) << 8)
+                   | (static_cast<uint32_t>(rx2_buf_[8]) << 16);
+  if ((rx2_buf_[1] & ~MAVLINK2_IFLAG_SIGNED) != 0 || msgid > UINT8_MAX)
+    return false; // unknown incompatibility flags, or an ID the MAVLink 1 dialect cannot represent
+
+  uint16_t crc = mavlink2_crc(rx2_buf_, msgid, payload_len);
+  const uint8_t *ck = rx2_buf_ + MAVLINK2_HEADER_LEN - 1 + payload_len;
+  if (ck[0] != (crc & 0xFF) || ck[1] != (crc >> 8))
+    return false;
+
+  // hand it to the MAVLink 1 decoders with the truncated zeros put back
+  uint8_t full_len = message_length(msgid);
+  if (payload_len > full_len)
+    full_len = payload_len;
+  char *payload = _MAV_PAYLOAD_NON_CONST(&in_buf_);
+  memset(payload, 0, full_len);
+  memcpy(payload, rx2_buf_ + MAVLINK2_HEADER_LEN - 1, payload_len);
+  in_buf_.magic = MAVLINK_STX;
+  in_buf_.len = full_len;
+  in_buf_.seq = rx2_buf_[3];
+  in_buf_.sysid = rx2_buf_[4];
+  in_buf_.compid = rx2_buf_[5];
+  in_buf_.msgid = static_cast<uint8_t>(msgid);
+  return true;
 }
 
 void Mavlink::handle_msg_param_request_list(const mavlink_message_t *const msg)
@@ -359,6 +915,26 @@ void Mavlink::handle_msg_param_request_read(const mavlink_message_t *const msg)
     listener_->param_request_read_callback(read.target_system, read.param_id, read.param_index);
 }
 
+void Mavlink::handle_msg_param_request_range(const mavlink_message_t *const msg)
+{
+  mavlink_rosflight_param_request_range_t range = {};
+  size_t len = (msg->len < sizeof(range)) ? msg->len : sizeof(range);
+  memcpy(&range, _MAV_PAYLOAD(msg), len);
+
+  if (listener_ != nullptr)
+    listener_->param_request_range_callback(range.target_system, range.first_index, range.count);
+}
+
+void Mavlink::handle_msg_blackbox_request(const mavlink_message_t *const msg)
+{
+  mavlink_rosflight_blackbox_request_t request = {};
+  size_t len = (msg->len < sizeof(request)) ? msg->len : sizeof(request);
+  memcpy(&request, _MAV_PAYLOAD(msg), len);
+
+  if (listener_ != nullptr)
+    listener_->blackbox_request_callback(request.target_system, request.offset, request.length);
+}
+
 void Mavlink::handle_msg_param_set(const mavlink_message_t *const msg)
 {
   mavlink_param_set_t set;
@@ -425,10 +1001,12 @@ void Mavlink::handle_msg_rosflight_cmd(const mavlink_message_t *const msg)
   case ROSFLIGHT_CMD_SEND_VERSION:
     command = CommLinkInterface::Command::COMMAND_SEND_VERSION;
     break;
+  case ROSFLIGHT_CMD_BLACKBOX_ERASE:
+    command = CommLinkInterface::Command::COMMAND_BLACKBOX_ERASE;
+    break;
   default: // unsupported command; report failure then return without calling command callback
-    mavlink_message_t out_msg;
-    mavlink_msg_rosflight_cmd_ack_pack(msg->sysid, compid_, &out_msg, cmd.command, ROSFLIGHT_CMD_FAILED);
-    send_message(out_msg);
+    begin_send(msg->sysid, compid_);
+    mavlink_msg_rosflight_cmd_ack_send(MAVLINK_COMM_0, cmd.command, ROSFLIGHT_CMD_FAILED);
     // log(LogSeverity::LOG_ERROR, "Unsupported ROSFLIGHT CMD %d", command);
     return;
   }
@@ -485,7 +1063,27 @@ void Mavlink::handle_msg_offboard_control(const mavlink_message_t *const msg)
 {
   mavlink_offboard_control_t ctrl;
   mavlink_msg_offboard_control_decode(msg, &ctrl);
+  handle_offboard_control(ctrl, 0);
+}
+
+void Mavlink::handle_msg_offboard_control_stamped(const mavlink_message_t *const msg)
+{
+  mavlink_rosflight_offboard_control_stamped_t stamped = {};
+  size_t len = (msg->len < sizeof(stamped)) ? msg->len : sizeof(stamped);
+  memcpy(&stamped, _MAV_PAYLOAD(msg), len);
+
+  mavlink_offboard_control_t ctrl;
+  ctrl.mode = stamped.mode;
+  ctrl.ignore = stamped.ignore;
+  ctrl.x = stamped.x;
+  ctrl.y = stamped.y;
+  ctrl.z = stamped.z;
+  ctrl.F = stamped.F;
+  handle_offboard_control(ctrl, stamped.time_usec);
+}
 
+void Mavlink::handle_offboard_control(const mavlink_offboard_control_t &ctrl, uint64_t stamp_us)
+{
   CommLinkInterface::OffboardControl control;
   switch (ctrl.mode)
   {
@@ -512,6 +1110,7 @@ void Mavlink::handle_msg_offboard_control(const mavlink_message_t *const msg)
   control.y.valid = !(ctrl.ignore & IGNORE_VALUE2);
   control.z.valid = !(ctrl.ignore & IGNORE_VALUE3);
   control.F.valid = !(ctrl.ignore & IGNORE_VALUE4);
+  control.stamp_us = stamp_us;
 
   if (listener_ != nullptr)
     listener_->offboard_control_callback(control);
@@ -548,6 +1147,9 @@ void Mavlink::handle_mavlink_message()
   case MAVLINK_MSG_ID_OFFBOARD_CONTROL:
     handle_msg_offboard_control(&in_buf_);
     break;
+  case MAVLINK_MSG_ID_ROSFLIGHT_OFFBOARD_CONTROL_STAMPED:
+    handle_msg_offboard_control_stamped(&in_buf_);
+    break;
   case MAVLINK_MSG_ID_PARAM_REQUEST_LIST:
     handle_msg_param_request_list(&in_buf_);
     break;
@@ -557,6 +1159,12 @@ void Mavlink::handle_mavlink_message()
   case MAVLINK_MSG_ID_PARAM_SET:
     handle_msg_param_set(&in_buf_);
     break;
+  case MAVLINK_MSG_ID_ROSFLIGHT_PARAM_REQUEST_RANGE:
+    handle_msg_param_request_range(&in_buf_);
+    break;
+  case MAVLINK_MSG_ID_ROSFLIGHT_BLACKBOX_REQUEST:
+    handle_msg_blackbox_request(&in_buf_);
+    break;
   case MAVLINK_MSG_ID_ROSFLIGHT_CMD:
     handle_msg_rosflight_cmd(&in_buf_);
     break;
@@ -39,6 +39,29 @@
 #pragma GCC diagnostic ignored "-Wignored-qualifiers"
 #pragma GCC diagnostic ignored "-Wpragmas"
 #pragma GCC diagnostic ignored "-Waddress-of-packed-member"
+#include "v1.0/mavlink_types.h"
+
+// Outgoing messages go through the generated mavlink_msg_*_send() helpers, which serialize the header, payload and
+// CRC through these hooks directly into the board's TX queue instead of packing a mavlink_message_t first
+#define MAVLINK_USE_CONVENIENCE_FUNCTIONS
+#define MAVLINK_START_UART_SEND(chan, length) rosflight_firmware::mavlink_start_uart_send(chan, length)
+#define MAVLINK_SEND_UART_BYTES(chan, buf, len) rosflight_firmware::mavlink_send_uart_bytes(chan, buf, len)
+#define MAVLINK_END_UART_SEND(chan, length) rosflight_firmware::mavlink_end_uart_send(chan, length)
+
+// The parser looks CRC extras up through this hook so it also accepts the rosflight messages that are not part of
+// the generated dialect yet (see mavlink.cpp)
+#define MAVLINK_MESSAGE_CRC(msgid) rosflight_firmware::mavlink_message_crc(msgid)
+
+extern mavlink_system_t mavlink_system;
+
+namespace rosflight_firmware
+{
+void mavlink_start_uart_send(mavlink_channel_t chan, uint16_t length);
+void mavlink_send_uart_bytes(mavlink_channel_t chan, const uint8_t *buf, uint16_t len);
+void mavlink_end_uart_send(mavlink_channel_t chan, uint16_t length);
+uint8_t mavlink_message_crc(uint8_t msgid);
+} // namespace rosflight_firmware
+
 #include "v1.0/rosflight/mavlink.h"
 #pragma GCC diagnostic pop
 
@@ -54,6 +77,7 @@ class Mavlink : public CommLinkInterface
 {
 public:
   Mavlink(Board &board);
+  ~Mavlink();
   void init(uint32_t baud_rate, uint32_t dev) override;
   void receive() override;
 
@@ -106,16 +130,69 @@ public:
   void send_gnss_full(uint8_t system_id, const GNSSFull &full) override;
   void send_error_data(uint8_t system_id, const StateManager::BackupData &error_data) override;
   void send_battery_status(uint8_t system_id, float voltage, float current) override;
+  void send_imu_batch(uint8_t system_id, const Sensors::ImuSample *samples, uint8_t count) override;
+  void send_param_table(uint8_t system_id,
+                        uint16_t param_count,
+                        uint16_t table_checksum,
+                        const uint16_t *block_checksums,
+                        uint8_t block_count) override;
+  void send_log_record(uint8_t system_id,
+                       LogSeverity severity,
+                       uint16_t message_id,
+                       const int32_t *args,
+                       uint8_t arg_count) override;
+  void send_blackbox_data(uint8_t system_id,
+                          uint32_t offset,
+                          uint32_t used_bytes,
+                          const uint8_t *data,
+                          uint8_t count) override;
+
+  inline uint32_t tx_byte_count() const override { return tx_byte_count_; }
 
   inline void set_listener(ListenerInterface *listener) override { listener_ = listener; }
 
 private:
-  void send_message(const mavlink_message_t &msg);
+  friend void mavlink_start_uart_send(mavlink_channel_t chan, uint16_t length);
+  friend void mavlink_send_uart_bytes(mavlink_channel_t chan, const uint8_t *buf, uint16_t len);
+  friend void mavlink_end_uart_send(mavlink_channel_t chan, uint16_t length);
+
+  static constexpr size_t RX_CHUNK_SIZE = 64;
+  static constexpr size_t RX_BYTES_PER_CALL = 512; // about 5 ms of a 921600 baud link
+
+  void begin_send(uint8_t system_id, uint8_t component_id);
+  void start_frame(uint16_t length);
+  void append_frame(const uint8_t *buf, uint16_t len);
+  void end_frame(uint16_t length);
+
+  // MAVLink 2 framing, used for as long as the companion is talking MAVLink 2
+  static constexpr uint8_t MAVLINK2_STX = 0xFD;
+  static constexpr uint8_t MAVLINK2_HEADER_LEN = 10; // including the start byte
+  static constexpr uint8_t MAVLINK2_EXTRA_HEADER_LEN = MAVLINK2_HEADER_LEN - MAVLINK_NUM_HEADER_BYTES;
+  static constexpr uint8_t MAVLINK2_SIGNATURE_LEN = 13;
+  static constexpr uint8_t MAVLINK2_IFLAG_SIGNED = 0x01;
+
+  enum class Mavlink2ParseState
+  {
+    IDLE,
+    HEADER,
+    PAYLOAD,
+    CRC,
+    SIGNATURE
+  };
+
+  uint16_t reframe_mavlink2(uint8_t *frame);
+  uint16_t mavlink2_crc(const uint8_t *header, uint32_t msgid, uint8_t payload_len);
+  bool parse_mavlink2_char(uint8_t c);
+  bool handle_mavlink2_frame();
 
   void handle_msg_param_request_list(const mavlink_message_t *const msg);
   void handle_msg_param_request_read(const mavlink_message_t *const msg);
+  void handle_msg_param_request_range(const mavlink_message_t *const msg);
+  void handle_msg_blackbox_request(const mavlink_message_t *const msg);
   void handle_msg_param_set(const mavlink_message_t *const msg);
   void handle_msg_offboard_control(const mavlink_message_t *const msg);
+  void handle_msg_offboard_control_stamped(const mavlink_message_t *const msg);
+  void handle_offboard_control(const mavlink_offboard_control_t &ctrl, uint64_t stamp_us);
   void handle_msg_external_attitude(const mavlink_message_t *const msg);
   void handle_msg_rosflight_cmd(const mavlink_message_t *const msg);
   void handle_msg_rosflight_aux_cmd(const mavlink_message_t *const msg);
@@ -130,6 +207,19 @@ private:
   mavlink_status_t status_;
   bool initialized_ = false;
 
+  uint8_t *tx_frame_ = nullptr; // where the frame in progress is being serialized
+  bool tx_reserved_ = false;    // whether tx_frame_ points into the board's TX queue or at tx_buf_
+  uint16_t tx_len_ = 0;
+  uint16_t tx_frame_len_ = 0;
+  uint32_t tx_byte_count_ = 0;
+  uint8_t tx_buf_[MAVLINK_MAX_PACKET_LEN + MAVLINK2_EXTRA_HEADER_LEN];
+
+  bool mavlink2_ = false;
+  Mavlink2ParseState rx2_state_ = Mavlink2ParseState::IDLE;
+  uint16_t rx2_index_ = 0;
+  uint8_t rx2_signature_bytes_ = 0;
+  uint8_t rx2_buf_[MAVLINK2_HEADER_LEN - 1 + MAVLINK_MAX_PAYLOAD_LEN + MAVLINK_NUM_CHECKSUM_BYTES];
+
   ListenerInterface *listener_ = nullptr;
 };
 
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2017, James Jackson and Daniel Koch, BYU MAGICC Lab
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSFLIGHT_FIRMWARE_BLACKBOX_H
+#define ROSFLIGHT_FIRMWARE_BLACKBOX_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rosflight_firmware
+{
+class ROSflight;
+
+// Flight recorder. While armed, every BLACKBOX_DIV-th control loop is encoded as a frame of the fields selected by
+// BLACKBOX_FIELDS and appended to one of two page buffers. A full page is handed to the board's log storage, which
+// writes it in the background while the other page fills, so the control loop never waits on flash.
+//
+// Every page is decodable on its own (see scripts/blackbox_decoder.py):
+//   page_header_t
+//   'I' frame: time_us as a varint, then every value as a zigzag varint
+//   'P' frames: time since the previous frame (us) as a varint, then every value's change as a zigzag varint
+// Values are fixed point, in the order and units listed with the field bits. The rest of the page is 0xFF.
+class Blackbox
+{
+public:
+  enum : uint8_t
+  {
+    FIELD_IMU = 0x01,      // accel x, y, z (1e-3 m/s^2), gyro x, y, z (1e-4 rad/s)
+    FIELD_ATTITUDE = 0x02, // estimator quaternion w, x, y, z (1e-4), angular velocity x, y, z (1e-4 rad/s)
+    FIELD_CONTROL = 0x04,  // controller output x, y, z, F (1e-4)
+    FIELD_OUTPUTS = 0x08,  // mixer outputs 0 to 13 (1e-4)
+    FIELD_RC = 0x10,       // RC sticks x, y, z, F (1e-4)
+    FIELD_TIMING = 0x20,   // control loop time (us)
+    FIELDS_ALL = 0x3F
+  };
+
+  static constexpr size_t PAGE_SIZE = 256;
+  static constexpr uint8_t FORMAT_VERSION = 1;
+  static constexpr uint8_t FRAME_KEY = 'I';
+  static constexpr uint8_t FRAME_DELTA = 'P';
+
+  typedef struct
+  {
+    uint16_t session; // counts up from 0 after an erase, so 0xFFFF is an unwritten page
+    uint16_t length;  // bytes of frames that follow the header
+    uint8_t version;  // FORMAT_VERSION
+    uint8_t fields;   // BLACKBOX_FIELDS when the session started
+    uint16_t reserved;
+  } page_header_t;
+
+  Blackbox(ROSflight &rf);
+
+  void init();
+
+  /**
+   * @brief Records a frame if the aircraft is armed and one is due. Called after the mixer in every control loop.
+   */
+  void record();
+
+  /**
+   * @brief Starts and ends sessions with arming, and hands full pages to the board. Called once per main loop.
+   */
+  void run();
+
+  /**
+   * @brief Starts erasing the log storage
+   * @return False if the board has no log storage or the recorder is busy with it
+   */
+  bool erase();
+
+  /**
+   * @brief Reads back recorded pages
+   * @return False while recording or writing, or if the range goes past used_bytes()
+   */
+  bool read(size_t offset, void *dest, size_t len);
+
+  inline size_t used_bytes() const { return write_offset_; }
+  inline bool recording() const { return recording_; }
+  inline uint32_t frames_recorded() const { return frames_recorded_; }
+  inline uint32_t frames_dropped() const { return frames_dropped_; }
+
+private:
+  static constexpr uint8_t MAX_VALUES = 6 + 7 + 4 + 14 + 4 + 1;
+  static constexpr size_t MAX_FRAME_SIZE = 1 + 10 + 5 * MAX_VALUES; // type, time varint, value varints
+  static_assert(sizeof(page_header_t) + MAX_FRAME_SIZE <= PAGE_SIZE, "a frame must fit in an empty page");
+
+  ROSflight &RF_;
+
+  size_t storage_size_ = 0; // whole pages only, 0 if the board has no log storage
+  size_t write_offset_ = 0; // where the next page goes
+  uint16_t session_ = 0;
+
+  bool recording_ = false;
+  bool full_ = false;
+  uint8_t fields_ = 0;
+  uint16_t divider_ = 1;
+  uint16_t loops_until_frame_ = 0;
+  uint32_t frames_recorded_ = 0;
+  uint32_t frames_dropped_ = 0;
+
+  // Double buffer: pages_[filling_] takes frames while the other one may be queued for or being written to storage.
+  // Pages are filled and written in alternation.
+  static constexpr uint8_t NO_PAGE = 0xFF;
+  uint8_t pages_[2][PAGE_SIZE];
+  size_t page_length_[2] = {0, 0}; // frame bytes in each page
+  bool page_queued_[2] = {false, false};
+  uint8_t filling_ = NO_PAGE;
+  uint8_t next_fill_ = 0;
+  uint8_t write_page_ = 0;
+  bool writing_ = false; // pages_[write_page_] is being written
+
+  int32_t previous_values_[MAX_VALUES];
+  uint64_t previous_time_us_ = 0;
+
+  void start_session();
+  void end_session();
+  size_t find_end();
+  uint8_t collect_values(int32_t *values);
+  size_t encode_frame(uint8_t *dest, bool key, uint64_t time_us, const int32_t *values, uint8_t count) const;
+  bool next_page();
+  void close_page();
+};
+
+} // namespace rosflight_firmware
+
+#endif // ROSFLIGHT_FIRMWARE_BLACKBOX_H
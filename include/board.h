@@ -32,6 +32,7 @@
 #ifndef ROSFLIGHT_FIRMWARE_BOARD_H
 #define ROSFLIGHT_FIRMWARE_BOARD_H
 
+#include "mixer.h"
 #include "sensors.h"
 #include "state_manager.h"
 
@@ -62,8 +63,15 @@ public:
   // serial
   virtual void serial_init(uint32_t baud_rate, uint32_t dev) = 0;
   virtual void serial_write(const uint8_t *src, size_t len) = 0;
+  // Reserve len contiguous bytes of the TX queue for the caller to fill in place. Returns nullptr if the board
+  // cannot hand out TX memory directly, in which case the caller must fall back to serial_write(). Only one
+  // reservation may be outstanding; it is sent by serial_commit().
+  virtual uint8_t *serial_reserve(size_t len) = 0;
+  virtual void serial_commit(size_t len) = 0;
   virtual uint16_t serial_bytes_available() = 0;
   virtual uint8_t serial_read() = 0;
+  // Copies up to len received bytes into dest and returns how many were copied, 0 if nothing is waiting
+  virtual size_t serial_read(uint8_t *dest, size_t len) = 0;
   virtual void serial_flush() = 0;
 
   // sensors
@@ -113,13 +121,39 @@ public:
   // PWM
   virtual void pwm_init(uint32_t refresh_rate, uint16_t idle_pwm) = 0;
   virtual void pwm_disable() = 0;
-  virtual void pwm_write(uint8_t channel, float value) = 0;
+  // Writes every output at once so boards can update all timers together. Values are in [0, 1], and only channels
+  // of type Mixer::S or Mixer::M should be written.
+  virtual void pwm_write_all(const float *value, const Mixer::output_type_t *type, uint8_t count) = 0;
+
+  // DShot
+  // channel_mask selects the outputs driven as DShot, the rest stay on PWM. Returns false if unsupported.
+  virtual bool dshot_init(uint16_t bitrate_kbps, bool bidirectional, uint16_t channel_mask) = 0;
+  // Clocks out one frame per DShot channel at the same time; frames for non-DShot channels are ignored
+  virtual void dshot_write(const uint16_t *frames, uint8_t count) = 0;
+  // Raw 21-bit GCR reply to the last frame on a bidirectional channel, false if none was received
+  virtual bool dshot_read_telemetry(uint8_t channel, uint32_t *gcr_frame) = 0;
 
   // non-volatile memory
   virtual void memory_init() = 0;
   virtual bool memory_read(void *dest, size_t len) = 0;
   virtual bool memory_write(const void *src, size_t len) = 0;
 
+  // Parameter journal: two equally sized flash sectors that erase to 0xFF and are programmed in 4-byte words without
+  // erasing first. Boards that don't have them return 0 for the size, and parameters are stored with memory_write().
+  virtual size_t param_journal_sector_size() = 0;
+  virtual bool param_journal_erase(uint8_t sector) = 0;
+  virtual bool param_journal_read(uint8_t sector, size_t offset, void *dest, size_t len) = 0;
+  virtual bool param_journal_program(uint8_t sector, size_t offset, const void *src, size_t len) = 0;
+
+  // Flight log storage: a flash region that erases to 0xFF and is filled sequentially by the blackbox recorder.
+  // Erases and writes only start the operation (by DMA where the hardware allows), so the source buffer must stay
+  // untouched until log_storage_busy() returns false. Boards without log storage return 0 for the size.
+  virtual size_t log_storage_size() = 0;
+  virtual bool log_storage_busy() = 0;
+  virtual bool log_storage_erase() = 0;
+  virtual bool log_storage_write(size_t offset, const void *src, size_t len) = 0;
+  virtual bool log_storage_read(size_t offset, void *dest, size_t len) = 0;
+
   // LEDs
   virtual void led0_on() = 0;
   virtual void led0_off() = 0;
@@ -34,11 +34,9 @@
 
 #include "interface/comm_link.h"
 #include "interface/param_listener.h"
-
-#include "nanoprintf.h"
+#include "timesync.h"
 
 #include <cstdint>
-#include <functional>
 
 namespace rosflight_firmware
 {
@@ -46,7 +44,7 @@ class ROSflight;
 
 class CommManager : public CommLinkInterface::ListenerInterface, public ParamListenerInterface
 {
-private:
+public:
   enum StreamId
   {
     STREAM_ID_HEARTBEAT,
@@ -55,6 +53,7 @@ private:
     STREAM_ID_ATTITUDE,
 
     STREAM_ID_IMU,
+    STREAM_ID_IMU_BATCH,
     STREAM_ID_DIFF_PRESSURE,
     STREAM_ID_BARO,
     STREAM_ID_SONAR,
@@ -66,9 +65,41 @@ private:
     STREAM_ID_GNSS_FULL,
     STREAM_ID_RC_RAW,
     STREAM_ID_LOW_PRIORITY,
+    STREAM_ID_STREAM_STATS,
     STREAM_COUNT
   };
 
+  struct StreamStats
+  {
+    uint32_t requested_period_us; // from the STRM_* parameter
+    uint32_t scheduled_period_us; // after degrading to fit the link budget
+    uint16_t frame_bytes;         // largest encoded size seen for one send
+    float achieved_rate_hz;       // messages actually sent over the last stats window
+    uint32_t sent;
+    uint32_t dropped; // deadlines missed, either by falling behind or for lack of link budget
+  };
+
+  // End-to-end age of stamped offboard commands, from when the companion generated them to when they arrived
+  struct CommandAgeStats
+  {
+    uint32_t count; // commands accepted
+    uint32_t stale; // commands rejected for being older than OFFBOARD_MAX_AGE
+    float mean_ms;
+    float p95_ms; // to the COMMAND_AGE_BIN_US above
+    float max_ms;
+  };
+
+private:
+  // When the link cannot carry every stream, higher priorities are served first and the rest are slowed down
+  enum StreamPriority : uint8_t
+  {
+    PRIORITY_CRITICAL,
+    PRIORITY_HIGH,
+    PRIORITY_NORMAL,
+    PRIORITY_LOW,
+    PRIORITY_COUNT
+  };
+
   enum OffboardControlMode
   {
     MODE_PASS_THROUGH,
@@ -81,7 +112,7 @@ private:
   uint64_t offboard_control_time_;
   ROSflight& RF_;
   CommLinkInterface& comm_link_;
-  uint8_t send_params_index_;
+  uint16_t send_params_index_; // where the next parameter burst resumes its scan
   bool initialized_ = false;
   bool connected_ = false;
 
@@ -92,12 +123,15 @@ private:
     static constexpr int LOG_BUF_SIZE = 25;
     LogMessageBuffer();
 
+    // messages are kept as their ID and arguments, and only formatted when they are sent
     struct LogMessage
     {
-      char msg[LOG_MSG_SIZE];
-      CommLinkInterface::LogSeverity severity;
+      uint16_t id;
+      uint8_t severity;
+      uint8_t arg_count;
+      int32_t args[CommLinkInterface::LOG_MAX_ARGS];
     };
-    void add_message(CommLinkInterface::LogSeverity severity, char msg[LOG_MSG_SIZE]);
+    void add_message(CommLinkInterface::LogSeverity severity, uint16_t id, const int32_t* args, uint8_t arg_count);
     size_t size() const { return length_; }
     bool empty() const { return length_ == 0; }
     bool full() const { return length_ == LOG_BUF_SIZE; }
@@ -118,22 +152,99 @@ private:
   class Stream
   {
   public:
-    Stream(uint32_t period_us, std::function<void(void)> send_function);
+    typedef void (CommManager::*SendFunction)(void);
 
-    void stream(uint64_t now_us);
+    Stream(uint32_t period_us, StreamPriority priority, SendFunction send_function);
+
+    uint32_t advance(uint64_t now_us);
     void set_rate(uint32_t rate_hz);
+    void update_stats(uint64_t window_us);
 
     uint32_t period_us_;
+    uint32_t scheduled_period_us_;
     uint64_t next_time_us_;
-    std::function<void(void)> send_function_;
+    StreamPriority priority_;
+    uint16_t frame_bytes_ = 0;
+    uint32_t sent_ = 0;
+    uint32_t dropped_ = 0;
+    uint32_t window_sent_ = 0;
+    float achieved_rate_hz_ = 0.0f;
+    SendFunction send_function_;
   };
 
+  static constexpr uint32_t MAX_DEGRADED_PERIOD_US = 1000000; // streams are never slowed below 1 Hz
+  static constexpr uint32_t STATS_WINDOW_US = 1000000;
+  static constexpr uint32_t TX_BURST_US = 20000; // how far ahead of the average rate a burst may run
+  static constexpr float MIN_TX_BURST_BYTES = 300.0f;
+
+  uint64_t next_deadline_us_ = 0; // earliest next_time_us_ of any enabled stream
+  float link_budget_bytes_per_s_ = 0.0f;
+  float tx_tokens_ = 0.0f;
+  uint64_t last_stream_time_us_ = 0;
+  uint32_t last_tx_byte_count_ = 0;
+  uint64_t stats_window_start_us_ = 0;
+  uint8_t next_stats_stream_ = 0;
+  uint8_t stream_order_[STREAM_COUNT]; // stream ids sorted by priority
+
+  // Parameter transfers are not a periodic stream: they send whatever link budget the streams leave over, in bursts
+  static constexpr float MIN_PARAM_LINK_SHARE = 0.1f; // even when the streams would take it all
+  static constexpr uint16_t PARAM_PENDING_WORDS = (PARAMS_COUNT + 31) / 32;
+  uint32_t params_pending_[PARAM_PENDING_WORDS] = {};
+  uint16_t num_params_pending_ = 0;
+  bool param_table_requested_ = false;
+  float param_budget_bytes_per_s_ = 0.0f;
+  float param_tokens_ = 0.0f;
+  uint64_t last_param_time_us_ = 0;
+  uint16_t param_frame_bytes_ = 0; // largest encoded size seen for one PARAM_VALUE
+
+  // Flight log downloads share the parameter budget, and only go out once no parameters are pending
+  bool blackbox_requested_ = false;
+  uint32_t blackbox_offset_ = 0; // next byte to send
+  uint32_t blackbox_end_ = 0;
+  uint16_t blackbox_frame_bytes_ = 0; // largest encoded size seen for one chunk
+
+  // The companion clock is estimated from the TIMESYNC requests it sends, and from replies to requests sent once per
+  // TIMESYNC_REQUEST_PERIOD_US with the low priority stream, which also measure the link delay
+  static constexpr uint64_t TIMESYNC_REQUEST_PERIOD_US = 1000000;
+  TimeSync timesync_;
+  uint64_t timesync_request_us_ = 0; // board time of the unanswered request, 0 if none
+  uint64_t next_timesync_request_us_ = 0;
+  bool timesync_locked_ = false;
+  uint32_t timesync_resyncs_ = 0;
+
+  // Ages of stamped offboard commands are collected into a histogram and reported once per COMMAND_AGE_WINDOW_US
+  static constexpr uint64_t COMMAND_AGE_WINDOW_US = 1000000;
+  static constexpr uint32_t COMMAND_AGE_BIN_US = 1000;
+  static constexpr uint8_t COMMAND_AGE_BINS = 64; // the last one also counts anything older
+  uint16_t command_age_histogram_[COMMAND_AGE_BINS] = {};
+  uint32_t command_age_count_ = 0;
+  uint32_t stale_commands_ = 0;
+  uint64_t command_age_sum_us_ = 0;
+  uint32_t command_age_max_us_ = 0;
+  uint64_t command_age_window_end_us_ = 0;
+
+  void send_due_streams(uint64_t time_us);
+  float tx_burst_bytes(float bytes_per_s) const;
+  void update_link_budget();
+  void allocate_stream_bandwidth();
+
   void update_system_id(uint16_t param_id);
 
+  // What a parameter change needs redone
+  enum : uint8_t
+  {
+    UPDATE_SYSTEM_ID = 0x01,
+    UPDATE_STREAM_RATE = 0x02, // of the stream returned through stream_id
+    UPDATE_LINK_BUDGET = 0x04,
+  };
+  uint8_t param_updates(uint16_t param_id, uint8_t* stream_id = nullptr) const;
+
   void param_request_list_callback(uint8_t target_system) override;
   void param_request_read_callback(uint8_t target_system, const char* const param_name, int16_t param_index) override;
   void param_set_int_callback(uint8_t target_system, const char* const param_name, int32_t param_value) override;
   void param_set_float_callback(uint8_t target_system, const char* const param_name, float param_value) override;
+  void param_request_range_callback(uint8_t target_system, uint16_t first_index, uint16_t count) override;
+  void blackbox_request_callback(uint8_t target_system, uint32_t offset, uint32_t length) override;
   void command_callback(CommLinkInterface::Command command) override;
   void timesync_callback(int64_t tc1, int64_t ts1) override;
   void offboard_control_callback(const CommLinkInterface::OffboardControl& control) override;
@@ -145,6 +256,7 @@ private:
   void send_status(void);
   void send_attitude(void);
   void send_imu(void);
+  void send_imu_batch(void);
   void send_output_raw(void);
   void send_rc_raw(void);
   void send_diff_pressure(void);
@@ -155,21 +267,36 @@ private:
   void send_gnss(void);
   void send_gnss_full(void);
   void send_low_priority(void);
+  void send_stream_stats(void);
+  void send_command_age(void);
+  uint64_t telemetry_stamp(uint64_t stamp_us) const;
 
   // Debugging Utils
   void send_named_value_int(const char* const name, int32_t value);
   //    void send_named_command_struct(const char *const name, control_t command_struct);
 
-  void send_next_param(void);
+  void queue_params(uint16_t first, uint16_t count);
+  uint16_t take_pending_param(void);
+  void send_pending_params(uint64_t time_us);
+  void send_param_table(void);
+  bool send_blackbox_data(void);
 
-  Stream streams_[STREAM_COUNT] = {
-      Stream(0, [this] { this->send_heartbeat(); }),      Stream(0, [this] { this->send_status(); }),
-      Stream(0, [this] { this->send_attitude(); }),       Stream(0, [this] { this->send_imu(); }),
-      Stream(0, [this] { this->send_diff_pressure(); }),  Stream(0, [this] { this->send_baro(); }),
-      Stream(0, [this] { this->send_sonar(); }),          Stream(0, [this] { this->send_mag(); }),
-      Stream(0, [this] { this->send_battery_status(); }), Stream(0, [this] { this->send_output_raw(); }),
-      Stream(0, [this] { this->send_gnss(); }),           Stream(0, [this] { this->send_gnss_full(); }),
-      Stream(0, [this] { this->send_rc_raw(); }),         Stream(20000, [this] { this->send_low_priority(); })};
+  Stream streams_[STREAM_COUNT] = {Stream(0, PRIORITY_CRITICAL, &CommManager::send_heartbeat),
+                                   Stream(0, PRIORITY_CRITICAL, &CommManager::send_status),
+                                   Stream(0, PRIORITY_HIGH, &CommManager::send_attitude),
+                                   Stream(0, PRIORITY_HIGH, &CommManager::send_imu),
+                                   Stream(0, PRIORITY_HIGH, &CommManager::send_imu_batch),
+                                   Stream(0, PRIORITY_NORMAL, &CommManager::send_diff_pressure),
+                                   Stream(0, PRIORITY_NORMAL, &CommManager::send_baro),
+                                   Stream(0, PRIORITY_NORMAL, &CommManager::send_sonar),
+                                   Stream(0, PRIORITY_NORMAL, &CommManager::send_mag),
+                                   Stream(0, PRIORITY_NORMAL, &CommManager::send_battery_status),
+                                   Stream(0, PRIORITY_LOW, &CommManager::send_output_raw),
+                                   Stream(0, PRIORITY_LOW, &CommManager::send_gnss),
+                                   Stream(0, PRIORITY_LOW, &CommManager::send_gnss_full),
+                                   Stream(0, PRIORITY_LOW, &CommManager::send_rc_raw),
+                                   Stream(20000, PRIORITY_LOW, &CommManager::send_low_priority),
+                                   Stream(0, PRIORITY_LOW, &CommManager::send_stream_stats)};
 
   // the time of week stamp for the last sent GNSS message, to prevent re-sending
   uint32_t last_sent_gnss_tow_ = 0;
@@ -180,12 +307,29 @@ public:
 
   void init();
   void param_change_callback(uint16_t param_id) override;
+  bool param_is_relevant(uint16_t param_id) const override;
   void receive(void);
   void stream();
   void send_param_value(uint16_t param_id);
+  void queue_param_value(uint16_t param_id);
   void set_streaming_rate(uint8_t stream_id, int16_t param_id);
+  StreamStats stream_stats(uint8_t stream_id) const;
+  float link_budget_bytes_per_s() const { return link_budget_bytes_per_s_; }
+  uint16_t params_pending() const { return num_params_pending_; }
+  size_t logs_pending() const { return log_buffer_.size(); }
+  const TimeSync& timesync() const { return timesync_; }
+  CommandAgeStats command_age_stats() const;
   void update_status();
-  void log(CommLinkInterface::LogSeverity severity, const char* fmt, ...);
+
+  // Logging costs a few stores at the call site. The message is queued by ID with its arguments (integers, as in the
+  // format in log_messages.h) and formatted when it is sent, or on the host when LOG_BINARY is set.
+  template <typename... Args>
+  void log(CommLinkInterface::LogSeverity severity, LogMessageId id, Args... args)
+  {
+    static_assert(sizeof...(Args) <= CommLinkInterface::LOG_MAX_ARGS, "Too many arguments for a log message");
+    const int32_t packed[sizeof...(Args) + 1] = {static_cast<int32_t>(args)..., 0};
+    log_buffer_.add_message(severity, id, packed, static_cast<uint8_t>(sizeof...(Args)));
+  }
 
   void send_parameter_list();
   void send_named_value_float(const char* const name, float value);
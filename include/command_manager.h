@@ -141,6 +141,7 @@ private:
   control_t &failsafe_command_;
 
   void param_change_callback(uint16_t param_id) override;
+  bool param_is_relevant(uint16_t param_id) const override;
   void init_failsafe();
 
   bool do_roll_pitch_yaw_muxing(MuxChannel channel);
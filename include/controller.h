@@ -57,6 +57,19 @@ public:
     float z;
   };
 
+  enum : uint8_t
+  {
+    ATT_CONTROL_EULER = 0,
+    ATT_CONTROL_QUATERNION = 1,
+    ATT_CONTROL_TILT_PRIORITIZED = 2,
+  };
+
+  enum : uint8_t
+  {
+    RATE_CONTROL_PID = 0,
+    RATE_CONTROL_INDI = 1,
+  };
+
   Controller(ROSflight &rf);
 
   inline const Output &output() const { return output_; }
@@ -65,9 +78,14 @@ public:
   void run();
 
   void calculate_equilbrium_torque_from_rc();
+
   void param_change_callback(uint16_t param_id) override;
+  void param_batch_change_callback(const uint16_t *param_ids, uint16_t count) override;
+  bool param_is_relevant(uint16_t param_id) const override;
 
 private:
+  friend class ControllerTest; // test fixture, for the filter and attitude error internals
+
   class PID
   {
   public:
@@ -96,6 +114,10 @@ private:
                                   const Estimator::State &state,
                                   const control_t &command,
                                   bool update_integrators);
+  // Body-frame attitude error (twice the vector part of the error quaternion) for the current attitude control type
+  turbomath::Vector attitude_error(const turbomath::Quaternion &q, float roll_c, float pitch_c) const;
+  void update_indi_filters(float dt, const turbomath::Vector &rate, const turbomath::Vector &torque);
+  float run_indi(float rate, float rate_c, float kp, float g, float omega_dot, float torque, float eq_torque) const;
 
   Output output_;
 
@@ -105,6 +127,24 @@ private:
   PID pitch_rate_;
   PID yaw_rate_;
 
+  uint8_t attitude_control_type_;
+  uint8_t rate_control_type_;
+
+  // Gains read every loop, cached by init()
+  float max_command_;
+  turbomath::Vector eq_torque_;
+  turbomath::Vector rate_kp_;
+  turbomath::Vector indi_g_;
+  float indi_alpha_;
+
+  // INDI state. The angular acceleration and the torque applied by the mixer outputs pass through the same two
+  // first-order stages, so the increment is computed from signals with the same delay. Differentiating the output of
+  // the first rate stage is the same as filtering the angular acceleration with it, so indi_rate_ holds that stage.
+  turbomath::Vector indi_rate_;
+  turbomath::Vector indi_omega_dot_;
+  turbomath::Vector indi_torque_lpf_; // first stage of the torque filter
+  turbomath::Vector indi_torque_;
+
   uint64_t prev_time_us_;
 };
 
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2017, James Jackson and Daniel Koch, BYU MAGICC Lab
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSFLIGHT_FIRMWARE_DSHOT_H
+#define ROSFLIGHT_FIRMWARE_DSHOT_H
+
+#include <cstdbool>
+#include <cstdint>
+
+namespace rosflight_firmware
+{
+enum : uint16_t
+{
+  DSHOT_CMD_MOTOR_STOP = 0,
+  DSHOT_MIN_THROTTLE = 48,
+  DSHOT_MAX_THROTTLE = 2047,
+};
+
+/**
+ * @brief Build a 16-bit DShot frame (11-bit value, telemetry request bit, 4-bit CRC)
+ *
+ * @param value Throttle (48-2047) or command (0-47)
+ * @param telemetry_request Whether to ask the ESC for a telemetry packet
+ * @param bidirectional Use the inverted CRC expected by ESCs running bidirectional DShot
+ * @return uint16_t Frame ready to be clocked out MSB first
+ */
+uint16_t dshot_encode_frame(uint16_t value, bool telemetry_request, bool bidirectional);
+
+/**
+ * @brief Convert a normalized throttle command into a DShot throttle value
+ *
+ * @param throttle Command in [0, 1]; anything at or below zero stops the motor
+ * @return uint16_t DShot value, either DSHOT_CMD_MOTOR_STOP or in [DSHOT_MIN_THROTTLE, DSHOT_MAX_THROTTLE]
+ */
+uint16_t dshot_throttle_to_value(float throttle);
+
+/**
+ * @brief Decode a bidirectional DShot eRPM reply
+ *
+ * @param gcr_frame The 21 bits sampled from the signal line after the ESC pulled it low, MSB first
+ * @param period_us Electrical period in microseconds, 0 if the motor is stopped
+ * @return true if the frame decoded and passed its CRC
+ */
+bool dshot_decode_erpm(uint32_t gcr_frame, uint32_t *period_us);
+
+/**
+ * @brief Convert an electrical period to mechanical RPM
+ *
+ * @param period_us Electrical period in microseconds, as returned by dshot_decode_erpm
+ * @param motor_poles Number of magnet poles in the motor
+ * @return float Mechanical RPM, 0 if the motor is stopped
+ */
+float dshot_period_to_rpm(uint32_t period_us, uint8_t motor_poles);
+
+} // namespace rosflight_firmware
+
+#endif // ROSFLIGHT_FIRMWARE_DSHOT_H
@@ -50,10 +50,7 @@ public:
   struct State
   {
     turbomath::Vector angular_velocity;
-    turbomath::Quaternion attitude;
-    float roll;
-    float pitch;
-    float yaw;
+    turbomath::Quaternion attitude; // Euler angles are extracted from it where they are needed
     uint64_t timestamp_us;
   };
 
@@ -69,6 +66,11 @@ public:
 
   void init();
   void param_change_callback(uint16_t param_id) override;
+  inline bool param_is_relevant(uint16_t param_id) const override
+  {
+    (void)param_id;
+    return false; // parameters are read where they are used
+  }
   void run();
   void reset_state();
   void reset_adaptive_bias();
@@ -43,6 +43,14 @@
 
 namespace rosflight_firmware
 {
+enum LogMessageId : uint16_t
+{
+#define LOG_MESSAGE(id, format) id,
+#include "log_messages.h"
+
+  LOG_MESSAGES_COUNT
+};
+
 class CommLinkInterface
 {
 public:
@@ -66,7 +74,8 @@ public:
     COMMAND_RC_CALIBRATION,
     COMMAND_REBOOT,
     COMMAND_REBOOT_TO_BOOTLOADER,
-    COMMAND_SEND_VERSION
+    COMMAND_SEND_VERSION,
+    COMMAND_BLACKBOX_ERASE
   };
 
   struct OffboardControl
@@ -89,6 +98,7 @@ public:
     Channel y;
     Channel z;
     Channel F;
+    uint64_t stamp_us; // companion time the setpoint was generated at, 0 if the sender did not stamp it
   };
 
   struct AuxCommand
@@ -118,6 +128,8 @@ public:
                                              int16_t param_index) = 0;
     virtual void param_set_int_callback(uint8_t target_system, const char *const param_name, int32_t param_value) = 0;
     virtual void param_set_float_callback(uint8_t target_system, const char *const param_name, float param_value) = 0;
+    virtual void param_request_range_callback(uint8_t target_system, uint16_t first_index, uint16_t count) = 0;
+    virtual void blackbox_request_callback(uint8_t target_system, uint32_t offset, uint32_t length) = 0;
     virtual void command_callback(Command command) = 0;
     virtual void timesync_callback(int64_t tc1, int64_t ts1) = 0;
     virtual void offboard_control_callback(const OffboardControl &control) = 0;
@@ -187,6 +199,38 @@ public:
   virtual void send_error_data(uint8_t system_id, const StateManager::BackupData &error_data) = 0;
   virtual void send_battery_status(uint8_t system_id, float voltage, float current) = 0;
 
+  // most raw IMU samples a single send_imu_batch() call can carry
+  static constexpr uint8_t IMU_BATCH_MAX_SAMPLES = 10;
+  virtual void send_imu_batch(uint8_t system_id, const Sensors::ImuSample *samples, uint8_t count) = 0;
+
+  // summary of the parameter table, with one checksum per PARAM_TABLE_BLOCK_SIZE parameters
+  static constexpr uint8_t PARAM_TABLE_BLOCK_SIZE = 8;
+  static constexpr uint8_t PARAM_TABLE_MAX_BLOCKS = 32;
+  virtual void send_param_table(uint8_t system_id,
+                                uint16_t param_count,
+                                uint16_t table_checksum,
+                                const uint16_t *block_checksums,
+                                uint8_t block_count) = 0;
+
+  // a log message as its ID and integer arguments, for the host to format (see log_messages.h)
+  static constexpr uint8_t LOG_MAX_ARGS = 3;
+  virtual void send_log_record(uint8_t system_id,
+                               LogSeverity severity,
+                               uint16_t message_id,
+                               const int32_t *args,
+                               uint8_t arg_count) = 0;
+
+  // a chunk of the flight log, with the number of bytes recorded so far (see Blackbox)
+  static constexpr uint8_t BLACKBOX_DATA_MAX_BYTES = 128;
+  virtual void send_blackbox_data(uint8_t system_id,
+                                  uint32_t offset,
+                                  uint32_t used_bytes,
+                                  const uint8_t *data,
+                                  uint8_t count) = 0;
+
+  // total number of encoded bytes handed to the serial port so far (wraps)
+  virtual uint32_t tx_byte_count() const = 0;
+
   // register listener
   virtual void set_listener(ListenerInterface *listener) = 0;
 };
@@ -40,6 +40,29 @@ class ParamListenerInterface
 {
 public:
   virtual void param_change_callback(uint16_t param_id) = 0;
+
+  /**
+   * @brief Called once when a parameter transaction commits (see Params::begin_transaction())
+   * @param param_ids The changed parameters this listener is interested in, in ascending order
+   * @param count The number of IDs in param_ids, never zero
+   * The default handles the IDs one at a time; listeners where several parameters feed the same initialization
+   * override it to run that initialization once
+   */
+  virtual void param_batch_change_callback(const uint16_t *param_ids, uint16_t count)
+  {
+    for (uint16_t i = 0; i < count; i++)
+      param_change_callback(param_ids[i]);
+  }
+
+  /**
+   * @brief Whether the listener reacts to changes of a parameter at all
+   * Params asks once per parameter when the listeners are set and never calls a listener about the others
+   */
+  virtual bool param_is_relevant(uint16_t param_id) const
+  {
+    (void)param_id;
+    return true;
+  }
 };
 
 } // namespace rosflight_firmware
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2017, James Jackson and Daniel Koch, BYU MAGICC Lab
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Single source of every log message's ID and format. This file is included wherever a per-message table is needed,
+// after defining the row macro:
+//
+//   LOG_MESSAGE(id, format)
+//
+// Messages are logged by ID with up to CommLinkInterface::LOG_MAX_ARGS integer arguments (%d and %u only), and the
+// text is only formatted when it is sent, or on the host (see scripts/log_decoder.py). IDs are the row numbers, so add
+// new messages at the end to keep logs from older firmware decodable. The row macro is undefined again at the end of
+// this file.
+
+// clang-format off
+LOG_MESSAGE(LOG_MSG_PARAMS_DEFAULTED, "Unable to load parameters; using default values")
+LOG_MESSAGE(LOG_MSG_PARAMS_MIGRATED, "Migrated parameters: %d loaded, %d defaulted, %d dropped")
+LOG_MESSAGE(LOG_MSG_INVALID_MIXER, "Invalid Mixer Choice")
+LOG_MESSAGE(LOG_MSG_INVALID_MOTOR_PROTOCOL, "Invalid motor protocol, using PWM")
+LOG_MESSAGE(LOG_MSG_DSHOT_UNSUPPORTED, "DShot not supported on this board, using PWM")
+LOG_MESSAGE(LOG_MSG_CUSTOM_MIXER_NOT_FINITE, "Custom mixer output %d is not finite")
+LOG_MESSAGE(LOG_MSG_CUSTOM_MIXER_NEGATIVE_THRUST, "Custom mixer motor %d has negative thrust")
+LOG_MESSAGE(LOG_MSG_CUSTOM_MIXER_INVALID_TYPES, "Invalid custom mixer output types")
+LOG_MESSAGE(LOG_MSG_SWITCH_ARM_MAPPED, "ARM switch mapped to RC channel %d")
+LOG_MESSAGE(LOG_MSG_SWITCH_ARM_NOT_MAPPED, "ARM switch not mapped")
+LOG_MESSAGE(LOG_MSG_SWITCH_ATT_OVERRIDE_MAPPED, "ATTITUDE OVERRIDE switch mapped to RC channel %d")
+LOG_MESSAGE(LOG_MSG_SWITCH_ATT_OVERRIDE_NOT_MAPPED, "ATTITUDE OVERRIDE switch not mapped")
+LOG_MESSAGE(LOG_MSG_SWITCH_THROTTLE_OVERRIDE_MAPPED, "THROTTLE OVERRIDE switch mapped to RC channel %d")
+LOG_MESSAGE(LOG_MSG_SWITCH_THROTTLE_OVERRIDE_NOT_MAPPED, "THROTTLE OVERRIDE switch not mapped")
+LOG_MESSAGE(LOG_MSG_SWITCH_ATT_TYPE_MAPPED, "ATTITUDE TYPE switch mapped to RC channel %d")
+LOG_MESSAGE(LOG_MSG_SWITCH_ATT_TYPE_NOT_MAPPED, "ATTITUDE TYPE switch not mapped")
+LOG_MESSAGE(LOG_MSG_GYRO_CAL_MOVEMENT, "Too much movement for gyro cal")
+LOG_MESSAGE(LOG_MSG_IMU_CAL_MOVEMENT, "Too much movement for IMU cal")
+LOG_MESSAGE(LOG_MSG_IMU_CAL_DONE, "IMU offsets captured")
+LOG_MESSAGE(LOG_MSG_LARGE_ACCEL_BIAS, "large accel bias: norm = %d.%d")
+LOG_MESSAGE(LOG_MSG_BARO_CAL_DONE, "Baro Cal successful!")
+LOG_MESSAGE(LOG_MSG_BARO_CAL_MOVEMENT, "Too much movement for barometer cal")
+LOG_MESSAGE(LOG_MSG_AIRSPEED_CAL_DONE, "Airspeed Cal Successful!")
+LOG_MESSAGE(LOG_MSG_AIRSPEED_CAL_MOVEMENT, "Too much movement for diff pressure cal")
+LOG_MESSAGE(LOG_MSG_EQ_TORQUE_CAPTURING, "Capturing equilbrium offsets from RC")
+LOG_MESSAGE(LOG_MSG_EQ_TORQUE_APPLIED, "Equilibrium torques found and applied.")
+LOG_MESSAGE(LOG_MSG_EQ_TORQUE_ZERO_TRIMS, "Please zero out trims on your transmitter")
+LOG_MESSAGE(LOG_MSG_EQ_TORQUE_ARMED, "Cannot perform equilibrium offset calibration while armed")
+LOG_MESSAGE(LOG_MSG_ARM_NEEDS_THROTTLE_OVERRIDE, "RC throttle override must be active to arm")
+LOG_MESSAGE(LOG_MSG_ARM_THROTTLE_HIGH, "Cannot arm with RC throttle high")
+LOG_MESSAGE(LOG_MSG_ARM_INVALID_MIXER, "Unable to arm: Invalid mixer")
+LOG_MESSAGE(LOG_MSG_ARM_IMU_NOT_RESPONDING, "Unable to arm: IMU not responding")
+LOG_MESSAGE(LOG_MSG_ARM_RC_LOST, "Unable to arm: RC signal lost")
+LOG_MESSAGE(LOG_MSG_ARM_UNHEALTHY_ESTIMATOR, "Unable to arm: Unhealthy estimator")
+LOG_MESSAGE(LOG_MSG_ARM_TIME_BACKWARDS, "Unable to arm: Time going backwards")
+LOG_MESSAGE(LOG_MSG_ARM_UNCALIBRATED_IMU, "Unable to arm: IMU not calibrated")
+LOG_MESSAGE(LOG_MSG_ARM_INVALID_FAILSAFE, "Unable to arm: Invalid failsafe setting")
+LOG_MESSAGE(LOG_MSG_HARDFAULT_REARMED, "Rearming after hardfault!!!")
+LOG_MESSAGE(LOG_MSG_HARDFAULT_REARM_FAILED, "Failed to rearm after hardfault!!!")
+LOG_MESSAGE(LOG_MSG_HARDFAULT_RECOVERED, "Recovered from hardfault!!!")
+LOG_MESSAGE(LOG_MSG_BLACKBOX_FULL, "Blackbox full after %d kB, erase it to record again")
+LOG_MESSAGE(LOG_MSG_BLACKBOX_DROPPED, "Blackbox dropped %d of %d frames")
+LOG_MESSAGE(LOG_MSG_BLACKBOX_ERASING, "Erasing blackbox")
+LOG_MESSAGE(LOG_MSG_TIMESYNC_LOCKED, "Companion clock synchronized, skew %d ppm")
+LOG_MESSAGE(LOG_MSG_TIMESYNC_RESYNC, "Companion clock jumped, resynchronizing")
+// clang-format on
+
+#undef LOG_MESSAGE
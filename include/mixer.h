@@ -34,8 +34,11 @@
 
 #include "interface/param_listener.h"
 
+#include <turbomath/turbomath.h>
+
 #include <cstdbool>
 #include <cstdint>
+#include <type_traits>
 
 namespace rosflight_firmware
 {
@@ -46,6 +49,8 @@ class Mixer : public ParamListenerInterface
 public:
   static constexpr uint8_t NUM_TOTAL_OUTPUTS = 14;
   static constexpr uint8_t NUM_MIXER_OUTPUTS = 8;
+  static constexpr uint8_t THRUST_LUT_SIZE = 33;
+  static constexpr float MAX_VOLTAGE_COMPENSATION = 1.5f;
 
   enum
   {
@@ -61,6 +66,7 @@ public:
     TRICOPTER = 9,
     FIXEDWING = 10,
     PASSTHROUGH = 11,
+    CUSTOM = 12,
     NUM_MIXERS,
     INVALID_MIXER = 255
   };
@@ -89,6 +95,8 @@ public:
     float value;
   } aux_channel_t;
 
+  typedef void (*mix_kernel_t)(const mixer_t& mixer, float F, float x, float y, float z, float* out);
+
   typedef struct
   {
     aux_channel_t channel[NUM_TOTAL_OUTPUTS];
@@ -99,108 +107,184 @@ private:
 
   float raw_outputs_[NUM_TOTAL_OUTPUTS];
   float outputs_[NUM_TOTAL_OUTPUTS];
+  float pwm_outputs_[NUM_TOTAL_OUTPUTS];
+  // Thrust each mixer output delivers in controller units, before linearization and voltage compensation
+  float thrust_outputs_[NUM_MIXER_OUTPUTS];
+  output_type_t pwm_output_type_[NUM_TOTAL_OUTPUTS];
   aux_command_t aux_command_;
   output_type_t combined_output_type_[NUM_TOTAL_OUTPUTS];
 
-  void write_motor(uint8_t index, float value);
-  void write_servo(uint8_t index, float value);
-
-  const mixer_t esc_calibration_mixing = {{M, M, M, M, M, M, NONE, NONE},
-                                          {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f}, // F Mix
-                                          {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // X Mix
-                                          {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // X Mix
-                                          {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // X Mix
-                                          490};
-
-  const mixer_t quadcopter_plus_mixing = {{M, M, M, M, NONE, NONE, NONE, NONE}, // output_type
-
-                                          {1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f},   // F Mix
-                                          {0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f},  // X Mix
-                                          {1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f},  // Y Mix
-                                          {1.0f, -1.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // Z Mix
-                                          490};
-
-  const mixer_t quadcopter_x_mixing = {{M, M, M, M, NONE, NONE, NONE, NONE}, // output_type
-
-                                       {1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f},   // F Mix
-                                       {-1.0f, -1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // X Mix
-                                       {1.0f, -1.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // Y Mix
-                                       {1.0f, -1.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // Z Mix
-                                       490};
-
-  const mixer_t hex_plus_mixing = {{M, M, M, M, M, M, M, M}, // output_type
-
-                                   {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f},                       //  F  Mix
-                                   {0.0f, -0.866025f, -0.866025f, 0.0f, 0.866025f, 0.866025f, 0.0f, 0.0f}, //  X  Mix
-                                   {1.0f, 0.5f, -0.5f, -1.0f, -0.5f, 0.5f, 0.0f, 0.0f},                    //  Y  Mix
-                                   {1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 0.0f, 0.0f},                    //  Z  Mix
-                                   490};
-
-  const mixer_t hex_x_mixing = {{M, M, M, M, M, M, M, M}, // output_type
-
-                                {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f},                       //  F  Mix
-                                {-0.5f, -1.0f, -0.5f, 0.5f, 1.0f, 0.5f, 0.0f, 0.0f},                    //  X  Mix
-                                {0.866025f, 0.0f, -0.866025f, -0.866025f, 0.0f, 0.866025f, 0.0f, 0.0f}, //  Y  Mix
-                                {1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 0.0f, 0.0f},                    //  Z  Mix
-                                490};
-
-  const mixer_t octocopter_plus_mixing = {{M, M, M, M, M, M, M, M}, // output_type
-
-                                          {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f},            //  F  Mix
-                                          {0.0f, -0.707f, -1.0f, -0.707f, 0.0f, 0.707f, 1.0f, 0.707f}, //  X  Mix
-                                          {1.0f, 0.707f, 0.0f, -0.707f, -1.0f, -0.707f, 0.0f, 0.707f}, //  Y  Mix
-                                          {1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f},        //  Z  Mix
-                                          490};
+  // Rows of the pseudo-inverse of the mixer's torque columns, used to recover the torque applied by the outputs
+  float torque_inv_x_[NUM_MIXER_OUTPUTS];
+  float torque_inv_y_[NUM_MIXER_OUTPUTS];
+  float torque_inv_z_[NUM_MIXER_OUTPUTS];
 
-  const mixer_t octocopter_x_mixing = {{M, M, M, M, M, M, M, M}, // output_type
+  bool dshot_enabled_;
+  bool dshot_bidirectional_;
+  uint16_t dshot_mask_;
+  uint16_t dshot_frames_[NUM_TOTAL_OUTPUTS];
+  float motor_rpm_[NUM_TOTAL_OUTPUTS];
 
-                                       {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f},            // F Mix
-                                       {-0.414f, -1.0f, -1.0f, -0.414f, 0.414f, 1.0f, 1.0f, 0.414}, // X Mix
-                                       {1.0f, 0.414f, -0.414f, -1.0f, -1.0f, -0.414f, 0.414f, 1.0}, // Y Mix
-                                       {1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f},        // Z Mix
-                                       490};
+  // Motor command needed for each evenly spaced thrust in [0, 1], built from MOTOR_THR_MDL
+  float thrust_lut_[THRUST_LUT_SIZE];
+  float thrust_model_;
 
-  const mixer_t Y6_mixing = {{M, M, M, M, M, M, NONE, NONE}, // output_type
-
-                             {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f},               // F Mix
-                             {-1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f},             // X Mix
-                             {0.667f, 0.667f, -1.333f, -1.333f, 0.667f, 0.667f, 0.0f, 0.0f}, // Y Mix
-                             {1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 0.0f, 0.0f},            // Z Mix
-                             490};
-
-  const mixer_t X8_mixing = {{M, M, M, M, M, M, M, M}, // output_type
-
-                             {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f},     // F Mix
-                             {-1.0f, -1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f, 1.0f}, // X Mix
-                             {1.0f, 1.0f, -1.0f, -1.0f, -1.0f, -1.0f, 1.0f, 1.0f}, // Y Mix
-                             {1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f}, // Z Mix
-                             490};
+  // What a parameter change needs redone, so a batch of changes redoes each part once
+  enum : uint8_t
+  {
+    UPDATE_MIXING = 0x01,
+    UPDATE_CUSTOM_MIXING = 0x02, // only while the custom mixer is selected
+    UPDATE_PWM = 0x04,
+    UPDATE_THRUST_LUT = 0x08,
+  };
+  uint8_t param_updates(uint16_t param_id) const;
+  void apply_param_updates(uint8_t updates);
+
+  void init_torque_inverse();
+  void init_thrust_lut();
+  float voltage_compensation() const;
+  float linearize_thrust(float thrust) const;
+  float motor_thrust(float command) const;
+  bool load_custom_mixer();
+  void mix_scaled(const float F, const float x, const float y, const float z, const float gain);
+  void mix_prioritized(const float F, const float x, const float y, const float z, const float gain);
+  void init_dshot();
+  void update_dshot();
+  void write_motor(uint8_t index, float value);
+  void write_servo(uint8_t index, float value);
 
-  const mixer_t tricopter_mixing = {{M, M, M, S, NONE, NONE, NONE, NONE}, // output_type
+  // The built-in tables are constexpr so they live in flash rather than being copied into every Mixer
+  // clang-format off
+  static constexpr mixer_t esc_calibration_mixing = {{M, M, M, M, M, M, NONE, NONE},
+                                                     {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f}, // F Mix
+                                                     {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // X Mix
+                                                     {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // X Mix
+                                                     {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // X Mix
+                                                     490};
+
+  static constexpr mixer_t quadcopter_plus_mixing = {{M, M, M, M, NONE, NONE, NONE, NONE}, // output_type
+
+                                                     {1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f},   // F Mix
+                                                     {0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f},  // X Mix
+                                                     {1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f},  // Y Mix
+                                                     {1.0f, -1.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // Z Mix
+                                                     490};
+
+  static constexpr mixer_t quadcopter_x_mixing = {{M, M, M, M, NONE, NONE, NONE, NONE}, // output_type
+
+                                                  {1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f},   // F Mix
+                                                  {-1.0f, -1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // X Mix
+                                                  {1.0f, -1.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // Y Mix
+                                                  {1.0f, -1.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // Z Mix
+                                                  490};
+
+  static constexpr mixer_t hex_plus_mixing = {{M, M, M, M, M, M, M, M}, // output_type
+
+                                              {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f},                       //  F  Mix
+                                              {0.0f, -0.866025f, -0.866025f, 0.0f, 0.866025f, 0.866025f, 0.0f, 0.0f}, //  X  Mix
+                                              {1.0f, 0.5f, -0.5f, -1.0f, -0.5f, 0.5f, 0.0f, 0.0f},                    //  Y  Mix
+                                              {1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 0.0f, 0.0f},                    //  Z  Mix
+                                              490};
+
+  static constexpr mixer_t hex_x_mixing = {{M, M, M, M, M, M, M, M}, // output_type
+
+                                           {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f},                       //  F  Mix
+                                           {-0.5f, -1.0f, -0.5f, 0.5f, 1.0f, 0.5f, 0.0f, 0.0f},                    //  X  Mix
+                                           {0.866025f, 0.0f, -0.866025f, -0.866025f, 0.0f, 0.866025f, 0.0f, 0.0f}, //  Y  Mix
+                                           {1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 0.0f, 0.0f},                    //  Z  Mix
+                                           490};
+
+  static constexpr mixer_t octocopter_plus_mixing = {{M, M, M, M, M, M, M, M}, // output_type
+
+                                                     {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f},            //  F  Mix
+                                                     {0.0f, -0.707f, -1.0f, -0.707f, 0.0f, 0.707f, 1.0f, 0.707f}, //  X  Mix
+                                                     {1.0f, 0.707f, 0.0f, -0.707f, -1.0f, -0.707f, 0.0f, 0.707f}, //  Y  Mix
+                                                     {1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f},        //  Z  Mix
+                                                     490};
+
+  static constexpr mixer_t octocopter_x_mixing = {{M, M, M, M, M, M, M, M}, // output_type
+
+                                                  {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f},            // F Mix
+                                                  {-0.414f, -1.0f, -1.0f, -0.414f, 0.414f, 1.0f, 1.0f, 0.414}, // X Mix
+                                                  {1.0f, 0.414f, -0.414f, -1.0f, -1.0f, -0.414f, 0.414f, 1.0}, // Y Mix
+                                                  {1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f},        // Z Mix
+                                                  490};
+
+  static constexpr mixer_t Y6_mixing = {{M, M, M, M, M, M, NONE, NONE}, // output_type
+
+                                        {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f},               // F Mix
+                                        {-1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f},             // X Mix
+                                        {0.667f, 0.667f, -1.333f, -1.333f, 0.667f, 0.667f, 0.0f, 0.0f}, // Y Mix
+                                        {1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 0.0f, 0.0f},            // Z Mix
+                                        490};
+
+  static constexpr mixer_t X8_mixing = {{M, M, M, M, M, M, M, M}, // output_type
+
+                                        {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f},     // F Mix
+                                        {-1.0f, -1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f, 1.0f}, // X Mix
+                                        {1.0f, 1.0f, -1.0f, -1.0f, -1.0f, -1.0f, 1.0f, 1.0f}, // Y Mix
+                                        {1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f}, // Z Mix
+                                        490};
+
+  static constexpr mixer_t tricopter_mixing = {{M, M, M, S, NONE, NONE, NONE, NONE}, // output_type
+
+                                               {1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f},        // F Mix
+                                               {-1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f},       // X Mix
+                                               {0.667f, 0.0f, 0.667f, -1.333f, 0.0f, 0.0f, 0.0f, 0.0f}, // Y Mix
+                                               {0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f},        // Z Mix
+                                               490};
+
+  static constexpr mixer_t fixedwing_mixing = {{S, S, M, S, S, M, NONE, NONE},
+
+                                               {0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // F Mix
+                                               {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // X Mix
+                                               {0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // Y Mix
+                                               {0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // Z Mix
+                                               50};
+
+  static constexpr mixer_t passthrough_mixing = {{NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE},
+
+                                                 {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // F Mix
+                                                 {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // X Mix
+                                                 {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // Y Mix
+                                                 {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // Z Mix
+                                                 50};
+  // clang-format on
 
-                                    {1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f},        // F Mix
-                                    {-1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f},       // X Mix
-                                    {0.667f, 0.0f, 0.667f, -1.333f, 0.0f, 0.0f, 0.0f, 0.0f}, // Y Mix
-                                    {0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f},        // Z Mix
-                                    490};
+  // Filled in from the CMIX_* parameters by load_custom_mixer()
+  mixer_t custom_mixing_;
 
-  const mixer_t fixedwing_mixing = {{S, S, M, S, S, M, NONE, NONE},
+  const mixer_t* mixer_to_use_;
 
-                                    {0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // F Mix
-                                    {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // X Mix
-                                    {0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // Y Mix
-                                    {0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // Z Mix
-                                    50};
+  // Matrix multiply unrolled at compile time for the number of outputs the selected mixer uses. The kernel is chosen
+  // once in init_mixing(), so mix_output() does no per-output type checks or loop bookkeeping.
+  static inline void mix_unrolled(const mixer_t&, float, float, float, float, float*, std::integral_constant<uint8_t, 0>)
+  {
+  }
+
+  template <uint8_t N>
+  static inline void mix_unrolled(const mixer_t& mixer,
+                                  float F,
+                                  float x,
+                                  float y,
+                                  float z,
+                                  float* out,
+                                  std::integral_constant<uint8_t, N>)
+  {
+    mix_unrolled(mixer, F, x, y, z, out, std::integral_constant<uint8_t, N - 1>());
+    out[N - 1] = F * mixer.F[N - 1] + x * mixer.x[N - 1] + y * mixer.y[N - 1] + z * mixer.z[N - 1];
+  }
 
-  const mixer_t passthrough_mixing = {{NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE},
+  template <uint8_t N>
+  static void mix_kernel(const mixer_t& mixer, float F, float x, float y, float z, float* out)
+  {
+    mix_unrolled(mixer, F, x, y, z, out, std::integral_constant<uint8_t, N>());
+  }
 
-                                      {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // F Mix
-                                      {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // X Mix
-                                      {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // Y Mix
-                                      {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // Z Mix
-                                      50};
+  static const mix_kernel_t mix_kernels_[NUM_MIXER_OUTPUTS + 1];
 
-  const mixer_t* mixer_to_use_;
+  mix_kernel_t mix_kernel_;
+  uint8_t num_mixer_outputs_;
 
   // clang-format off
   const mixer_t* array_of_mixers_[NUM_MIXERS] = {&esc_calibration_mixing,
@@ -214,7 +298,8 @@ private:
                                                  &X8_mixing,
                                                  &tricopter_mixing,
                                                  &fixedwing_mixing,
-                                                 &passthrough_mixing};
+                                                 &passthrough_mixing,
+                                                 &custom_mixing_};
   // clang-format on
 
 public:
@@ -224,8 +309,12 @@ public:
   void init_mixing();
   void mix_output();
   void param_change_callback(uint16_t param_id) override;
+  void param_batch_change_callback(const uint16_t *param_ids, uint16_t count) override;
+  bool param_is_relevant(uint16_t param_id) const override;
   void set_new_aux_command(aux_command_t new_aux_command);
   inline const float* get_outputs() const { return raw_outputs_; }
+  turbomath::Vector get_output_torque() const;
+  inline const float* get_motor_rpm() const { return motor_rpm_; }
 };
 
 } // namespace rosflight_firmware
@@ -41,179 +41,9 @@ namespace rosflight_firmware
 {
 enum : uint16_t
 {
-  /******************************/
-  /*** HARDWARE CONFIGURATION ***/
-  /******************************/
-  PARAM_BAUD_RATE = 0,
-  PARAM_SERIAL_DEVICE,
-
-  /*****************************/
-  /*** MAVLINK CONFIGURATION ***/
-  /*****************************/
-  PARAM_SYSTEM_ID,
-  PARAM_STREAM_HEARTBEAT_RATE,
-  PARAM_STREAM_STATUS_RATE,
-
-  PARAM_STREAM_ATTITUDE_RATE,
-  PARAM_STREAM_IMU_RATE,
-  PARAM_STREAM_MAG_RATE,
-  PARAM_STREAM_BARO_RATE,
-  PARAM_STREAM_AIRSPEED_RATE,
-  PARAM_STREAM_SONAR_RATE,
-  PARAM_STREAM_GNSS_RATE,
-  PARAM_STREAM_GNSS_FULL_RATE,
-  PARAM_STREAM_BATTERY_STATUS_RATE,
-
-  PARAM_STREAM_OUTPUT_RAW_RATE,
-  PARAM_STREAM_RC_RAW_RATE,
-
-  /********************************/
-  /*** CONTROLLER CONFIGURATION ***/
-  /********************************/
-  PARAM_MAX_COMMAND,
-
-  PARAM_PID_ROLL_RATE_P,
-  PARAM_PID_ROLL_RATE_I,
-  PARAM_PID_ROLL_RATE_D,
-
-  PARAM_PID_PITCH_RATE_P,
-  PARAM_PID_PITCH_RATE_I,
-  PARAM_PID_PITCH_RATE_D,
-
-  PARAM_PID_YAW_RATE_P,
-  PARAM_PID_YAW_RATE_I,
-  PARAM_PID_YAW_RATE_D,
-
-  PARAM_PID_ROLL_ANGLE_P,
-  PARAM_PID_ROLL_ANGLE_I,
-  PARAM_PID_ROLL_ANGLE_D,
-
-  PARAM_PID_PITCH_ANGLE_P,
-  PARAM_PID_PITCH_ANGLE_I,
-  PARAM_PID_PITCH_ANGLE_D,
-
-  PARAM_X_EQ_TORQUE,
-  PARAM_Y_EQ_TORQUE,
-  PARAM_Z_EQ_TORQUE,
-
-  PARAM_PID_TAU,
-
-  /*************************/
-  /*** PWM CONFIGURATION ***/
-  /*************************/
-  PARAM_MOTOR_PWM_SEND_RATE,
-  PARAM_MOTOR_IDLE_THROTTLE,
-  PARAM_FAILSAFE_THROTTLE,
-  PARAM_SPIN_MOTORS_WHEN_ARMED,
-
-  /*******************************/
-  /*** ESTIMATOR CONFIGURATION ***/
-  /*******************************/
-  PARAM_INIT_TIME,
-  PARAM_FILTER_KP_ACC,
-  PARAM_FILTER_KI,
-  PARAM_FILTER_KP_EXT,
-  PARAM_FILTER_ACCEL_MARGIN,
-
-  PARAM_FILTER_USE_QUAD_INT,
-  PARAM_FILTER_USE_MAT_EXP,
-  PARAM_FILTER_USE_ACC,
-
-  PARAM_CALIBRATE_GYRO_ON_ARM,
-
-  PARAM_GYRO_XY_ALPHA,
-  PARAM_GYRO_Z_ALPHA,
-  PARAM_ACC_ALPHA,
-
-  PARAM_GYRO_X_BIAS,
-  PARAM_GYRO_Y_BIAS,
-  PARAM_GYRO_Z_BIAS,
-  PARAM_ACC_X_BIAS,
-  PARAM_ACC_Y_BIAS,
-  PARAM_ACC_Z_BIAS,
-  PARAM_ACC_X_TEMP_COMP,
-  PARAM_ACC_Y_TEMP_COMP,
-  PARAM_ACC_Z_TEMP_COMP,
-
-  PARAM_MAG_A11_COMP,
-  PARAM_MAG_A12_COMP,
-  PARAM_MAG_A13_COMP,
-  PARAM_MAG_A21_COMP,
-  PARAM_MAG_A22_COMP,
-  PARAM_MAG_A23_COMP,
-  PARAM_MAG_A31_COMP,
-  PARAM_MAG_A32_COMP,
-  PARAM_MAG_A33_COMP,
-  PARAM_MAG_X_BIAS,
-  PARAM_MAG_Y_BIAS,
-  PARAM_MAG_Z_BIAS,
-
-  PARAM_BARO_BIAS,
-  PARAM_GROUND_LEVEL,
-
-  PARAM_DIFF_PRESS_BIAS,
-
-  /************************/
-  /*** RC CONFIGURATION ***/
-  /************************/
-  PARAM_RC_TYPE,
-  PARAM_RC_X_CHANNEL,
-  PARAM_RC_Y_CHANNEL,
-  PARAM_RC_Z_CHANNEL,
-  PARAM_RC_F_CHANNEL,
-  PARAM_RC_ATTITUDE_OVERRIDE_CHANNEL,
-  PARAM_RC_THROTTLE_OVERRIDE_CHANNEL,
-  PARAM_RC_ATT_CONTROL_TYPE_CHANNEL,
-  PARAM_RC_ARM_CHANNEL,
-  PARAM_RC_NUM_CHANNELS,
-
-  PARAM_RC_SWITCH_5_DIRECTION,
-  PARAM_RC_SWITCH_6_DIRECTION,
-  PARAM_RC_SWITCH_7_DIRECTION,
-  PARAM_RC_SWITCH_8_DIRECTION,
-
-  PARAM_RC_OVERRIDE_DEVIATION,
-  PARAM_OVERRIDE_LAG_TIME,
-  PARAM_RC_OVERRIDE_TAKE_MIN_THROTTLE,
-
-  PARAM_RC_ATTITUDE_MODE,
-  PARAM_RC_MAX_ROLL,
-  PARAM_RC_MAX_PITCH,
-  PARAM_RC_MAX_ROLLRATE,
-  PARAM_RC_MAX_PITCHRATE,
-  PARAM_RC_MAX_YAWRATE,
-
-  /***************************/
-  /*** FRAME CONFIGURATION ***/
-  /***************************/
-  PARAM_MIXER,
-
-  PARAM_FIXED_WING,
-  PARAM_ELEVATOR_REVERSE,
-  PARAM_AILERON_REVERSE,
-  PARAM_RUDDER_REVERSE,
-
-  PARAM_FC_ROLL,
-  PARAM_FC_PITCH,
-  PARAM_FC_YAW,
-
-  /********************/
-  /*** ARMING SETUP ***/
-  /********************/
-  PARAM_ARM_THRESHOLD,
-
-  /************************/
-  /*** OFFBOARD CONTROL ***/
-  /************************/
-  PARAM_OFFBOARD_TIMEOUT,
-
-  /***********************/
-  /*** BATTERY MONITOR ***/
-  /***********************/
-  PARAM_BATTERY_VOLTAGE_MULTIPLIER,
-  PARAM_BATTERY_CURRENT_MULTIPLIER,
-  PARAM_BATTERY_VOLTAGE_ALPHA,
-  PARAM_BATTERY_CURRENT_ALPHA,
+#define PARAM_INT(id, name, default_value, min, max) id,
+#define PARAM_FLOAT(id, name, default_value, min, max) id,
+#include "param_list.h"
 
   // keep track of size of params array
   PARAMS_COUNT
@@ -232,38 +62,101 @@ class Params
 public:
   static constexpr uint8_t PARAMS_NAME_LENGTH = 16;
 
-private:
   union param_value_t
   {
     float fvalue;
     int32_t ivalue;
+
+    param_value_t() = default;
+    constexpr param_value_t(int32_t value) : ivalue(value) {}
+    constexpr param_value_t(float value) : fvalue(value) {}
   };
 
+private:
+  ROSflight &RF_;
+
+  // Names, types and defaults are constant tables in flash (see param_list.h), so only the values live in RAM
+  param_value_t values_[PARAMS_COUNT];
+
+  // Stored image. Each value is tagged with a hash of its parameter's name and type rather than relying on its
+  // position, so firmware that adds, removes or reorders parameters still loads every value it shares with the
+  // version that wrote the image. Parameters missing from the image keep their defaults and entries for parameters
+  // this version does not know are skipped. Only the first count entries are written.
+  //
+  // The scratch image only has room for this version's own entries, to keep it small. A longer image, written by
+  // firmware with more parameters, can't be checked against its checksum and is rejected.
+  static constexpr uint8_t STORAGE_FORMAT = 1;
+  static constexpr uint16_t STORAGE_CAPACITY = PARAMS_COUNT;
+
+  typedef struct
+  {
+    uint32_t tag; // see get_param_tag()
+    param_value_t value;
+  } stored_param_t;
+
   typedef struct
   {
-    uint32_t version;
-    uint16_t size;
     uint8_t magic_be; // magic number, should be 0xBE
+    uint8_t format;   // STORAGE_FORMAT
+    uint16_t count;   // number of entries
+    uint32_t version; // GIT_VERSION_HASH of the firmware that wrote the image, for information only
+    uint16_t chk;     // Fletcher-16 checksum of the entries
+    uint8_t reserved;
+    uint8_t magic_ef; // magic number, should be 0xEF
+    stored_param_t entries[STORAGE_CAPACITY];
+  } stored_params_t;
 
-    param_value_t values[PARAMS_COUNT];
-    char names[PARAMS_COUNT][PARAMS_NAME_LENGTH];
-    param_type_t types[PARAMS_COUNT];
+  static stored_params_t storage_; // only used while reading or writing, so shared between instances
 
-    uint8_t magic_ef; // magic number, should be 0xEF
-    uint8_t chk;      // XOR checksum
-  } params_t;
+  uint16_t lookup_param_tag(uint32_t tag) const;
+  bool read_image();
+  bool write_image();
 
-  params_t params;
-  ROSflight &RF_;
+  // Journal of (tag, value) records in the board's pair of parameter sectors, used instead of the image where the
+  // board has them. write() appends a record for each parameter changed since the last read() or write(), and only
+  // when the active sector is full are the current values compacted into the other one, so erases alternate between
+  // the two sectors. The sector with the newest sequence number is the active one. Its header is programmed after its
+  // records, so an interrupted compaction leaves the previous sector active.
+  static constexpr uint32_t JOURNAL_MAGIC = 0x4E524A50; // "PJRN"
 
-  void init_param_int(uint16_t id, const char name[PARAMS_NAME_LENGTH], int32_t value);
-  void init_param_float(uint16_t id, const char name[PARAMS_NAME_LENGTH], float value);
-  uint8_t compute_checksum(void);
+  typedef struct
+  {
+    uint32_t magic;
+    uint32_t sequence;
+  } journal_header_t;
+
+  typedef struct
+  {
+    uint32_t tag; // see get_param_tag()
+    param_value_t value;
+    uint32_t check; // programmed last, so a record cut short by a reset doesn't validate
+  } journal_record_t;
+
+  uint8_t journal_sector_;
+  uint32_t journal_sequence_;
+  size_t journal_offset_;                     // where the next record goes, 0 before the journal has been read
+  uint32_t unsaved_[(PARAMS_COUNT + 31) / 32]; // parameters changed since the last read() or write()
+
+  bool journal_supported();
+  bool journal_read();
+  bool journal_append(uint16_t id);
+  bool journal_compact();
+  static uint32_t journal_check(const journal_record_t &record);
+  void mark_unsaved(uint16_t id);
+
+  uint16_t sorted_ids_[PARAMS_COUNT]; // parameter IDs in name order, for lookup_param_id()
+  void build_lookup_index();
 
   ParamListenerInterface *const *listeners_;
   size_t num_listeners_;
 
+  uint8_t listener_masks_[PARAMS_COUNT]; // bit i set if listeners_[i] cares about the parameter
+  uint32_t changed_[(PARAMS_COUNT + 31) / 32]; // parameters changed inside the open transaction
+  uint8_t transaction_depth_;
+
 public:
+  static constexpr size_t MAX_LISTENERS = 8; // one bit each in listener_masks_
+
   Params(ROSflight &_rf);
 
   // function declarations
@@ -282,28 +175,46 @@ public:
    * @brief Specify listeners for parameter changes
    * @param listeners An array of pointers to objects that implement the ParamListenerInterface
    * interface
-   * @param num_listeners The length of the array passed as the listeners parameter
+   * @param num_listeners The length of the array passed as the listeners parameter, at most MAX_LISTENERS
+   * Each listener is asked which parameters it cares about here, and is only called about those from then on
    */
   void set_listeners(ParamListenerInterface *const listeners[], size_t num_listeners);
 
   /**
    * @brief Read parameter values from non-volatile memory
    * @return True if successful, false otherwise
+   * The image may come from another firmware version (see stored_params_t). Values are only changed if it is valid.
    */
   bool read(void);
 
   /**
    * @brief Write current parameter values to non-volatile memory
    * @return True if successful, false otherwise
+   * With a parameter journal only the parameters changed since the last read or write are written
    */
   bool write(void);
 
   /**
    * @brief Callback for executing actions that need to be taken when a parameter value changes
    * @param id The ID of the parameter that was changed
+   * Inside a transaction the change is only recorded, and the listeners hear about it on commit
    */
   void change_callback(uint16_t id);
 
+  /**
+   * @brief Starts collecting parameter changes instead of notifying the listeners about each one
+   * Transactions nest; the changes are dispatched when the outermost one is committed. Values and the change
+   * notifications sent to the companion are still updated immediately.
+   */
+  void begin_transaction();
+
+  /**
+   * @brief Ends a transaction started with begin_transaction()
+   * When the outermost transaction ends, each listener is called once with all of the changed parameters it cares
+   * about
+   */
+  void commit_transaction();
+
   /**
    * @brief Gets the id of a parameter from its name
    * @param name The name of the parameter
@@ -311,26 +222,35 @@ public:
    */
   uint16_t lookup_param_id(const char name[PARAMS_NAME_LENGTH]);
 
+  /**
+   * @brief Computes a Fletcher-16 checksum over the names, types and values of a range of parameters
+   * @param first The ID of the first parameter in the range
+   * @param count The number of parameters in the range, clipped to the end of the table
+   * @return The checksum. For each parameter it covers the name up to its terminator, the type (0 for int, 1 for
+   * float) as one byte and the value as four little-endian bytes, which is everything a ground station caches
+   */
+  uint16_t checksum(uint16_t first, uint16_t count) const;
+
   /**
    * @brief Get the value of an integer parameter by id
    * @param id The ID of the parameter
    * @return The value of the parameter
    */
-  inline int get_param_int(uint16_t id) const { return params.values[id].ivalue; }
+  inline int get_param_int(uint16_t id) const { return values_[id].ivalue; }
 
   /**
    * @brief Get the value of a floating point parameter by id
    * @param id The ID of the parameter
    * @return The value of the parameter
    */
-  inline float get_param_float(uint16_t id) const { return params.values[id].fvalue; }
+  inline float get_param_float(uint16_t id) const { return values_[id].fvalue; }
 
   /**
    * @brief Get the name of a parameter
    * @param id The ID of the parameter
    * @return The name of the parameter
    */
-  inline const char *get_param_name(uint16_t id) const { return params.names[id]; }
+  const char *get_param_name(uint16_t id) const;
 
   /**
    * @brief Get the type of a parameter
@@ -340,7 +260,15 @@ public:
    * PARAM_TYPE_INT32, PARAM_TYPE_FLOAT, or PARAM_TYPE_INVALID
    * See line 165
    */
-  inline param_type_t get_param_type(uint16_t id) const { return params.types[id]; }
+  param_type_t get_param_type(uint16_t id) const;
+
+  /**
+   * @brief Get the tag that identifies a parameter's value in non-volatile memory
+   * @param id The ID of the parameter
+   * @return The 32-bit FNV-1a hash of the parameter's type (as one byte) followed by its name, which stays the same
+   * across firmware versions for as long as the name and type do
+   */
+  uint32_t get_param_tag(uint16_t id) const;
 
   /**
    * @brief Sets the value of a parameter by ID and calls the parameter change callback
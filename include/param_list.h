@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) 2017, James Jackson and Daniel Koch, BYU MAGICC Lab
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Single source of every parameter's ID, name, type, default value and recommended range. This file is included
+// wherever a per-parameter table is needed, after defining the row macros:
+//
+//   PARAM_INT(id, name, default_value, min, max)
+//   PARAM_FLOAT(id, name, default_value, min, max)
+//
+// Rows are in ID order, so adding a parameter here adds its enum value, its name and default in flash, and its
+// documentation entry (see scripts/param_parser.py). Names are at most Params::PARAMS_NAME_LENGTH characters and
+// defaults lie within [min, max], both of which the compiler checks. The row macros are undefined again at the end of this file.
+
+// clang-format off
+/******************************/
+/*** HARDWARE CONFIGURATION ***/
+/******************************/
+PARAM_INT(PARAM_BAUD_RATE, "BAUD_RATE", 921600, 9600, 921600) // Baud rate of MAVlink communication with companion computer
+PARAM_INT(PARAM_SERIAL_DEVICE, "SERIAL_DEVICE", 0, 0, 3) // Serial Port (for supported devices)
+
+/*****************************/
+/*** MAVLINK CONFIGURATION ***/
+/*****************************/
+PARAM_INT(PARAM_SYSTEM_ID, "SYS_ID", 1, 1, 255) // Mavlink System ID
+PARAM_INT(PARAM_STREAM_HEARTBEAT_RATE, "STRM_HRTBT", 1, 0, 1000) // Rate of heartbeat stream (Hz)
+PARAM_INT(PARAM_STREAM_STATUS_RATE, "STRM_STATUS", 10, 0, 1000) // Rate of status stream (Hz)
+
+PARAM_INT(PARAM_STREAM_ATTITUDE_RATE, "STRM_ATTITUDE", 200, 0, 1000) // Rate of attitude stream (Hz)
+PARAM_INT(PARAM_STREAM_IMU_RATE, "STRM_IMU", 250, 0, 1000) // Rate of IMU stream (Hz)
+PARAM_INT(PARAM_STREAM_IMU_BATCH_RATE, "STRM_IMU_BATCH", 0, 0, 1000) // Rate of batched raw IMU stream, up to 10 samples per message (Hz)
+PARAM_INT(PARAM_STREAM_MAG_RATE, "STRM_MAG", 50, 0, 75) // Rate of magnetometer stream (Hz)
+PARAM_INT(PARAM_STREAM_BARO_RATE, "STRM_BARO", 50, 0, 100) // Rate of barometer stream (Hz)
+PARAM_INT(PARAM_STREAM_AIRSPEED_RATE, "STRM_AIRSPEED", 50, 0, 50) // Rate of airspeed stream (Hz)
+PARAM_INT(PARAM_STREAM_SONAR_RATE, "STRM_SONAR", 40, 0, 40) // Rate of sonar stream (Hz)
+PARAM_INT(PARAM_STREAM_GNSS_RATE, "STRM_GNSS", 1000, 0, 1000) // Maximum rate of GNSS stream (Hz)
+PARAM_INT(PARAM_STREAM_GNSS_FULL_RATE, "STRM_GNSS_FULL", 10, 0, 10) // Rate of GNSS full stream (Hz)
+PARAM_INT(PARAM_STREAM_BATTERY_STATUS_RATE, "STRM_BATTERY", 10, 0, 10) // Rate of battery status stream (Hz)
+
+PARAM_INT(PARAM_STREAM_OUTPUT_RAW_RATE, "STRM_SERVO", 50, 0, 490) // Rate of raw output stream
+PARAM_INT(PARAM_STREAM_RC_RAW_RATE, "STRM_RC", 50, 0, 50) // Rate of raw RC input stream
+PARAM_INT(PARAM_STREAM_STATS_RATE, "STRM_STATS", 0, 0, 50) // Rate of per-stream rate and drop reports (Hz)
+PARAM_FLOAT(PARAM_STREAM_LINK_LOAD, "STRM_LINK_LOAD", 0.8f, 0.1, 1.0) // Fraction of the serial link streams may use
+PARAM_INT(PARAM_LOG_BINARY, "LOG_BINARY", 0, 0, 1) // Send log messages as binary records for scripts/log_decoder.py instead of text
+PARAM_INT(PARAM_TIMESYNC_STAMP, "TIMESYNC_STAMP", 0, 0, 1) // Stamp attitude and IMU telemetry in companion computer time once timesync has locked
+
+/********************************/
+/*** CONTROLLER CONFIGURATION ***/
+/********************************/
+PARAM_FLOAT(PARAM_MAX_COMMAND, "PARAM_MAX_CMD", 1.0, 0, 1.0) // saturation point for PID controller output
+
+PARAM_FLOAT(PARAM_PID_ROLL_RATE_P, "PID_ROLL_RATE_P", 0.070f, 0.0, 1000.0) // Roll Rate Proportional Gain
+PARAM_FLOAT(PARAM_PID_ROLL_RATE_I, "PID_ROLL_RATE_I", 0.000f, 0.0, 1000.0) // Roll Rate Integral Gain
+PARAM_FLOAT(PARAM_PID_ROLL_RATE_D, "PID_ROLL_RATE_D", 0.000f, 0.0, 1000.0) // Roll Rate Derivative Gain
+
+PARAM_FLOAT(PARAM_PID_PITCH_RATE_P, "PID_PITCH_RATE_P", 0.070f, 0.0, 1000.0) // Pitch Rate Proportional Gain
+PARAM_FLOAT(PARAM_PID_PITCH_RATE_I, "PID_PITCH_RATE_I", 0.0000f, 0.0, 1000.0) // Pitch Rate Integral Gain
+PARAM_FLOAT(PARAM_PID_PITCH_RATE_D, "PID_PITCH_RATE_D", 0.0000f, 0.0, 1000.0) // Pitch Rate Derivative Gain
+
+PARAM_FLOAT(PARAM_PID_YAW_RATE_P, "PID_YAW_RATE_P", 0.25f, 0.0, 1000.0) // Yaw Rate Proportional Gain
+PARAM_FLOAT(PARAM_PID_YAW_RATE_I, "PID_YAW_RATE_I", 0.0f, 0.0, 1000.0) // Yaw Rate Integral Gain
+PARAM_FLOAT(PARAM_PID_YAW_RATE_D, "PID_YAW_RATE_D", 0.0f, 0.0, 1000.0) // Yaw Rate Derivative Gain
+
+PARAM_FLOAT(PARAM_PID_ROLL_ANGLE_P, "PID_ROLL_ANG_P", 0.15f, 0.0, 1000.0) // Roll Angle Proportional Gain
+PARAM_FLOAT(PARAM_PID_ROLL_ANGLE_I, "PID_ROLL_ANG_I", 0.0f, 0.0, 1000.0) // Roll Angle Integral Gain
+PARAM_FLOAT(PARAM_PID_ROLL_ANGLE_D, "PID_ROLL_ANG_D", 0.05f, 0.0, 1000.0) // Roll Angle Derivative Gain
+
+PARAM_FLOAT(PARAM_PID_PITCH_ANGLE_P, "PID_PITCH_ANG_P", 0.15f, 0.0, 1000.0) // Pitch Angle Proportional Gain
+PARAM_FLOAT(PARAM_PID_PITCH_ANGLE_I, "PID_PITCH_ANG_I", 0.0f, 0.0, 1000.0) // Pitch Angle Integral Gain
+PARAM_FLOAT(PARAM_PID_PITCH_ANGLE_D, "PID_PITCH_ANG_D", 0.05f, 0.0, 1000.0) // Pitch Angle Derivative Gain
+
+PARAM_FLOAT(PARAM_X_EQ_TORQUE, "X_EQ_TORQUE", 0.0f, -1.0, 1.0) // Equilibrium torque added to output of controller on x axis
+PARAM_FLOAT(PARAM_Y_EQ_TORQUE, "Y_EQ_TORQUE", 0.0f, -1.0, 1.0) // Equilibrium torque added to output of controller on y axis
+PARAM_FLOAT(PARAM_Z_EQ_TORQUE, "Z_EQ_TORQUE", 0.0f, -1.0, 1.0) // Equilibrium torque added to output of controller on z axis
+
+PARAM_FLOAT(PARAM_PID_TAU, "PID_TAU", 0.05f, 0.0, 1.0) // Dirty Derivative time constant - See controller documentation
+
+PARAM_INT(PARAM_ATTITUDE_CONTROL_TYPE, "ATT_CTRL_TYPE", 0, 0, 2) // Angle mode attitude error (0: Euler angles, 1: quaternion error, 2: tilt-prioritized reduced attitude)
+
+PARAM_INT(PARAM_RATE_CONTROL_TYPE, "RATE_CTRL_TYPE", 0, 0, 1) // Rate loop type (0: PID, 1: incremental nonlinear dynamic inversion)
+PARAM_FLOAT(PARAM_INDI_ALPHA, "INDI_ALPHA", 0.7f, 0, 1.0) // Low-pass filter constant applied to both the angular acceleration and actuator feedback used by INDI - See controller documentation
+PARAM_FLOAT(PARAM_INDI_G_ROLL, "INDI_G_ROLL", 150.0f, 0.0, 10000.0) // Roll control effectiveness (rad/s^2 per unit torque command)
+PARAM_FLOAT(PARAM_INDI_G_PITCH, "INDI_G_PITCH", 150.0f, 0.0, 10000.0) // Pitch control effectiveness (rad/s^2 per unit torque command)
+PARAM_FLOAT(PARAM_INDI_G_YAW, "INDI_G_YAW", 20.0f, 0.0, 10000.0) // Yaw control effectiveness (rad/s^2 per unit torque command)
+
+/*************************/
+/*** PWM CONFIGURATION ***/
+/*************************/
+PARAM_INT(PARAM_MOTOR_PWM_SEND_RATE, "MOTOR_PWM_UPDATE", 0, 0, 490) // Overrides default PWM rate specified by mixer if non-zero - Requires reboot to take effect
+PARAM_FLOAT(PARAM_MOTOR_IDLE_THROTTLE, "MOTOR_IDLE_THR", 0.1, 0.0, 1.0) // min throttle command sent to motors when armed (Set above 0.1 to spin when armed)
+PARAM_FLOAT(PARAM_FAILSAFE_THROTTLE, "FAILSAFE_THR", -1.0, -1.0, 1.0) // Throttle sent to motors in failsafe condition (set just below hover throttle). The default of -1 is invalid until set.
+PARAM_INT(PARAM_SPIN_MOTORS_WHEN_ARMED, "ARM_SPIN_MOTORS", true, 0, 1) // Enforce MOTOR_IDLE_THR
+PARAM_FLOAT(PARAM_MOTOR_THRUST_MODEL, "MOTOR_THR_MDL", 0.0f, 0.0, 1.0) // Motor thrust curve used to linearize mixer outputs (0: thrust linear in command, 1: thrust quadratic in command)
+PARAM_FLOAT(PARAM_MOTOR_VOLTAGE_NOMINAL, "MOTOR_V_NOM", 0.0f, 0.0, 100.0) // Battery voltage the vehicle was tuned at, motor commands are scaled up as the battery sags below it (0 to disable)
+PARAM_INT(PARAM_MOTOR_PROTOCOL, "MOTOR_PROTOCOL", 0, 0, 3) // Motor output protocol (0: PWM, 1: DShot150, 2: DShot300, 3: DShot600)
+PARAM_INT(PARAM_DSHOT_BIDIRECTIONAL, "DSHOT_BIDIR", false, 0, 1) // Request eRPM telemetry from the ESCs using bidirectional DShot
+PARAM_INT(PARAM_MOTOR_POLES, "MOTOR_POLES", 14, 2, 100) // Number of magnet poles in the motors, used to convert eRPM telemetry to RPM
+
+/*******************************/
+/*** ESTIMATOR CONFIGURATION ***/
+/*******************************/
+PARAM_INT(PARAM_INIT_TIME, "FILTER_INIT_T", 3000, 0, 100000) // Time in ms to initialize estimator
+PARAM_FLOAT(PARAM_FILTER_KP_ACC, "FILTER_KP_ACC", 0.5f, 0, 10.0) // estimator proportional gain on accel-based error - See estimator documentation
+PARAM_FLOAT(PARAM_FILTER_KI, "FILTER_KI", 0.01f, 0, 1.0) // estimator integral gain - See estimator documentation
+PARAM_FLOAT(PARAM_FILTER_KP_EXT, "FILTER_KP_EXT", 1.5f, 0, 10.0) // estimator proportional gain on external attitude-based error - See estimator documentation
+PARAM_FLOAT(PARAM_FILTER_ACCEL_MARGIN, "FILTER_ACCMARGIN", 0.1f, 0, 1.0) // allowable accel norm margin around 1g to determine if accel is usable
+
+PARAM_INT(PARAM_FILTER_USE_QUAD_INT, "FILTER_QUAD_INT", 1, 0, 1) // Perform a quadratic averaging of LPF gyro data prior to integration (adds ~20 us to estimation loop on F1 processors)
+PARAM_INT(PARAM_FILTER_USE_MAT_EXP, "FILTER_MAT_EXP", 1, 0, 1) // 1 - Use matrix exponential to improve gyro integration (adds ~90 us to estimation loop in F1 processors) 0 - use euler integration
+PARAM_INT(PARAM_FILTER_USE_ACC, "FILTER_USE_ACC", 1, 0, 1) // Use accelerometer to correct gyro integration drift (adds ~70 us to estimation loop)
+
+PARAM_INT(PARAM_CALIBRATE_GYRO_ON_ARM, "CAL_GYRO_ARM", false, 0, 1) // True if desired to calibrate gyros on arm
+
+PARAM_FLOAT(PARAM_GYRO_XY_ALPHA, "GYROXY_LPF_ALPHA", 0.3f, 0, 1.0) // Low-pass filter constant on gyro X and Y axes - See estimator documentation
+PARAM_FLOAT(PARAM_GYRO_Z_ALPHA, "GYROZ_LPF_ALPHA", 0.3f, 0, 1.0) // Low-pass filter constant on gyro Z axis - See estimator documentation
+PARAM_FLOAT(PARAM_ACC_ALPHA, "ACC_LPF_ALPHA", 0.5f, 0, 1.0) // Low-pass filter constant on all accel axes - See estimator documentation
+
+PARAM_FLOAT(PARAM_GYRO_X_BIAS, "GYRO_X_BIAS", 0.0f, -1.0, 1.0) // Constant x-bias of gyroscope readings
+PARAM_FLOAT(PARAM_GYRO_Y_BIAS, "GYRO_Y_BIAS", 0.0f, -1.0, 1.0) // Constant y-bias of gyroscope readings
+PARAM_FLOAT(PARAM_GYRO_Z_BIAS, "GYRO_Z_BIAS", 0.0f, -1.0, 1.0) // Constant z-bias of gyroscope readings
+PARAM_FLOAT(PARAM_ACC_X_BIAS, "ACC_X_BIAS", 0.0f, -2.0, 2.0) // Constant x-bias of accelerometer readings
+PARAM_FLOAT(PARAM_ACC_Y_BIAS, "ACC_Y_BIAS", 0.0f, -2.0, 2.0) // Constant y-bias of accelerometer readings
+PARAM_FLOAT(PARAM_ACC_Z_BIAS, "ACC_Z_BIAS", 0.0f, -2.0, 2.0) // Constant z-bias of accelerometer readings
+PARAM_FLOAT(PARAM_ACC_X_TEMP_COMP, "ACC_X_TEMP_COMP", 0.0f, -2.0, 2.0) // Linear x-axis temperature compensation constant
+PARAM_FLOAT(PARAM_ACC_Y_TEMP_COMP, "ACC_Y_TEMP_COMP", 0.0f, -2.0, 2.0) // Linear y-axis temperature compensation constant
+PARAM_FLOAT(PARAM_ACC_Z_TEMP_COMP, "ACC_Z_TEMP_COMP", 0.0f, -2.0, 2.0) // Linear z-axis temperature compensation constant
+
+PARAM_FLOAT(PARAM_MAG_A11_COMP, "MAG_A11_COMP", 1.0f, -999.0, 999.0) // Soft iron compensation constant
+PARAM_FLOAT(PARAM_MAG_A12_COMP, "MAG_A12_COMP", 0.0f, -999.0, 999.0) // Soft iron compensation constant
+PARAM_FLOAT(PARAM_MAG_A13_COMP, "MAG_A13_COMP", 0.0f, -999.0, 999.0) // Soft iron compensation constant
+PARAM_FLOAT(PARAM_MAG_A21_COMP, "MAG_A21_COMP", 0.0f, -999.0, 999.0) // Soft iron compensation constant
+PARAM_FLOAT(PARAM_MAG_A22_COMP, "MAG_A22_COMP", 1.0f, -999.0, 999.0) // Soft iron compensation constant
+PARAM_FLOAT(PARAM_MAG_A23_COMP, "MAG_A23_COMP", 0.0f, -999.0, 999.0) // Soft iron compensation constant
+PARAM_FLOAT(PARAM_MAG_A31_COMP, "MAG_A31_COMP", 0.0f, -999.0, 999.0) // Soft iron compensation constant
+PARAM_FLOAT(PARAM_MAG_A32_COMP, "MAG_A32_COMP", 0.0f, -999.0, 999.0) // Soft iron compensation constant
+PARAM_FLOAT(PARAM_MAG_A33_COMP, "MAG_A33_COMP", 1.0f, -999.0, 999.0) // Soft iron compensation constant
+PARAM_FLOAT(PARAM_MAG_X_BIAS, "MAG_X_BIAS", 0.0f, -999.0, 999.0) // Hard iron compensation constant
+PARAM_FLOAT(PARAM_MAG_Y_BIAS, "MAG_Y_BIAS", 0.0f, -999.0, 999.0) // Hard iron compensation constant
+PARAM_FLOAT(PARAM_MAG_Z_BIAS, "MAG_Z_BIAS", 0.0f, -999.0, 999.0) // Hard iron compensation constant
+
+PARAM_FLOAT(PARAM_BARO_BIAS, "BARO_BIAS", 0.0f, 0, INFINITY) // Barometer measurement bias (Pa)
+PARAM_FLOAT(PARAM_GROUND_LEVEL, "GROUND_LEVEL", 1387.0f, -1000, 10000) // Altitude of ground level (m)
+
+PARAM_FLOAT(PARAM_DIFF_PRESS_BIAS, "DIFF_PRESS_BIAS", 0.0f, -10, 10) // Differential Pressure Bias (Pa)
+
+/************************/
+/*** RC CONFIGURATION ***/
+/************************/
+PARAM_INT(PARAM_RC_TYPE, "RC_TYPE", 0, 0, 1) // Type of RC input 0 - PPM, 1 - SBUS
+PARAM_INT(PARAM_RC_X_CHANNEL, "RC_X_CHN", 0, 0, 3) // RC input channel mapped to x-axis commands [0 - indexed]
+PARAM_INT(PARAM_RC_Y_CHANNEL, "RC_Y_CHN", 1, 0, 3) // RC input channel mapped to y-axis commands [0 - indexed]
+PARAM_INT(PARAM_RC_Z_CHANNEL, "RC_Z_CHN", 3, 0, 3) // RC input channel mapped to z-axis commands [0 - indexed]
+PARAM_INT(PARAM_RC_F_CHANNEL, "RC_F_CHN", 2, 0, 3) // RC input channel mapped to F-axis commands [0 - indexed]
+PARAM_INT(PARAM_RC_ATTITUDE_OVERRIDE_CHANNEL, "RC_ATT_OVRD_CHN", 4, 4, 7) // RC switch mapped to attitude override [0 indexed, -1 to disable]
+PARAM_INT(PARAM_RC_THROTTLE_OVERRIDE_CHANNEL, "RC_THR_OVRD_CHN", 4, 4, 7) // RC switch channel mapped to throttle override [0 indexed, -1 to disable]
+PARAM_INT(PARAM_RC_ATT_CONTROL_TYPE_CHANNEL, "RC_ATT_CTRL_CHN", -1, -1, 7) // RC switch channel mapped to attitude control type [0 indexed, -1 to disable]
+PARAM_INT(PARAM_RC_ARM_CHANNEL, "ARM_CHANNEL", -1, -1, 7) // RC switch channel mapped to arming (only if PARAM_ARM_STICKS is false) [0 indexed, -1 to disable]
+PARAM_INT(PARAM_RC_NUM_CHANNELS, "RC_NUM_CHN", 6, 1, 8) // number of RC input channels
+
+PARAM_INT(PARAM_RC_SWITCH_5_DIRECTION, "SWITCH_5_DIR", 1, -1, 1) // RC switch 5 toggle direction
+PARAM_INT(PARAM_RC_SWITCH_6_DIRECTION, "SWITCH_6_DIR", 1, -1, 1) // RC switch 6 toggle direction
+PARAM_INT(PARAM_RC_SWITCH_7_DIRECTION, "SWITCH_7_DIR", 1, -1, 1) // RC switch 7 toggle direction
+PARAM_INT(PARAM_RC_SWITCH_8_DIRECTION, "SWITCH_8_DIR", 1, -1, 1) // RC switch 8 toggle direction
+
+PARAM_FLOAT(PARAM_RC_OVERRIDE_DEVIATION, "RC_OVRD_DEV", 0.1, 0.0, 1.0) // RC stick deviation from center for override
+PARAM_INT(PARAM_OVERRIDE_LAG_TIME, "OVRD_LAG_TIME", 1000, 0, 100000) // RC stick deviation lag time before returning control (ms)
+PARAM_INT(PARAM_RC_OVERRIDE_TAKE_MIN_THROTTLE, "MIN_THROTTLE", true, 0, 1) // Take minimum throttle between RC and computer at all times
+
+PARAM_INT(PARAM_RC_ATTITUDE_MODE, "RC_ATT_MODE", 1, 0, 1) // Attitude mode for RC sticks (0: rate, 1: angle). Overridden if RC_ATT_CTRL_CHN is set.
+PARAM_FLOAT(PARAM_RC_MAX_ROLL, "RC_MAX_ROLL", 0.786f, 0.0, 3.14159) // Maximum roll angle command sent by full deflection of RC sticks
+PARAM_FLOAT(PARAM_RC_MAX_PITCH, "RC_MAX_PITCH", 0.786f, 0.0, 3.14159) // Maximum pitch angle command sent by full stick deflection of RC sticks
+PARAM_FLOAT(PARAM_RC_MAX_ROLLRATE, "RC_MAX_ROLLRATE", 3.14159f, 0.0, 9.42477796077) // Maximum roll rate command sent by full stick deflection of RC sticks
+PARAM_FLOAT(PARAM_RC_MAX_PITCHRATE, "RC_MAX_PITCHRATE", 3.14159f, 0.0, 3.14159) // Maximum pitch command sent by full stick deflection of RC sticks
+PARAM_FLOAT(PARAM_RC_MAX_YAWRATE, "RC_MAX_YAWRATE", 1.507f, 0.0, 3.14159) // Maximum pitch command sent by full stick deflection of RC sticks
+
+/***************************/
+/*** FRAME CONFIGURATION ***/
+/***************************/
+PARAM_INT(PARAM_MIXER, "MIXER", Mixer::INVALID_MIXER, 0, 255) // Which mixer to choose - See Mixer documentation. The default of 255 is invalid until a mixer is chosen.
+
+PARAM_INT(PARAM_CUSTOM_MIXER_TYPES, "CMIX_TYPES", 0, 0, 65535) // Custom mixer output types, 2 bits per output starting at output 0 (0: none, 1: servo, 2: motor, 3: GPIO)
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_F_0, "CMIX_F_0", 0.0f, -1.0, 1.0) // Custom mixer thrust contribution to output 0
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_F_1, "CMIX_F_1", 0.0f, -1.0, 1.0) // Custom mixer thrust contribution to output 1
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_F_2, "CMIX_F_2", 0.0f, -1.0, 1.0) // Custom mixer thrust contribution to output 2
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_F_3, "CMIX_F_3", 0.0f, -1.0, 1.0) // Custom mixer thrust contribution to output 3
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_F_4, "CMIX_F_4", 0.0f, -1.0, 1.0) // Custom mixer thrust contribution to output 4
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_F_5, "CMIX_F_5", 0.0f, -1.0, 1.0) // Custom mixer thrust contribution to output 5
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_F_6, "CMIX_F_6", 0.0f, -1.0, 1.0) // Custom mixer thrust contribution to output 6
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_F_7, "CMIX_F_7", 0.0f, -1.0, 1.0) // Custom mixer thrust contribution to output 7
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_X_0, "CMIX_X_0", 0.0f, -1.0, 1.0) // Custom mixer roll torque contribution to output 0
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_X_1, "CMIX_X_1", 0.0f, -1.0, 1.0) // Custom mixer roll torque contribution to output 1
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_X_2, "CMIX_X_2", 0.0f, -1.0, 1.0) // Custom mixer roll torque contribution to output 2
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_X_3, "CMIX_X_3", 0.0f, -1.0, 1.0) // Custom mixer roll torque contribution to output 3
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_X_4, "CMIX_X_4", 0.0f, -1.0, 1.0) // Custom mixer roll torque contribution to output 4
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_X_5, "CMIX_X_5", 0.0f, -1.0, 1.0) // Custom mixer roll torque contribution to output 5
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_X_6, "CMIX_X_6", 0.0f, -1.0, 1.0) // Custom mixer roll torque contribution to output 6
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_X_7, "CMIX_X_7", 0.0f, -1.0, 1.0) // Custom mixer roll torque contribution to output 7
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_Y_0, "CMIX_Y_0", 0.0f, -1.0, 1.0) // Custom mixer pitch torque contribution to output 0
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_Y_1, "CMIX_Y_1", 0.0f, -1.0, 1.0) // Custom mixer pitch torque contribution to output 1
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_Y_2, "CMIX_Y_2", 0.0f, -1.0, 1.0) // Custom mixer pitch torque contribution to output 2
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_Y_3, "CMIX_Y_3", 0.0f, -1.0, 1.0) // Custom mixer pitch torque contribution to output 3
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_Y_4, "CMIX_Y_4", 0.0f, -1.0, 1.0) // Custom mixer pitch torque contribution to output 4
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_Y_5, "CMIX_Y_5", 0.0f, -1.0, 1.0) // Custom mixer pitch torque contribution to output 5
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_Y_6, "CMIX_Y_6", 0.0f, -1.0, 1.0) // Custom mixer pitch torque contribution to output 6
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_Y_7, "CMIX_Y_7", 0.0f, -1.0, 1.0) // Custom mixer pitch torque contribution to output 7
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_Z_0, "CMIX_Z_0", 0.0f, -1.0, 1.0) // Custom mixer yaw torque contribution to output 0
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_Z_1, "CMIX_Z_1", 0.0f, -1.0, 1.0) // Custom mixer yaw torque contribution to output 1
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_Z_2, "CMIX_Z_2", 0.0f, -1.0, 1.0) // Custom mixer yaw torque contribution to output 2
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_Z_3, "CMIX_Z_3", 0.0f, -1.0, 1.0) // Custom mixer yaw torque contribution to output 3
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_Z_4, "CMIX_Z_4", 0.0f, -1.0, 1.0) // Custom mixer yaw torque contribution to output 4
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_Z_5, "CMIX_Z_5", 0.0f, -1.0, 1.0) // Custom mixer yaw torque contribution to output 5
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_Z_6, "CMIX_Z_6", 0.0f, -1.0, 1.0) // Custom mixer yaw torque contribution to output 6
+PARAM_FLOAT(PARAM_CUSTOM_MIXER_Z_7, "CMIX_Z_7", 0.0f, -1.0, 1.0) // Custom mixer yaw torque contribution to output 7
+
+PARAM_INT(PARAM_MIXER_AIRMODE, "AIRMODE", 0, 0, 1) // Prioritized motor mixing: keep roll and pitch first, then thrust, then yaw, shifting collective up or down as needed (0: uniform scaling, 1: prioritized)
+
+PARAM_INT(PARAM_FIXED_WING, "FIXED_WING", false, 0, 1) // switches on pass-through commands for fixed-wing operation
+PARAM_INT(PARAM_ELEVATOR_REVERSE, "ELEVATOR_REV", 0, 0, 1) // reverses elevator servo output
+PARAM_INT(PARAM_AILERON_REVERSE, "AIL_REV", 0, 0, 1) // reverses aileron servo output
+PARAM_INT(PARAM_RUDDER_REVERSE, "RUDDER_REV", 0, 0, 1) // reverses rudder servo output
+
+PARAM_FLOAT(PARAM_FC_ROLL, "FC_ROLL", 0.0f, 0, 360) // roll angle (deg) of flight controller wrt aircraft body
+PARAM_FLOAT(PARAM_FC_PITCH, "FC_PITCH", 0.0f, 0, 360) // pitch angle (deg) of flight controller wrt aircraft body
+PARAM_FLOAT(PARAM_FC_YAW, "FC_YAW", 0.0f, 0, 360) // yaw angle (deg) of flight controller wrt aircraft body
+
+/********************/
+/*** ARMING SETUP ***/
+/********************/
+PARAM_FLOAT(PARAM_ARM_THRESHOLD, "ARM_THRESHOLD", 0.15, 0, 500) // RC deviation from max/min in yaw and throttle for arming and disarming check (us)
+
+/************************/
+/*** OFFBOARD CONTROL ***/
+/************************/
+PARAM_INT(PARAM_OFFBOARD_TIMEOUT, "OFFBOARD_TIMEOUT", 100, 0, 100000) // Timeout in milliseconds for offboard commands, after which RC override is activated
+PARAM_INT(PARAM_OFFBOARD_MAX_AGE, "OFFBOARD_MAX_AGE", 50, 0, 100000) // Age in milliseconds after which stamped offboard commands are ignored, 0 to accept any age
+
+/***********************/
+/*** BATTERY MONITOR ***/
+/***********************/
+PARAM_FLOAT(PARAM_BATTERY_VOLTAGE_MULTIPLIER, "BATT_VOLT_MULT", 0.0f, 0, INFINITY) // Battery monitor voltage multiplier
+PARAM_FLOAT(PARAM_BATTERY_CURRENT_MULTIPLIER, "BATT_CURR_MULT", 0.0f, 0, INFINITY) // Battery monitor current multiplier
+PARAM_FLOAT(PARAM_BATTERY_VOLTAGE_ALPHA, "BATT_VOLT_ALPHA", 0.995f, 0, 1) // Battery monitor voltage filter alpha. Values closer to 1 smooth the signal more.
+PARAM_FLOAT(PARAM_BATTERY_CURRENT_ALPHA, "BATT_CURR_ALPHA", 0.995f, 0, 1) // Battery monitor current filter alpha. Values closer to 1 smooth the signal more.
+
+/****************/
+/*** BLACKBOX ***/
+/****************/
+PARAM_INT(PARAM_BLACKBOX_FIELDS, "BLACKBOX_FIELDS", 0, 0, 63) // Fields recorded while armed, 0 to disable: 1 IMU, 2 attitude, 4 controller output, 8 mixer outputs, 16 RC, 32 loop time
+PARAM_INT(PARAM_BLACKBOX_DIVIDER, "BLACKBOX_DIV", 1, 1, 100) // Record one frame every this many control loops
+// clang-format on
+
+#undef PARAM_INT
+#undef PARAM_FLOAT
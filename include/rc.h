@@ -71,6 +71,8 @@ public:
   bool run();
   bool new_command();
   void param_change_callback(uint16_t param_id) override;
+  void param_batch_change_callback(const uint16_t *param_ids, uint16_t count) override;
+  bool param_is_relevant(uint16_t param_id) const override;
 
 private:
   ROSflight &RF_;
@@ -101,6 +103,16 @@ private:
   volatile bool switch_values[SWITCHES_COUNT];
   volatile float stick_values[STICKS_COUNT];
 
+  // What a parameter change needs redone, so a batch of changes redoes each part once
+  enum : uint8_t
+  {
+    UPDATE_RC_TYPE = 0x01,
+    UPDATE_STICKS = 0x02,
+    UPDATE_SWITCHES = 0x04,
+  };
+  uint8_t param_updates(uint16_t param_id) const;
+  void apply_param_updates(uint8_t updates);
+
   void init_rc();
   void init_switches();
   void init_sticks();
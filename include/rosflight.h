@@ -35,6 +35,7 @@
 #include "interface/comm_link.h"
 #include "interface/param_listener.h"
 
+#include "blackbox.h"
 #include "board.h"
 #include "comm_manager.h"
 #include "command_manager.h"
@@ -67,6 +68,7 @@ public:
   RC rc_;
   Sensors sensors_;
   StateManager state_manager_;
+  Blackbox blackbox_;
 
   uint32_t loop_time_us;
 
@@ -86,6 +88,7 @@ private:
   static constexpr size_t num_param_listeners_ = 7;
   ParamListenerInterface* const param_listeners_[num_param_listeners_] = {
       &comm_manager_, &command_manager_, &controller_, &estimator_, &mixer_, &rc_, &sensors_};
+  static_assert(num_param_listeners_ <= Params::MAX_LISTENERS, "Params tracks listener interest in a uint8_t");
 };
 
 } // namespace rosflight_firmware
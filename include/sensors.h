@@ -162,15 +162,32 @@ public:
     float battery_current = 0;
   };
 
+  // A single corrected IMU sample, as kept in the raw sample ring
+  struct ImuSample
+  {
+    uint64_t time_us;
+    turbomath::Vector accel;
+    turbomath::Vector gyro;
+  };
+
+  static constexpr uint8_t IMU_SAMPLE_RING_SIZE = 32;
+
   Sensors(ROSflight &rosflight);
 
   inline const Data &data() const { return data_; }
   void get_filtered_IMU(turbomath::Vector &accel, turbomath::Vector &gyro, uint64_t &stamp_us);
 
+  // Pop up to max_count of the oldest raw IMU samples into dest, returns the number copied
+  uint8_t read_imu_samples(ImuSample *dest, uint8_t max_count);
+  inline uint8_t imu_samples_available() const { return imu_ring_length_; }
+  inline uint32_t imu_samples_overwritten() const { return imu_ring_overwritten_; }
+
   // function declarations
   void init();
   bool run();
   void param_change_callback(uint16_t param_id) override;
+  void param_batch_change_callback(const uint16_t *param_ids, uint16_t count) override;
+  bool param_is_relevant(uint16_t param_id) const override;
 
   // Calibration Functions
   bool start_imu_calibration(void);
@@ -236,6 +253,16 @@ private:
   bool calibrating_acc_flag_ = false;
   bool calibrating_gyro_flag_ = false;
   uint8_t next_sensor_to_update_ = BAROMETER;
+  // What a parameter change needs redone, so a batch of changes redoes each part once
+  enum : uint8_t
+  {
+    UPDATE_IMU = 0x01,
+    UPDATE_BATTERY_MULTIPLIERS = 0x02,
+    UPDATE_BATTERY_ALPHAS = 0x04,
+  };
+  uint8_t param_updates(uint16_t param_id) const;
+  void apply_param_updates(uint8_t updates);
+
   void init_imu();
   void calibrate_accel(void);
   void calibrate_gyro(void);
@@ -272,6 +299,13 @@ private:
   uint64_t int_start_us_;
   uint64_t prev_imu_read_time_us_;
 
+  // Raw IMU samples waiting to be batched out, oldest first
+  ImuSample imu_ring_[IMU_SAMPLE_RING_SIZE];
+  uint8_t imu_ring_oldest_ = 0;
+  uint8_t imu_ring_length_ = 0;
+  uint32_t imu_ring_overwritten_ = 0;
+  void push_imu_sample();
+
   // Baro Calibration
   bool baro_calibrated_ = false;
   float ground_pressure_ = 0.0f;
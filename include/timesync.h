@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2017, James Jackson and Daniel Koch, BYU MAGICC Lab
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSFLIGHT_FIRMWARE_TIMESYNC_H
+#define ROSFLIGHT_FIRMWARE_TIMESYNC_H
+
+#include <cstdint>
+
+namespace rosflight_firmware
+{
+// Estimates the companion computer's clock from MAVLink TIMESYNC exchanges, as an offset from the board clock that
+// drifts linearly: offset(t) = offset at the last sample + skew * (t - time of the last sample). Each exchange gives
+// one measurement of the offset, and an alpha-beta filter with least squares gains fits the line through the last
+// FIT_SAMPLES of them. Measurements that are far off the line are dropped, unless several in a row are, which means
+// the companion clock was stepped and the fit starts over.
+//
+// Round trips (replies to the board's own requests) are assumed to be symmetric, so they measure the offset itself.
+// Requests sent by the companion include the uplink delay in the offset, and are only used until a round trip is seen.
+class TimeSync
+{
+public:
+  static constexpr uint8_t MIN_SAMPLES = 5; // before the estimate is used
+  static constexpr uint8_t FIT_SAMPLES = 20;
+
+  void reset();
+
+  /**
+   * @brief Adds the reply to a request the board sent at request_us and received back at reply_us
+   * @param remote_us The companion time of the reply
+   */
+  void add_round_trip(uint64_t request_us, uint64_t reply_us, uint64_t remote_us);
+
+  /**
+   * @brief Adds a request the companion sent at remote_us, and the board received at receive_us
+   */
+  void add_one_way(uint64_t receive_us, uint64_t remote_us);
+
+  inline bool valid() const { return samples_ >= MIN_SAMPLES; }
+  inline float skew() const { return skew_; }
+  inline float jitter_us() const { return jitter_us_; }
+  inline uint32_t resyncs() const { return resyncs_; }
+
+  /**
+   * @brief The companion time minus the board time at the board time local_us
+   */
+  int64_t offset_us(uint64_t local_us) const;
+  inline uint64_t to_remote(uint64_t local_us) const { return local_us + static_cast<uint64_t>(offset_us(local_us)); }
+  uint64_t to_local(uint64_t remote_us) const;
+
+private:
+  static constexpr float OUTLIER_MIN_US = 5000.0f;
+  static constexpr float OUTLIER_JITTERS = 6.0f; // residuals larger than this many times the jitter are outliers
+  static constexpr uint8_t MAX_OUTLIERS = 3;     // in a row, before starting over
+  static constexpr float JITTER_GAIN = 0.1f;
+
+  void add_sample(uint64_t local_us, int64_t offset);
+  void restart();
+
+  bool round_trip_ = false; // only round trips are used once one has been seen
+  uint8_t samples_ = 0;     // in the fit, up to FIT_SAMPLES
+  uint8_t outliers_ = 0;
+  uint32_t resyncs_ = 0;
+
+  uint64_t ref_us_ = 0;    // board time of the last sample
+  int64_t offset_ = 0;     // fitted offset at ref_us_
+  float skew_ = 0.0f;      // change in offset per board microsecond
+  float jitter_us_ = 0.0f; // average size of the residuals
+};
+
+} // namespace rosflight_firmware
+
+#endif // ROSFLIGHT_FIRMWARE_TIMESYNC_H
@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+#
+# Decodes the flight log written by the blackbox recorder (see include/blackbox.h) into one CSV file, or one numpy
+# .npz archive, per recording session. The input is either a raw image of the log storage or a capture of the
+# serial stream holding the ROSFLIGHT_BLACKBOX_DATA replies to a ROSFLIGHT_BLACKBOX_REQUEST.
+#
+#   ./blackbox_decoder.py log.bin [--mavlink] [--npz] [--prefix flight]
+#
+__copyright__ = "Copyright 2017, ROSflight"
+__license__ = "BSD-3"
+
+import argparse
+import struct
+
+PAGE_SIZE = 256
+PAGE_HEADER = struct.Struct("<HHBBH")  # session, length, version, fields, reserved
+FORMAT_VERSION = 1
+MAVLINK_MSG_ID_ROSFLIGHT_BLACKBOX_DATA = 215
+
+# (bit, column names, scale) in frame order
+FIELDS = [
+    (0x01, ["accel_x", "accel_y", "accel_z", "gyro_x", "gyro_y", "gyro_z"], [1e-3] * 3 + [1e-4] * 3),
+    (0x02, ["q_w", "q_x", "q_y", "q_z", "omega_x", "omega_y", "omega_z"], [1e-4] * 7),
+    (0x04, ["control_x", "control_y", "control_z", "control_F"], [1e-4] * 4),
+    (0x08, ["output_%d" % i for i in range(14)], [1e-4] * 14),
+    (0x10, ["rc_x", "rc_y", "rc_z", "rc_F"], [1e-4] * 4),
+    (0x20, ["loop_time_us"], [1]),
+]
+
+
+def columns(fields):
+    names, scales = ["time_us"], [1]
+    for bit, field_names, field_scales in FIELDS:
+        if fields & bit:
+            names += field_names
+            scales += field_scales
+    return names, scales
+
+
+def varint(data, i):
+    value, shift = 0, 0
+    while True:
+        byte = data[i]
+        i += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, i
+
+
+def zigzag(data, i):
+    value, i = varint(data, i)
+    return (value >> 1) ^ -(value & 1), i
+
+
+def wrap32(value):
+    return (value + 2 ** 31) % 2 ** 32 - 2 ** 31
+
+
+def decode_page(page, count):
+    # every page starts with a key frame, so pages decode independently
+    header = PAGE_HEADER.unpack_from(page)
+    body = page[PAGE_HEADER.size:PAGE_HEADER.size + header[1]]
+    rows, time_us, values = [], 0, [0] * count
+    i = 0
+    try:
+        while i < len(body):
+            kind = body[i]
+            i += 1
+            if kind not in (ord("I"), ord("P")):
+                break
+            dt, i = varint(body, i)
+            time_us = dt if kind == ord("I") else time_us + dt
+            for v in range(count):
+                delta, i = zigzag(body, i)
+                values[v] = delta if kind == ord("I") else wrap32(values[v] + delta)
+            rows.append([time_us] + values)
+    except IndexError:
+        pass  # page cut short
+    return rows
+
+
+def decode(image):
+    sessions = {}
+    for offset in range(0, len(image) - PAGE_SIZE + 1, PAGE_SIZE):
+        page = image[offset:offset + PAGE_SIZE]
+        session, length, version, fields, _ = PAGE_HEADER.unpack_from(page)
+        if session == 0xFFFF:
+            break
+        if version != FORMAT_VERSION or length > PAGE_SIZE - PAGE_HEADER.size:
+            continue
+        names, scales = columns(fields)
+        key = (session, fields)
+        if key not in sessions:
+            sessions[key] = (names, [])
+        for row in decode_page(page, len(names) - 1):
+            sessions[key][1].append([value * scale for value, scale in zip(row, scales)])
+    return sessions
+
+
+def image_from_mavlink(data):
+    chunks = {}
+    i = 0
+    while i < len(data):
+        if data[i] == 0xFE and i + 6 <= len(data):
+            length, msgid, start = data[i + 1], data[i + 5], i + 6
+            i = start + length + 2
+        elif data[i] == 0xFD and i + 10 <= len(data):
+            length, start = data[i + 1], i + 10
+            msgid = data[i + 7] | (data[i + 8] << 8) | (data[i + 9] << 16)
+            i = start + length + 2 + (13 if data[i + 2] & 0x01 else 0)
+        else:
+            i += 1
+            continue
+        if msgid != MAVLINK_MSG_ID_ROSFLIGHT_BLACKBOX_DATA:
+            continue
+        # MAVLink 2 trims trailing zeros from the payload
+        payload = data[start:start + length].ljust(137, b"\0")
+        offset, _ = struct.unpack_from("<II", payload)
+        count = payload[136]
+        chunks[offset] = payload[8:8 + count]
+
+    image = bytearray()
+    for offset in sorted(chunks):
+        if offset != len(image):
+            image += b"\xff" * (offset - len(image))  # missing chunk, its pages are skipped
+        image[offset:offset + len(chunks[offset])] = chunks[offset]
+    return bytes(image)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode a ROSflight blackbox log")
+    parser.add_argument("input", help="raw log storage image, or a serial capture with --mavlink")
+    parser.add_argument("--mavlink", action="store_true", help="input is a capture of ROSFLIGHT_BLACKBOX_DATA")
+    parser.add_argument("--npz", action="store_true", help="write numpy archives instead of CSV")
+    parser.add_argument("--prefix", default="blackbox", help="output file name prefix")
+    args = parser.parse_args()
+
+    with open(args.input, "rb") as f:
+        data = f.read()
+    if args.mavlink:
+        data = image_from_mavlink(data)
+
+    for (session, fields), (names, rows) in sorted(decode(data).items()):
+        if args.npz:
+            import numpy as np
+            path = "%s_%d.npz" % (args.prefix, session)
+            table = np.array(rows).reshape(-1, len(names))
+            np.savez(path, **{name: table[:, i] for i, name in enumerate(names)})
+        else:
+            path = "%s_%d.csv" % (args.prefix, session)
+            with open(path, "w") as f:
+                f.write(",".join(names) + "\n")
+                for row in rows:
+                    f.write(",".join("%.10g" % value for value in row) + "\n")
+        print("session %d: %d frames -> %s" % (session, len(rows), path))
+
+
+if __name__ == "__main__":
+    main()
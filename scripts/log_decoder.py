@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+#
+# Formats the ROSFLIGHT_LOG records in a capture of the firmware's serial stream (MAVLink 1 or 2), using the
+# message table in include/log_messages.h. The firmware sends these instead of STATUSTEXT when LOG_BINARY is set.
+#
+#   ./log_decoder.py capture.bin [path/to/log_messages.h]
+#
+__copyright__ = "Copyright 2017, ROSflight"
+__license__ = "BSD-3"
+
+import os
+import re
+import struct
+import sys
+
+MAVLINK_MSG_ID_ROSFLIGHT_LOG = 213
+ROSFLIGHT_LOG_LEN = 16
+SEVERITIES = {2: "CRITICAL", 3: "ERROR", 4: "WARNING", 6: "INFO"}
+
+
+def load_formats(path):
+    formats = []
+    with open(path) as f:
+        for line in f:
+            # message rows: LOG_MESSAGE(id, "format"), in ID order
+            match = re.search(r'^\s*LOG_MESSAGE\((\w+),\s*"(.*)"\)', line)
+            if match:
+                formats.append((match.group(1), match.group(2)))
+    return formats
+
+
+def frames(data):
+    i = 0
+    while i < len(data):
+        if data[i] == 0xFE and i + 6 <= len(data):
+            length = data[i + 1]
+            msgid = data[i + 5]
+            payload = data[i + 6:i + 6 + length]
+            i += 6 + length + 2
+        elif data[i] == 0xFD and i + 10 <= len(data):
+            length = data[i + 1]
+            signed = data[i + 2] & 0x01
+            msgid = data[i + 7] | (data[i + 8] << 8) | (data[i + 9] << 16)
+            payload = data[i + 10:i + 10 + length]
+            i += 10 + length + 2 + (13 if signed else 0)
+        else:
+            i += 1
+            continue
+        yield msgid, payload
+
+
+def main():
+    if len(sys.argv) < 2:
+        print("usage: %s capture.bin [log_messages.h]" % sys.argv[0])
+        return 1
+    here = os.path.dirname(os.path.abspath(__file__))
+    table = sys.argv[2] if len(sys.argv) > 2 else os.path.join(here, "..", "include", "log_messages.h")
+    formats = load_formats(table)
+
+    with open(sys.argv[1], "rb") as f:
+        data = f.read()
+
+    for msgid, payload in frames(data):
+        if msgid != MAVLINK_MSG_ID_ROSFLIGHT_LOG:
+            continue
+        # MAVLink 2 trims trailing zeros from the payload
+        payload = payload.ljust(ROSFLIGHT_LOG_LEN, b"\0")[:ROSFLIGHT_LOG_LEN]
+        a0, a1, a2, log_id, severity, arg_count = struct.unpack("<iiiHBB", payload)
+        args = (a0, a1, a2)[:min(arg_count, 3)]
+        if log_id < len(formats):
+            try:
+                text = formats[log_id][1] % args
+            except (TypeError, ValueError):
+                text = "%s %s" % (formats[log_id][0], args)
+        else:
+            text = "unknown message %d %s" % (log_id, args)
+        print("[%s] %s" % (SEVERITIES.get(severity, str(severity)), text))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -9,33 +9,27 @@ __email__ = "superjax08@gmail.com"
 
 import re
 
-f = open('../src/param.cpp')
+f = open('../include/param_list.h')
 text = f.read()
 
 
 lines = re.split("\n+", text)
 
 params = []
-i = 0
 for line in lines:
-    # search for init_param lines
-    match = re.search("^\s*init_param", line)
+    # search for parameter rows: PARAM_<TYPE>(id, "NAME", default, min, max) // description
+    match = re.search("^\s*PARAM_(INT|FLOAT)\((\w+),\s*\"(\w{1,16})\",\s*(.*)\)\s*//(.*)$", line)
     if match != None:
-        name_with_quotes = re.search("\".*\"", line).group(0)
-        name = re.search("\w{1,16}", name_with_quotes).group(0)
-        if name != 'DEFAULT':
-            params.append(dict())
-            params[i]['type'] = re.split("\(", re.split("_", line)[2])[0]
-            params[i]['name'] = name
-            # Find default value
-            params[i]['default'] =  re.split("\)", re.split(",", line)[2])[0]
-            # isolate the comment portion of the line and split it on the "|" characters
-            comment = re.split("\|", re.split("//", line)[1])
-            # Isolate the Description
-            params[i]["description"] = comment[0].strip()
-            params[i]["min"] = comment[1].strip()
-            params[i]["max"] = comment[2].strip()
-            i += 1
+        param = dict()
+        param['type'] = match.group(1).lower()
+        param['name'] = match.group(3)
+        # default, min and max are the last three macro arguments
+        values = [v.strip() for v in match.group(4).rsplit(",", 2)]
+        param['default'] = values[0]
+        param['min'] = values[1]
+        param['max'] = values[2]
+        param['description'] = match.group(5).strip()
+        params.append(param)
 
 # Now, generate the markdown table of the parameters
 out = open('parameter-descriptions.md', 'w')
@@ -39,6 +39,9 @@ ROSFLIGHT_SRC = rosflight.cpp \
                 command_manager.cpp \
                 rc.cpp \
                 mixer.cpp \
+                dshot.cpp \
+                blackbox.cpp \
+                timesync.cpp \
                 nanoprintf.cpp
 
 # Math Source Files
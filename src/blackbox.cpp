@@ -0,0 +1,348 @@
+/*
+ * Copyright (c) 2017, James Jackson and Daniel Koch, BYU MAGICC Lab
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "blackbox.h"
+
+#include "rosflight.h"
+
+#include <cstring>
+
+namespace rosflight_firmware
+{
+constexpr uint8_t Blackbox::FORMAT_VERSION;
+constexpr uint8_t Blackbox::FRAME_KEY;
+constexpr uint8_t Blackbox::FRAME_DELTA;
+
+static int32_t fixed(float value, float scale)
+{
+  float scaled = value * scale;
+  if (!(scaled > -2.0e9f && scaled < 2.0e9f)) // also catches NaN
+    return 0;
+  return static_cast<int32_t>(scaled + (scaled >= 0.0f ? 0.5f : -0.5f));
+}
+
+static size_t put_varint(uint8_t *dest, uint64_t value)
+{
+  size_t i = 0;
+  while (value >= 0x80)
+  {
+    dest[i++] = static_cast<uint8_t>(value | 0x80);
+    value >>= 7;
+  }
+  dest[i++] = static_cast<uint8_t>(value);
+  return i;
+}
+
+static size_t put_zigzag(uint8_t *dest, int32_t value)
+{
+  uint32_t zigzag = (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+  return put_varint(dest, zigzag);
+}
+
+Blackbox::Blackbox(ROSflight &rf) : RF_(rf)
+{
+  memset(previous_values_, 0, sizeof(previous_values_));
+}
+
+void Blackbox::init()
+{
+  storage_size_ = RF_.board_.log_storage_size() / PAGE_SIZE * PAGE_SIZE;
+  if (storage_size_ == 0)
+    return;
+
+  write_offset_ = find_end();
+  full_ = (write_offset_ >= storage_size_);
+}
+
+size_t Blackbox::find_end()
+{
+  // pages are written in order from the start of the storage, so the used ones can be found by bisection
+  size_t first_unused = 0;
+  size_t count = storage_size_ / PAGE_SIZE;
+  page_header_t header;
+  while (count > 0)
+  {
+    size_t half = count / 2;
+    size_t page = first_unused + half;
+    if (RF_.board_.log_storage_read(page * PAGE_SIZE, &header, sizeof(header)) && header.session != 0xFFFF)
+    {
+      first_unused = page + 1;
+      count -= half + 1;
+    }
+    else
+    {
+      count = half;
+    }
+  }
+
+  session_ = 0;
+  if (first_unused > 0 && RF_.board_.log_storage_read((first_unused - 1) * PAGE_SIZE, &header, sizeof(header)))
+    session_ = static_cast<uint16_t>(header.session + 1);
+  if (session_ == 0xFFFF)
+    session_ = 0;
+  return first_unused * PAGE_SIZE;
+}
+
+void Blackbox::record()
+{
+  if (!recording_)
+  {
+    if (!RF_.state_manager_.state().armed || storage_size_ == 0 || full_)
+      return;
+    start_session();
+    if (!recording_)
+      return;
+  }
+
+  if (loops_until_frame_ > 0)
+  {
+    loops_until_frame_--;
+    return;
+  }
+  loops_until_frame_ = static_cast<uint16_t>(divider_ - 1);
+
+  int32_t values[MAX_VALUES];
+  uint8_t count = collect_values(values);
+  uint64_t time_us = RF_.sensors_.data().imu_time;
+
+  if (filling_ == NO_PAGE && !next_page())
+  {
+    frames_dropped_++;
+    return;
+  }
+
+  // every page starts with a key frame, so a page lost to a reset or a dropped write doesn't spoil the ones after it
+  uint8_t frame[MAX_FRAME_SIZE];
+  size_t frame_size = encode_frame(frame, page_length_[filling_] == 0, time_us, values, count);
+  if (sizeof(page_header_t) + page_length_[filling_] + frame_size > PAGE_SIZE)
+  {
+    close_page();
+    if (!next_page())
+    {
+      frames_dropped_++;
+      return;
+    }
+    frame_size = encode_frame(frame, true, time_us, values, count);
+  }
+
+  memcpy(pages_[filling_] + sizeof(page_header_t) + page_length_[filling_], frame, frame_size);
+  page_length_[filling_] += frame_size;
+  memcpy(previous_values_, values, count * sizeof(int32_t));
+  previous_time_us_ = time_us;
+  frames_recorded_++;
+}
+
+void Blackbox::run()
+{
+  if (storage_size_ == 0)
+    return;
+
+  if (recording_ && (full_ || !RF_.state_manager_.state().armed))
+    end_session();
+
+  if (RF_.board_.log_storage_busy())
+    return;
+
+  if (writing_)
+  {
+    writing_ = false;
+    page_queued_[write_page_] = false;
+    write_offset_ += PAGE_SIZE;
+    write_page_ ^= 1;
+  }
+
+  if (page_queued_[write_page_])
+  {
+    if (write_offset_ + PAGE_SIZE > storage_size_)
+    {
+      page_queued_[write_page_] = false;
+      write_page_ ^= 1;
+      if (!full_)
+      {
+        full_ = true;
+        RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_WARNING, LOG_MSG_BLACKBOX_FULL,
+                              storage_size_ / 1024);
+      }
+    }
+    else if (RF_.board_.log_storage_write(write_offset_, pages_[write_page_], PAGE_SIZE))
+    {
+      writing_ = true;
+    }
+  }
+}
+
+bool Blackbox::erase()
+{
+  if (storage_size_ == 0 || recording_ || writing_ || page_queued_[0] || page_queued_[1])
+    return false;
+  if (!RF_.board_.log_storage_erase())
+    return false;
+
+  RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_INFO, LOG_MSG_BLACKBOX_ERASING);
+  write_offset_ = 0;
+  session_ = 0;
+  full_ = false;
+  return true;
+}
+
+bool Blackbox::read(size_t offset, void *dest, size_t len)
+{
+  if (recording_ || writing_ || page_queued_[0] || page_queued_[1] || offset + len > write_offset_)
+    return false;
+  if (RF_.board_.log_storage_busy())
+    return false;
+  return RF_.board_.log_storage_read(offset, dest, len);
+}
+
+void Blackbox::start_session()
+{
+  fields_ = static_cast<uint8_t>(RF_.params_.get_param_int(PARAM_BLACKBOX_FIELDS) & FIELDS_ALL);
+  if (fields_ == 0)
+    return;
+
+  divider_ = static_cast<uint16_t>(RF_.params_.get_param_int(PARAM_BLACKBOX_DIVIDER));
+  if (divider_ == 0)
+    divider_ = 1;
+  loops_until_frame_ = 0;
+  frames_recorded_ = 0;
+  frames_dropped_ = 0;
+  filling_ = NO_PAGE;
+  recording_ = true;
+}
+
+void Blackbox::end_session()
+{
+  if (filling_ != NO_PAGE && page_length_[filling_] > 0)
+    close_page();
+  filling_ = NO_PAGE;
+  recording_ = false;
+
+  if (frames_dropped_ > 0)
+    RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_WARNING, LOG_MSG_BLACKBOX_DROPPED, frames_dropped_,
+                          frames_recorded_ + frames_dropped_);
+
+  session_++;
+  if (session_ == 0xFFFF)
+    session_ = 0;
+}
+
+uint8_t Blackbox::collect_values(int32_t *values)
+{
+  uint8_t count = 0;
+  if (fields_ & FIELD_IMU)
+  {
+    const Sensors::Data &data = RF_.sensors_.data();
+    values[count++] = fixed(data.accel.x, 1e3f);
+    values[count++] = fixed(data.accel.y, 1e3f);
+    values[count++] = fixed(data.accel.z, 1e3f);
+    values[count++] = fixed(data.gyro.x, 1e4f);
+    values[count++] = fixed(data.gyro.y, 1e4f);
+    values[count++] = fixed(data.gyro.z, 1e4f);
+  }
+  if (fields_ & FIELD_ATTITUDE)
+  {
+    const Estimator::State &state = RF_.estimator_.state();
+    values[count++] = fixed(state.attitude.w, 1e4f);
+    values[count++] = fixed(state.attitude.x, 1e4f);
+    values[count++] = fixed(state.attitude.y, 1e4f);
+    values[count++] = fixed(state.attitude.z, 1e4f);
+    values[count++] = fixed(state.angular_velocity.x, 1e4f);
+    values[count++] = fixed(state.angular_velocity.y, 1e4f);
+    values[count++] = fixed(state.angular_velocity.z, 1e4f);
+  }
+  if (fields_ & FIELD_CONTROL)
+  {
+    const Controller::Output &output = RF_.controller_.output();
+    values[count++] = fixed(output.x, 1e4f);
+    values[count++] = fixed(output.y, 1e4f);
+    values[count++] = fixed(output.z, 1e4f);
+    values[count++] = fixed(output.F, 1e4f);
+  }
+  if (fields_ & FIELD_OUTPUTS)
+  {
+    const float *outputs = RF_.mixer_.get_outputs();
+    for (uint8_t i = 0; i < Mixer::NUM_TOTAL_OUTPUTS; i++)
+      values[count++] = fixed(outputs[i], 1e4f);
+  }
+  if (fields_ & FIELD_RC)
+  {
+    for (uint8_t i = 0; i < RC::STICKS_COUNT; i++)
+      values[count++] = fixed(RF_.rc_.stick(static_cast<RC::Stick>(i)), 1e4f);
+  }
+  if (fields_ & FIELD_TIMING)
+    values[count++] = static_cast<int32_t>(RF_.get_loop_time_us());
+  return count;
+}
+
+size_t Blackbox::encode_frame(uint8_t *dest, bool key, uint64_t time_us, const int32_t *values, uint8_t count) const
+{
+  size_t length = 0;
+  dest[length++] = key ? FRAME_KEY : FRAME_DELTA;
+  length += put_varint(dest + length, key ? time_us : time_us - previous_time_us_);
+  for (uint8_t i = 0; i < count; i++)
+  {
+    // differences wrap like the int32 arithmetic in the decoder, so even a jump across the whole range round-trips
+    int32_t value = values[i];
+    if (!key)
+      value = static_cast<int32_t>(static_cast<uint32_t>(values[i]) - static_cast<uint32_t>(previous_values_[i]));
+    length += put_zigzag(dest + length, value);
+  }
+  return length;
+}
+
+bool Blackbox::next_page()
+{
+  // pages are filled and written in alternation, so the next one to fill is free once its last write has finished
+  if (page_queued_[next_fill_])
+    return false;
+  filling_ = next_fill_;
+  page_length_[filling_] = 0;
+  return true;
+}
+
+void Blackbox::close_page()
+{
+  page_header_t header;
+  header.session = session_;
+  header.length = static_cast<uint16_t>(page_length_[filling_]);
+  header.version = FORMAT_VERSION;
+  header.fields = fields_;
+  header.reserved = 0xFFFF;
+
+  uint8_t *page = pages_[filling_];
+  memcpy(page, &header, sizeof(header));
+  memset(page + sizeof(header) + page_length_[filling_], 0xFF, PAGE_SIZE - sizeof(header) - page_length_[filling_]);
+  page_queued_[filling_] = true;
+  next_fill_ = static_cast<uint8_t>(filling_ ^ 1);
+  filling_ = NO_PAGE;
+}
+
+} // namespace rosflight_firmware
@@ -31,25 +31,54 @@
 
 #include "comm_manager.h"
 
+#include "nanoprintf.h"
 #include "param.h"
 
 #include "rosflight.h"
 
+#include <cstdarg>
 #include <cstdint>
 #include <cstring>
 
 namespace rosflight_firmware
 {
+// named values used to report per-stream statistics, indexed by StreamId
+static const char *const STREAM_STATS_NAMES[CommManager::STREAM_COUNT][2] = {
+    {"hrtbt_hz", "hrtbt_drop"}, {"status_hz", "stat_drop"}, {"att_hz", "att_drop"},     {"imu_hz", "imu_drop"},
+    {"imub_hz", "imub_drop"},   {"diff_hz", "diff_drop"},   {"baro_hz", "baro_drop"},   {"sonar_hz", "son_drop"},
+    {"mag_hz", "mag_drop"},     {"batt_hz", "batt_drop"},   {"servo_hz", "servo_drop"}, {"gnss_hz", "gnss_drop"},
+    {"gnssf_hz", "gnssf_drop"}, {"rc_hz", "rc_drop"},       {"lowpri_hz", "lowp_drop"}, {"stats_hz", "stats_drop"}};
+
+static const char* const LOG_FORMATS[LOG_MESSAGES_COUNT] = {
+#define LOG_MESSAGE(id, format) format,
+#include "log_messages.h"
+};
+
+// the formats ignore arguments they don't use, so every message can be formatted with all LOG_MAX_ARGS of them
+static_assert(CommLinkInterface::LOG_MAX_ARGS == 3, "format_log_message() calls pass every argument");
+static void format_log_message(char* text, const char* fmt, ...)
+{
+  va_list args;
+  va_start(args, fmt);
+  nanoprintf::tfp_sprintf(text, fmt, args);
+  va_end(args);
+}
+
 CommManager::LogMessageBuffer::LogMessageBuffer()
 {
   memset(buffer_, 0, sizeof(buffer_));
 }
 
-void CommManager::LogMessageBuffer::add_message(CommLinkInterface::LogSeverity severity, char msg[])
+void CommManager::LogMessageBuffer::add_message(CommLinkInterface::LogSeverity severity,
+                                                uint16_t id,
+                                                const int32_t* args,
+                                                uint8_t arg_count)
 {
   LogMessage& newest_msg = buffer_[newest_];
-  strcpy(newest_msg.msg, msg);
-  newest_msg.severity = severity;
+  newest_msg.id = id;
+  newest_msg.severity = static_cast<uint8_t>(severity);
+  newest_msg.arg_count = arg_count;
+  memcpy(newest_msg.args, args, arg_count * sizeof(int32_t));
 
   newest_ = (newest_ + 1) % LOG_BUF_SIZE;
 
@@ -80,12 +109,13 @@ void CommManager::init()
                   static_cast<uint32_t>(RF_.params_.get_param_int(PARAM_SERIAL_DEVICE)));
 
   offboard_control_time_ = 0;
-  send_params_index_ = PARAMS_COUNT;
+  send_params_index_ = 0;
 
   update_system_id(PARAM_SYSTEM_ID);
   set_streaming_rate(STREAM_ID_HEARTBEAT, PARAM_STREAM_HEARTBEAT_RATE);
   set_streaming_rate(STREAM_ID_STATUS, PARAM_STREAM_STATUS_RATE);
   set_streaming_rate(STREAM_ID_IMU, PARAM_STREAM_IMU_RATE);
+  set_streaming_rate(STREAM_ID_IMU_BATCH, PARAM_STREAM_IMU_BATCH_RATE);
   set_streaming_rate(STREAM_ID_ATTITUDE, PARAM_STREAM_ATTITUDE_RATE);
   set_streaming_rate(STREAM_ID_DIFF_PRESSURE, PARAM_STREAM_AIRSPEED_RATE);
   set_streaming_rate(STREAM_ID_BARO, PARAM_STREAM_BARO_RATE);
@@ -96,60 +126,109 @@ void CommManager::init()
   set_streaming_rate(STREAM_ID_BATTERY_STATUS, PARAM_STREAM_BATTERY_STATUS_RATE);
   set_streaming_rate(STREAM_ID_SERVO_OUTPUT_RAW, PARAM_STREAM_OUTPUT_RAW_RATE);
   set_streaming_rate(STREAM_ID_RC_RAW, PARAM_STREAM_RC_RAW_RATE);
+  set_streaming_rate(STREAM_ID_STREAM_STATS, PARAM_STREAM_STATS_RATE);
+
+  // serve streams in priority order, keeping table order within a priority
+  uint8_t n = 0;
+  for (uint8_t priority = 0; priority < PRIORITY_COUNT; priority++)
+  {
+    for (uint8_t i = 0; i < STREAM_COUNT; i++)
+    {
+      if (streams_[i].priority_ == priority)
+        stream_order_[n++] = i;
+    }
+  }
+
+  last_stream_time_us_ = RF_.board_.clock_micros();
+  stats_window_start_us_ = last_stream_time_us_;
+  last_tx_byte_count_ = comm_link_.tx_byte_count();
+  update_link_budget();
+  tx_tokens_ = link_budget_bytes_per_s_; // start full, stream() clamps this to one burst
+  last_param_time_us_ = last_stream_time_us_;
 
   initialized_ = true;
 }
 
 void CommManager::param_change_callback(uint16_t param_id)
 {
+  uint8_t stream_id = STREAM_COUNT;
+  uint8_t updates = param_updates(param_id, &stream_id);
+  if (updates & UPDATE_SYSTEM_ID)
+    update_system_id(param_id);
+  if (updates & UPDATE_STREAM_RATE)
+    set_streaming_rate(stream_id, param_id);
+  if (updates & UPDATE_LINK_BUDGET)
+    update_link_budget();
+}
+
+bool CommManager::param_is_relevant(uint16_t param_id) const
+{
+  return param_updates(param_id) != 0;
+}
+
+uint8_t CommManager::param_updates(uint16_t param_id, uint8_t *stream_id) const
+{
+  uint8_t stream;
   switch (param_id)
   {
   case PARAM_SYSTEM_ID:
-    update_system_id(param_id);
-    break;
+    return UPDATE_SYSTEM_ID;
   case PARAM_STREAM_HEARTBEAT_RATE:
-    set_streaming_rate(STREAM_ID_HEARTBEAT, param_id);
+    stream = STREAM_ID_HEARTBEAT;
     break;
   case PARAM_STREAM_STATUS_RATE:
-    set_streaming_rate(STREAM_ID_STATUS, param_id);
+    stream = STREAM_ID_STATUS;
     break;
   case PARAM_STREAM_IMU_RATE:
-    set_streaming_rate(STREAM_ID_IMU, param_id);
+    stream = STREAM_ID_IMU;
+    break;
+  case PARAM_STREAM_IMU_BATCH_RATE:
+    stream = STREAM_ID_IMU_BATCH;
     break;
   case PARAM_STREAM_ATTITUDE_RATE:
-    set_streaming_rate(STREAM_ID_ATTITUDE, param_id);
+    stream = STREAM_ID_ATTITUDE;
     break;
   case PARAM_STREAM_AIRSPEED_RATE:
-    set_streaming_rate(STREAM_ID_DIFF_PRESSURE, param_id);
+    stream = STREAM_ID_DIFF_PRESSURE;
     break;
   case PARAM_STREAM_BARO_RATE:
-    set_streaming_rate(STREAM_ID_BARO, param_id);
+    stream = STREAM_ID_BARO;
     break;
   case PARAM_STREAM_SONAR_RATE:
-    set_streaming_rate(STREAM_ID_SONAR, param_id);
+    stream = STREAM_ID_SONAR;
     break;
   case PARAM_STREAM_GNSS_RATE:
-    set_streaming_rate(STREAM_ID_GNSS, param_id);
+    stream = STREAM_ID_GNSS;
     break;
   case PARAM_STREAM_GNSS_FULL_RATE:
-    set_streaming_rate(STREAM_ID_GNSS_FULL, param_id);
+    stream = STREAM_ID_GNSS_FULL;
     break;
   case PARAM_STREAM_MAG_RATE:
-    set_streaming_rate(STREAM_ID_MAG, param_id);
+    stream = STREAM_ID_MAG;
     break;
   case PARAM_STREAM_OUTPUT_RAW_RATE:
-    set_streaming_rate(STREAM_ID_SERVO_OUTPUT_RAW, param_id);
+    stream = STREAM_ID_SERVO_OUTPUT_RAW;
     break;
   case PARAM_STREAM_RC_RAW_RATE:
-    set_streaming_rate(STREAM_ID_RC_RAW, param_id);
+    stream = STREAM_ID_RC_RAW;
     break;
   case PARAM_STREAM_BATTERY_STATUS_RATE:
-    set_streaming_rate(STREAM_ID_BATTERY_STATUS, param_id);
+    stream = STREAM_ID_BATTERY_STATUS;
     break;
-  default:
-    // do nothing
+  case PARAM_STREAM_STATS_RATE:
+    stream = STREAM_ID_STREAM_STATS;
     break;
+  case PARAM_BAUD_RATE:
+  case PARAM_STREAM_LINK_LOAD:
+    return UPDATE_LINK_BUDGET;
+  default:
+    // LOG_BINARY and TIMESYNC_STAMP are read where they are used
+    return 0;
   }
+
+  if (stream_id != nullptr)
+    *stream_id = stream;
+  return UPDATE_STREAM_RATE;
 }
 
 void CommManager::update_system_id(uint16_t param_id)
@@ -182,15 +261,85 @@ void CommManager::send_param_value(uint16_t param_id)
   }
 }
 
+void CommManager::queue_param_value(uint16_t param_id)
+{
+  // Changes only mark the parameter dirty. A value that changes again before it goes out is sent once, and a burst
+  // of changes (such as a calibration) drains at the parameter link budget instead of all at once.
+  queue_params(param_id, 1);
+}
+
 void CommManager::param_request_list_callback(uint8_t target_system)
 {
   if (target_system == sysid_)
-    send_params_index_ = 0;
+    send_parameter_list();
+}
+
+void CommManager::param_request_range_callback(uint8_t target_system, uint16_t first_index, uint16_t count)
+{
+  if (target_system == sysid_)
+  {
+    if (count == 0)
+      param_table_requested_ = true;
+    else
+      queue_params(first_index, count);
+  }
+}
+
+void CommManager::blackbox_request_callback(uint8_t target_system, uint32_t offset, uint32_t length)
+{
+  // the log can't be read back while it is being recorded
+  if (target_system == sysid_ && !RF_.state_manager_.state().armed)
+  {
+    blackbox_offset_ = offset;
+    blackbox_end_ = (length < UINT32_MAX - offset) ? offset + length : UINT32_MAX;
+    blackbox_requested_ = true;
+  }
 }
 
 void CommManager::send_parameter_list()
 {
-  send_params_index_ = 0;
+  queue_params(0, static_cast<uint16_t>(PARAMS_COUNT));
+}
+
+void CommManager::queue_params(uint16_t first, uint16_t count)
+{
+  if (first >= PARAMS_COUNT)
+    return;
+
+  // a transfer that starts from idle goes out in order from the first requested ID
+  if (num_params_pending_ == 0)
+    send_params_index_ = first;
+
+  uint16_t end = static_cast<uint16_t>(PARAMS_COUNT);
+  if (count < PARAMS_COUNT - first)
+    end = static_cast<uint16_t>(first + count);
+  for (uint16_t id = first; id < end; id++)
+  {
+    uint32_t bit = 1u << (id % 32);
+    if (!(params_pending_[id / 32] & bit))
+    {
+      params_pending_[id / 32] |= bit;
+      num_params_pending_++;
+    }
+  }
+}
+
+uint16_t CommManager::take_pending_param(void)
+{
+  for (uint16_t n = 0; n < PARAMS_COUNT; n++)
+  {
+    uint16_t id = send_params_index_;
+    send_params_index_ = static_cast<uint16_t>((send_params_index_ + 1) % PARAMS_COUNT);
+
+    uint32_t bit = 1u << (id % 32);
+    if (params_pending_[id / 32] & bit)
+    {
+      params_pending_[id / 32] &= ~bit;
+      num_params_pending_--;
+      return id;
+    }
+  }
+  return static_cast<uint16_t>(PARAMS_COUNT);
 }
 
 void CommManager::param_request_read_callback(uint8_t target_system, const char* const param_name, int16_t param_index)
@@ -279,6 +428,9 @@ void CommManager::command_callback(CommLinkInterface::Command command)
     case CommLinkInterface::Command::COMMAND_SEND_VERSION:
       comm_link_.send_version(sysid_, GIT_VERSION_STRING);
       break;
+    case CommLinkInterface::Command::COMMAND_BLACKBOX_ERASE:
+      result = RF_.blackbox_.erase();
+      break;
     }
   }
 
@@ -297,7 +449,32 @@ void CommManager::timesync_callback(int64_t tc1, int64_t ts1)
   uint64_t now_us = RF_.board_.clock_micros();
 
   if (tc1 == 0) // check that this is a request, not a response
+  {
     comm_link_.send_timesync(sysid_, static_cast<int64_t>(now_us) * 1000, ts1);
+    timesync_.add_one_way(now_us, static_cast<uint64_t>(ts1 / 1000));
+  }
+  else if (timesync_request_us_ != 0 && ts1 == static_cast<int64_t>(timesync_request_us_) * 1000)
+  {
+    // the reply to our own request
+    timesync_.add_round_trip(timesync_request_us_, now_us, static_cast<uint64_t>(tc1 / 1000));
+    timesync_request_us_ = 0;
+  }
+  else
+  {
+    return;
+  }
+
+  if (timesync_.resyncs() != timesync_resyncs_)
+  {
+    log(CommLinkInterface::LogSeverity::LOG_WARNING, LOG_MSG_TIMESYNC_RESYNC);
+    timesync_resyncs_ = timesync_.resyncs();
+  }
+  else if (timesync_.valid() && !timesync_locked_)
+  {
+    log(CommLinkInterface::LogSeverity::LOG_INFO, LOG_MSG_TIMESYNC_LOCKED,
+        static_cast<int32_t>(timesync_.skew() * 1e6f));
+  }
+  timesync_locked_ = timesync_.valid();
 }
 
 void CommManager::offboard_control_callback(const CommLinkInterface::OffboardControl& control)
@@ -338,11 +515,68 @@ void CommManager::offboard_control_callback(const CommLinkInterface::OffboardCon
     break;
   }
 
+  // Stamped commands time out OFFBOARD_TIMEOUT after they were generated, rather than after they arrived
+  uint64_t now_us = RF_.board_.clock_micros();
+  uint64_t generated_us = now_us;
+  if (control.stamp_us != 0 && timesync_.valid())
+  {
+    uint64_t local_stamp_us = timesync_.to_local(control.stamp_us);
+    if (local_stamp_us < now_us)
+      generated_us = local_stamp_us; // and a stamp slightly in the future is sync error, so it counts as new
+
+    uint64_t age_us = now_us - generated_us;
+    int32_t max_age_ms = RF_.params_.get_param_int(PARAM_OFFBOARD_MAX_AGE);
+    if (max_age_ms > 0 && age_us > static_cast<uint64_t>(max_age_ms) * 1000)
+    {
+      // keep flying the previous command until it times out
+      stale_commands_++;
+      return;
+    }
+
+    uint32_t bin = static_cast<uint32_t>(age_us / COMMAND_AGE_BIN_US);
+    if (bin >= COMMAND_AGE_BINS)
+      bin = COMMAND_AGE_BINS - 1;
+    if (command_age_histogram_[bin] < UINT16_MAX)
+      command_age_histogram_[bin]++;
+    command_age_count_++;
+    command_age_sum_us_ += age_us;
+    if (age_us > command_age_max_us_)
+      command_age_max_us_ = static_cast<uint32_t>(age_us < UINT32_MAX ? age_us : UINT32_MAX);
+  }
+
   // Tell the command_manager that we have a new command we need to mux
-  new_offboard_command.stamp_ms = RF_.board_.clock_millis();
+  new_offboard_command.stamp_ms = static_cast<uint32_t>(generated_us / 1000);
   RF_.command_manager_.set_new_offboard_command(new_offboard_command);
 }
 
+CommManager::CommandAgeStats CommManager::command_age_stats() const
+{
+  CommandAgeStats stats;
+  stats.count = command_age_count_;
+  stats.stale = stale_commands_;
+  stats.mean_ms = 0.0f;
+  stats.p95_ms = 0.0f;
+  stats.max_ms = static_cast<float>(command_age_max_us_) * 1e-3f;
+  if (command_age_count_ == 0)
+    return stats;
+
+  stats.mean_ms = static_cast<float>(command_age_sum_us_ / command_age_count_) * 1e-3f;
+  uint32_t below_p95 = (command_age_count_ * 95 + 99) / 100;
+  uint32_t seen = 0;
+  for (uint8_t bin = 0; bin < COMMAND_AGE_BINS; bin++)
+  {
+    seen += command_age_histogram_[bin];
+    if (seen >= below_p95)
+    {
+      stats.p95_ms = static_cast<float>((bin + 1) * COMMAND_AGE_BIN_US) * 1e-3f;
+      break;
+    }
+  }
+  if (stats.p95_ms > stats.max_ms)
+    stats.p95_ms = stats.max_ms;
+  return stats;
+}
+
 void CommManager::aux_command_callback(const CommLinkInterface::AuxCommand& command)
 {
   Mixer::aux_command_t new_aux_command;
@@ -399,26 +633,11 @@ void CommManager::heartbeat_callback(void)
 // function definitions
 void CommManager::receive(void)
 {
+  // parameters set by the messages in one read (e.g. a ground station uploading a saved set) reach the listeners as
+  // one batch once everything received has been handled
+  RF_.params_.begin_transaction();
   comm_link_.receive();
-}
-
-void CommManager::log(CommLinkInterface::LogSeverity severity, const char* fmt, ...)
-{
-  // Convert the format string to a raw char array
-  va_list args;
-  va_start(args, fmt);
-  char text[LOG_MSG_SIZE];
-  rosflight_firmware::nanoprintf::tfp_sprintf(text, fmt, args);
-  va_end(args);
-
-  if (initialized_ && connected_)
-  {
-    comm_link_.send_log_message(sysid_, severity, text);
-  }
-  else
-  {
-    log_buffer_.add_message(severity, text);
-  }
+  RF_.params_.commit_transaction();
 }
 
 void CommManager::send_heartbeat(void)
@@ -447,8 +666,8 @@ void CommManager::send_status(void)
 
 void CommManager::send_attitude(void)
 {
-  comm_link_.send_attitude_quaternion(sysid_, RF_.estimator_.state().timestamp_us, RF_.estimator_.state().attitude,
-                                      RF_.estimator_.state().angular_velocity);
+  comm_link_.send_attitude_quaternion(sysid_, telemetry_stamp(RF_.estimator_.state().timestamp_us),
+                                      RF_.estimator_.state().attitude, RF_.estimator_.state().angular_velocity);
 }
 
 void CommManager::send_imu(void)
@@ -456,7 +675,15 @@ void CommManager::send_imu(void)
   turbomath::Vector acc, gyro;
   uint64_t stamp_us;
   RF_.sensors_.get_filtered_IMU(acc, gyro, stamp_us);
-  comm_link_.send_imu(sysid_, stamp_us, acc, gyro, RF_.sensors_.data().imu_temperature);
+  comm_link_.send_imu(sysid_, telemetry_stamp(stamp_us), acc, gyro, RF_.sensors_.data().imu_temperature);
+}
+
+void CommManager::send_imu_batch(void)
+{
+  Sensors::ImuSample samples[CommLinkInterface::IMU_BATCH_MAX_SAMPLES];
+  uint8_t count = RF_.sensors_.read_imu_samples(samples, CommLinkInterface::IMU_BATCH_MAX_SAMPLES);
+  if (count > 0)
+    comm_link_.send_imu_batch(sysid_, samples, count);
 }
 
 void CommManager::send_output_raw(void)
@@ -558,78 +785,361 @@ void CommManager::send_gnss_full()
   }
 }
 
-void CommManager::send_low_priority(void)
+void CommManager::send_stream_stats(void)
 {
-  send_next_param();
+  // one stream per call keeps the report itself from hogging the link
+  const Stream& s = streams_[next_stats_stream_];
+  send_named_value_float(STREAM_STATS_NAMES[next_stats_stream_][0], s.achieved_rate_hz_);
+  send_named_value_int(STREAM_STATS_NAMES[next_stats_stream_][1], static_cast<int32_t>(s.dropped_));
+  next_stats_stream_ = static_cast<uint8_t>((next_stats_stream_ + 1) % STREAM_COUNT);
+}
 
+void CommManager::send_command_age(void)
+{
+  if (command_age_count_ > 0 || stale_commands_ > 0)
+  {
+    CommandAgeStats stats = command_age_stats();
+    send_named_value_float("cmdage_avg", stats.mean_ms);
+    send_named_value_float("cmdage_p95", stats.p95_ms);
+    send_named_value_float("cmdage_max", stats.max_ms);
+    send_named_value_int("cmd_stale", static_cast<int32_t>(stats.stale));
+  }
+
+  memset(command_age_histogram_, 0, sizeof(command_age_histogram_));
+  command_age_count_ = 0;
+  stale_commands_ = 0;
+  command_age_sum_us_ = 0;
+  command_age_max_us_ = 0;
+}
+
+void CommManager::send_low_priority(void)
+{
   // send buffered log messages
   if (connected_ && !log_buffer_.empty())
   {
     const LogMessageBuffer::LogMessage& msg = log_buffer_.oldest();
-    comm_link_.send_log_message(sysid_, msg.severity, msg.msg);
+    CommLinkInterface::LogSeverity severity = static_cast<CommLinkInterface::LogSeverity>(msg.severity);
+    if (RF_.params_.get_param_int(PARAM_LOG_BINARY))
+    {
+      comm_link_.send_log_record(sysid_, severity, msg.id, msg.args, msg.arg_count);
+    }
+    else
+    {
+      char text[LOG_MSG_SIZE];
+      format_log_message(text, LOG_FORMATS[msg.id], msg.args[0], msg.args[1], msg.args[2]);
+      comm_link_.send_log_message(sysid_, severity, text);
+    }
     log_buffer_.pop();
   }
+
+  uint64_t time_us = RF_.board_.clock_micros();
+  if (connected_ && time_us >= next_timesync_request_us_)
+  {
+    comm_link_.send_timesync(sysid_, 0, static_cast<int64_t>(time_us) * 1000);
+    timesync_request_us_ = time_us;
+    next_timesync_request_us_ = time_us + TIMESYNC_REQUEST_PERIOD_US;
+  }
+
+  if (time_us >= command_age_window_end_us_)
+  {
+    send_command_age();
+    command_age_window_end_us_ = time_us + COMMAND_AGE_WINDOW_US;
+  }
+}
+
+uint64_t CommManager::telemetry_stamp(uint64_t stamp_us) const
+{
+  if (RF_.params_.get_param_int(PARAM_TIMESYNC_STAMP) && timesync_.valid())
+    return timesync_.to_remote(stamp_us);
+  return stamp_us;
 }
 
 // function definitions
 void CommManager::stream()
 {
   uint64_t time_us = RF_.board_.clock_micros();
-  for (int i = 0; i < STREAM_COUNT; i++)
+  if (time_us >= next_deadline_us_)
+    send_due_streams(time_us);
+  if (num_params_pending_ > 0 || param_table_requested_ || blackbox_requested_)
+    send_pending_params(time_us);
+
+  if (time_us - stats_window_start_us_ >= STATS_WINDOW_US)
   {
-    streams_[i].stream(time_us);
+    for (int i = 0; i < STREAM_COUNT; i++)
+      streams_[i].update_stats(time_us - stats_window_start_us_);
+    stats_window_start_us_ = time_us;
   }
+
   RF_.board_.serial_flush();
 }
 
+void CommManager::send_due_streams(uint64_t time_us)
+{
+  // Refill the link budget for the elapsed time, then charge everything sent since the last call (including
+  // traffic from outside the streams, such as parameter replies and acks)
+  uint32_t tx_bytes = comm_link_.tx_byte_count();
+  tx_tokens_ += static_cast<float>(time_us - last_stream_time_us_) * 1e-6f * link_budget_bytes_per_s_;
+  tx_tokens_ -= static_cast<float>(tx_bytes - last_tx_byte_count_);
+  float burst_bytes = tx_burst_bytes(link_budget_bytes_per_s_);
+  if (tx_tokens_ > burst_bytes)
+    tx_tokens_ = burst_bytes;
+  last_stream_time_us_ = time_us;
+
+  bool reallocate = false;
+  next_deadline_us_ = UINT64_MAX;
+  for (int i = 0; i < STREAM_COUNT; i++)
+  {
+    Stream& s = streams_[stream_order_[i]];
+    if (s.scheduled_period_us_ == 0)
+      continue;
+    if (time_us < s.next_time_us_)
+    {
+      if (s.next_time_us_ < next_deadline_us_)
+        next_deadline_us_ = s.next_time_us_;
+      continue;
+    }
+
+    s.dropped_ += s.advance(time_us);
+    if (s.next_time_us_ < next_deadline_us_)
+      next_deadline_us_ = s.next_time_us_;
+    if (s.frame_bytes_ > tx_tokens_)
+    {
+      s.dropped_++;
+      continue;
+    }
+
+    (this->*s.send_function_)();
+
+    uint32_t sent_bytes = comm_link_.tx_byte_count() - tx_bytes;
+    tx_bytes += sent_bytes;
+    tx_tokens_ -= static_cast<float>(sent_bytes);
+    if (sent_bytes > 0)
+    {
+      s.sent_++;
+      s.window_sent_++;
+      if (sent_bytes > s.frame_bytes_)
+      {
+        s.frame_bytes_ = static_cast<uint16_t>(sent_bytes);
+        reallocate = true;
+      }
+    }
+  }
+  last_tx_byte_count_ = tx_bytes;
+
+  if (reallocate)
+    allocate_stream_bandwidth();
+}
+
+float CommManager::tx_burst_bytes(float bytes_per_s) const
+{
+  float burst_bytes = bytes_per_s * static_cast<float>(TX_BURST_US) * 1e-6f;
+  if (burst_bytes < MIN_TX_BURST_BYTES)
+    burst_bytes = MIN_TX_BURST_BYTES;
+  return burst_bytes;
+}
+
+void CommManager::send_pending_params(uint64_t time_us)
+{
+  param_tokens_ += static_cast<float>(time_us - last_param_time_us_) * 1e-6f * param_budget_bytes_per_s_;
+  float burst_bytes = tx_burst_bytes(param_budget_bytes_per_s_);
+  if (param_tokens_ > burst_bytes)
+    param_tokens_ = burst_bytes;
+  last_param_time_us_ = time_us;
+
+  uint32_t tx_bytes = comm_link_.tx_byte_count();
+  while (param_tokens_ > 0.0f)
+  {
+    bool param_value = false;
+    bool blackbox_data = false;
+    if (param_table_requested_)
+    {
+      send_param_table();
+      param_table_requested_ = false;
+    }
+    else if (num_params_pending_ > 0 && param_tokens_ >= param_frame_bytes_)
+    {
+      send_param_value(take_pending_param());
+      param_value = true;
+    }
+    else if (num_params_pending_ == 0 && blackbox_requested_ && param_tokens_ >= blackbox_frame_bytes_)
+    {
+      if (!send_blackbox_data())
+        break;
+      blackbox_data = true;
+    }
+    else
+      break;
+
+    // these bytes come out of the parameter budget, so keep send_due_streams() from charging them to the streams
+    uint32_t sent_bytes = comm_link_.tx_byte_count() - tx_bytes;
+    tx_bytes += sent_bytes;
+    param_tokens_ -= static_cast<float>(sent_bytes);
+    last_tx_byte_count_ += sent_bytes;
+    if (param_value && sent_bytes > param_frame_bytes_)
+      param_frame_bytes_ = static_cast<uint16_t>(sent_bytes);
+    if (blackbox_data && sent_bytes > blackbox_frame_bytes_)
+      blackbox_frame_bytes_ = static_cast<uint16_t>(sent_bytes);
+  }
+}
+
+bool CommManager::send_blackbox_data(void)
+{
+  uint32_t used_bytes = static_cast<uint32_t>(RF_.blackbox_.used_bytes());
+  uint32_t end = (blackbox_end_ < used_bytes) ? blackbox_end_ : used_bytes;
+
+  uint8_t data[CommLinkInterface::BLACKBOX_DATA_MAX_BYTES];
+  uint8_t count = 0;
+  if (blackbox_offset_ < end)
+  {
+    count = CommLinkInterface::BLACKBOX_DATA_MAX_BYTES;
+    if (end - blackbox_offset_ < count)
+      count = static_cast<uint8_t>(end - blackbox_offset_);
+    if (!RF_.blackbox_.read(blackbox_offset_, data, count))
+      return false; // the storage is busy, try again next time
+  }
+
+  comm_link_.send_blackbox_data(sysid_, blackbox_offset_, used_bytes, data, count);
+  blackbox_offset_ += count;
+  if (blackbox_offset_ >= end)
+    blackbox_requested_ = false;
+  return true;
+}
+
+void CommManager::send_param_table(void)
+{
+  static constexpr uint8_t BLOCK_SIZE = CommLinkInterface::PARAM_TABLE_BLOCK_SIZE;
+  static constexpr uint8_t BLOCK_COUNT = (PARAMS_COUNT + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  static_assert(BLOCK_COUNT <= CommLinkInterface::PARAM_TABLE_MAX_BLOCKS, "too many parameters for the table summary");
+
+  uint16_t block_checksums[BLOCK_COUNT];
+  for (uint8_t i = 0; i < BLOCK_COUNT; i++)
+    block_checksums[i] = RF_.params_.checksum(static_cast<uint16_t>(i * BLOCK_SIZE), BLOCK_SIZE);
+  comm_link_.send_param_table(sysid_, static_cast<uint16_t>(PARAMS_COUNT),
+                              RF_.params_.checksum(0, static_cast<uint16_t>(PARAMS_COUNT)), block_checksums,
+                              BLOCK_COUNT);
+}
+
 void CommManager::set_streaming_rate(uint8_t stream_id, int16_t param_id)
 {
   streams_[stream_id].set_rate(RF_.params_.get_param_int(param_id));
+  allocate_stream_bandwidth();
+  next_deadline_us_ = 0; // a newly enabled stream is due right away
 }
 
-void CommManager::send_named_value_int(const char* const name, int32_t value)
+CommManager::StreamStats CommManager::stream_stats(uint8_t stream_id) const
 {
-  comm_link_.send_named_value_int(sysid_, RF_.board_.clock_millis(), name, value);
+  StreamStats stats = {};
+  if (stream_id < STREAM_COUNT)
+  {
+    const Stream& s = streams_[stream_id];
+    stats.requested_period_us = s.period_us_;
+    stats.scheduled_period_us = s.scheduled_period_us_;
+    stats.frame_bytes = s.frame_bytes_;
+    stats.achieved_rate_hz = s.achieved_rate_hz_;
+    stats.sent = s.sent_;
+    stats.dropped = s.dropped_;
+  }
+  return stats;
 }
 
-void CommManager::send_named_value_float(const char* const name, float value)
+void CommManager::update_link_budget()
 {
-  comm_link_.send_named_value_float(sysid_, RF_.board_.clock_millis(), name, value);
+  // 8N1 framing puts 10 bits on the wire for every byte
+  float bytes_per_s = static_cast<float>(RF_.params_.get_param_int(PARAM_BAUD_RATE)) / 10.0f;
+  link_budget_bytes_per_s_ = bytes_per_s * RF_.params_.get_param_float(PARAM_STREAM_LINK_LOAD);
+  allocate_stream_bandwidth();
 }
 
-void CommManager::send_next_param(void)
+void CommManager::allocate_stream_bandwidth()
 {
-  if (send_params_index_ < PARAMS_COUNT)
+  // Hand out the link budget one priority level at a time. A level that does not fit gets all that is left,
+  // shared by slowing each of its streams down by the same factor; lower levels fall to the minimum rate.
+  float remaining = link_budget_bytes_per_s_;
+  for (uint8_t priority = 0; priority < PRIORITY_COUNT; priority++)
   {
-    send_param_value(static_cast<uint16_t>(send_params_index_));
-    send_params_index_++;
+    float demand = 0.0f;
+    for (int i = 0; i < STREAM_COUNT; i++)
+    {
+      const Stream& s = streams_[i];
+      if (s.priority_ == priority && s.period_us_ > 0)
+        demand += static_cast<float>(s.frame_bytes_) * 1e6f / static_cast<float>(s.period_us_);
+    }
+
+    float scale = 1.0f;
+    if (demand > remaining)
+      scale = (remaining > 0.0f) ? remaining / demand : 0.0f;
+    remaining -= demand * scale;
+
+    for (int i = 0; i < STREAM_COUNT; i++)
+    {
+      Stream& s = streams_[i];
+      if (s.priority_ != priority)
+        continue;
+
+      if (s.period_us_ == 0 || scale >= 1.0f)
+        s.scheduled_period_us_ = s.period_us_;
+      else if (scale * MAX_DEGRADED_PERIOD_US > s.period_us_)
+        s.scheduled_period_us_ = static_cast<uint32_t>(static_cast<float>(s.period_us_) / scale);
+      else
+        s.scheduled_period_us_ = (s.period_us_ > MAX_DEGRADED_PERIOD_US) ? s.period_us_ : MAX_DEGRADED_PERIOD_US;
+    }
   }
+
+  param_budget_bytes_per_s_ = remaining;
+  if (param_budget_bytes_per_s_ < MIN_PARAM_LINK_SHARE * link_budget_bytes_per_s_)
+    param_budget_bytes_per_s_ = MIN_PARAM_LINK_SHARE * link_budget_bytes_per_s_;
 }
 
-CommManager::Stream::Stream(uint32_t period_us, std::function<void(void)> send_function) :
+void CommManager::send_named_value_int(const char* const name, int32_t value)
+{
+  comm_link_.send_named_value_int(sysid_, RF_.board_.clock_millis(), name, value);
+}
+
+void CommManager::send_named_value_float(const char* const name, float value)
+{
+  comm_link_.send_named_value_float(sysid_, RF_.board_.clock_millis(), name, value);
+}
+
+CommManager::Stream::Stream(uint32_t period_us, StreamPriority priority, SendFunction send_function) :
   period_us_(period_us),
+  scheduled_period_us_(period_us),
   next_time_us_(0),
+  priority_(priority),
   send_function_(send_function)
 {
 }
 
-void CommManager::Stream::stream(uint64_t now_us)
+uint32_t CommManager::Stream::advance(uint64_t now_us)
 {
-  if (period_us_ > 0 && now_us >= next_time_us_)
+  if (next_time_us_ == 0)
   {
-    // if you fall behind, skip messages
-    do
-    {
-      next_time_us_ += period_us_;
-    } while (next_time_us_ < now_us);
+    // first deadline since the stream was (re)enabled
+    next_time_us_ = now_us + scheduled_period_us_;
+    return 0;
+  }
 
-    send_function_();
+  // if you fall behind, skip messages, and return how many were skipped
+  uint32_t skipped = 0;
+  next_time_us_ += scheduled_period_us_;
+  while (next_time_us_ < now_us)
+  {
+    next_time_us_ += scheduled_period_us_;
+    skipped++;
   }
+  return skipped;
+}
+
+void CommManager::Stream::update_stats(uint64_t window_us)
+{
+  achieved_rate_hz_ = static_cast<float>(window_sent_) * 1e6f / static_cast<float>(window_us);
+  window_sent_ = 0;
 }
 
 void CommManager::Stream::set_rate(uint32_t rate_hz)
 {
   period_us_ = (rate_hz == 0) ? 0 : 1000000 / rate_hz;
+  if (period_us_ == 0)
+    next_time_us_ = 0;
 }
 
 // void Mavlink::mavlink_send_named_command_struct(const char *const name, control_t command_struct)
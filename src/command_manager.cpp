@@ -67,16 +67,20 @@ void CommandManager::init()
 }
 
 void CommandManager::param_change_callback(uint16_t param_id)
+{
+  if (param_is_relevant(param_id))
+    init_failsafe();
+}
+
+bool CommandManager::param_is_relevant(uint16_t param_id) const
 {
   switch (param_id)
   {
   case PARAM_FIXED_WING:
   case PARAM_FAILSAFE_THROTTLE:
-    init_failsafe();
-    break;
+    return true;
   default:
-    // do nothing
-    break;
+    return false;
   }
 }
 
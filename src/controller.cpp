@@ -36,18 +36,49 @@
 
 #include "rosflight.h"
 
+#include <cmath>
 #include <cstdbool>
 #include <cstdint>
 
 namespace rosflight_firmware
 {
-Controller::Controller(ROSflight &rf) : RF_(rf) {}
+Controller::Controller(ROSflight &rf) :
+  RF_(rf),
+  attitude_control_type_(ATT_CONTROL_EULER),
+  rate_control_type_(RATE_CONTROL_PID)
+{
+}
 
 void Controller::init()
 {
   prev_time_us_ = 0;
 
-  float max = RF_.params_.get_param_float(PARAM_MAX_COMMAND);
+  attitude_control_type_ = static_cast<uint8_t>(RF_.params_.get_param_int(PARAM_ATTITUDE_CONTROL_TYPE));
+  if (attitude_control_type_ > ATT_CONTROL_TILT_PRIORITIZED)
+    attitude_control_type_ = ATT_CONTROL_EULER;
+
+  rate_control_type_ = static_cast<uint8_t>(RF_.params_.get_param_int(PARAM_RATE_CONTROL_TYPE));
+  if (rate_control_type_ > RATE_CONTROL_INDI)
+    rate_control_type_ = RATE_CONTROL_PID;
+
+  indi_rate_ = turbomath::Vector(0.0f, 0.0f, 0.0f);
+  indi_omega_dot_ = turbomath::Vector(0.0f, 0.0f, 0.0f);
+  indi_torque_lpf_ = turbomath::Vector(0.0f, 0.0f, 0.0f);
+  indi_torque_ = turbomath::Vector(0.0f, 0.0f, 0.0f);
+
+  max_command_ = RF_.params_.get_param_float(PARAM_MAX_COMMAND);
+  eq_torque_ = turbomath::Vector(RF_.params_.get_param_float(PARAM_X_EQ_TORQUE),
+                                 RF_.params_.get_param_float(PARAM_Y_EQ_TORQUE),
+                                 RF_.params_.get_param_float(PARAM_Z_EQ_TORQUE));
+  rate_kp_ = turbomath::Vector(RF_.params_.get_param_float(PARAM_PID_ROLL_RATE_P),
+                               RF_.params_.get_param_float(PARAM_PID_PITCH_RATE_P),
+                               RF_.params_.get_param_float(PARAM_PID_YAW_RATE_P));
+  indi_g_ = turbomath::Vector(RF_.params_.get_param_float(PARAM_INDI_G_ROLL),
+                              RF_.params_.get_param_float(PARAM_INDI_G_PITCH),
+                              RF_.params_.get_param_float(PARAM_INDI_G_YAW));
+  indi_alpha_ = RF_.params_.get_param_float(PARAM_INDI_ALPHA);
+
+  float max = max_command_;
   float min = -max;
   float tau = RF_.params_.get_param_float(PARAM_PID_TAU);
 
@@ -83,6 +114,13 @@ void Controller::run()
   }
   prev_time_us_ = RF_.estimator_.state().timestamp_us;
 
+  if (rate_control_type_ == RATE_CONTROL_INDI)
+  {
+    // Differentiate the bias-corrected raw gyro rather than the estimator's smoothed rates to keep the lag down
+    update_indi_filters(1e-6f * dt_us, RF_.sensors_.data().gyro - RF_.estimator_.bias(),
+                        RF_.mixer_.get_output_torque());
+  }
+
   // Check if integrators should be updated
   //! @todo better way to figure out if throttle is high
   bool update_integrators =
@@ -93,9 +131,9 @@ void Controller::run()
       run_pid_loops(dt_us, RF_.estimator_.state(), RF_.command_manager_.combined_control(), update_integrators);
 
   // Add feedforward torques
-  output_.x = pid_output.x + RF_.params_.get_param_float(PARAM_X_EQ_TORQUE);
-  output_.y = pid_output.y + RF_.params_.get_param_float(PARAM_Y_EQ_TORQUE);
-  output_.z = pid_output.z + RF_.params_.get_param_float(PARAM_Z_EQ_TORQUE);
+  output_.x = pid_output.x + eq_torque_.x;
+  output_.y = pid_output.y + eq_torque_.y;
+  output_.z = pid_output.z + eq_torque_.z;
   output_.F = RF_.command_manager_.combined_control().F.value;
 }
 
@@ -105,7 +143,7 @@ void Controller::calculate_equilbrium_torque_from_rc()
   if (!(RF_.state_manager_.state().armed))
   {
     // Tell the user that we are doing a equilibrium torque calibration
-    RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_WARNING, "Capturing equilbrium offsets from RC");
+    RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_WARNING, LOG_MSG_EQ_TORQUE_CAPTURING);
 
     // Prepare for calibration
     // artificially tell the flight controller it is leveled
@@ -119,10 +157,6 @@ void Controller::calculate_equilbrium_torque_from_rc()
     fake_state.attitude.z = 0.0f;
     fake_state.attitude.w = 1.0f;
 
-    fake_state.roll = 0.0f;
-    fake_state.pitch = 0.0f;
-    fake_state.yaw = 0.0f;
-
     // pass the rc_control through the controller
     // dt is zero, so what this really does is applies the P gain with the settings
     // your RC transmitter, which if it flies level is a really good guess for
@@ -130,21 +164,36 @@ void Controller::calculate_equilbrium_torque_from_rc()
     turbomath::Vector pid_output = run_pid_loops(0, fake_state, RF_.command_manager_.rc_control(), false);
 
     // the output from the controller is going to be the static offsets
+    RF_.params_.begin_transaction();
     RF_.params_.set_param_float(PARAM_X_EQ_TORQUE, pid_output.x + RF_.params_.get_param_float(PARAM_X_EQ_TORQUE));
     RF_.params_.set_param_float(PARAM_Y_EQ_TORQUE, pid_output.y + RF_.params_.get_param_float(PARAM_Y_EQ_TORQUE));
     RF_.params_.set_param_float(PARAM_Z_EQ_TORQUE, pid_output.z + RF_.params_.get_param_float(PARAM_Z_EQ_TORQUE));
+    RF_.params_.commit_transaction();
 
-    RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_WARNING, "Equilibrium torques found and applied.");
-    RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_WARNING, "Please zero out trims on your transmitter");
+    RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_WARNING, LOG_MSG_EQ_TORQUE_APPLIED);
+    RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_WARNING, LOG_MSG_EQ_TORQUE_ZERO_TRIMS);
   }
   else
   {
-    RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_WARNING,
-                          "Cannot perform equilibrium offset calibration while armed");
+    RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_WARNING, LOG_MSG_EQ_TORQUE_ARMED);
   }
 }
 
 void Controller::param_change_callback(uint16_t param_id)
+{
+  if (param_is_relevant(param_id))
+    init();
+}
+
+void Controller::param_batch_change_callback(const uint16_t *param_ids, uint16_t count)
+{
+  // every parameter the controller cares about feeds init(), so once is enough for any number of them
+  (void)param_ids;
+  if (count > 0)
+    init();
+}
+
+bool Controller::param_is_relevant(uint16_t param_id) const
 {
   switch (param_id)
   {
@@ -165,11 +214,18 @@ void Controller::param_change_callback(uint16_t param_id)
   case PARAM_PID_YAW_RATE_D:
   case PARAM_MAX_COMMAND:
   case PARAM_PID_TAU:
-    init();
-    break;
+  case PARAM_X_EQ_TORQUE:
+  case PARAM_Y_EQ_TORQUE:
+  case PARAM_Z_EQ_TORQUE:
+  case PARAM_INDI_ALPHA:
+  case PARAM_INDI_G_ROLL:
+  case PARAM_INDI_G_PITCH:
+  case PARAM_INDI_G_YAW:
+  case PARAM_ATTITUDE_CONTROL_TYPE:
+  case PARAM_RATE_CONTROL_TYPE:
+    return true;
   default:
-    // do nothing
-    break;
+    return false;
   }
 }
 
@@ -183,24 +239,52 @@ turbomath::Vector Controller::run_pid_loops(uint32_t dt_us,
 
   float dt = 1e-6 * dt_us;
 
-  // ROLL
-  if (command.x.type == RATE)
-    out.x = roll_rate_.run(dt, state.angular_velocity.x, command.x.value, update_integrators);
-  else if (command.x.type == ANGLE)
-    out.x = roll_.run(dt, state.roll, command.x.value, update_integrators, state.angular_velocity.x);
-  else
-    out.x = command.x.value;
-
-  // PITCH
-  if (command.y.type == RATE)
-    out.y = pitch_rate_.run(dt, state.angular_velocity.y, command.y.value, update_integrators);
-  else if (command.y.type == ANGLE)
-    out.y = pitch_.run(dt, state.pitch, command.y.value, update_integrators, state.angular_velocity.y);
+  if (attitude_control_type_ != ATT_CONTROL_EULER && command.x.type == ANGLE && command.y.type == ANGLE)
+  {
+    // Compute the body-frame attitude error directly from the quaternion and drive it to zero with the angle loops
+    turbomath::Vector error = attitude_error(state.attitude, command.x.value, command.y.value);
+    out.x = roll_.run(dt, 0.0f, error.x, update_integrators, state.angular_velocity.x);
+    out.y = pitch_.run(dt, 0.0f, error.y, update_integrators, state.angular_velocity.y);
+  }
   else
-    out.y = command.y.value;
+  {
+    // the angle loops here work on Euler angles, which are only extracted when an axis needs them
+    float roll = 0.0f;
+    float pitch = 0.0f;
+    if (command.x.type == ANGLE || command.y.type == ANGLE)
+    {
+      float yaw;
+      state.attitude.get_RPY(&roll, &pitch, &yaw);
+    }
+
+    // ROLL
+    if (command.x.type == RATE && rate_control_type_ == RATE_CONTROL_INDI)
+      out.x = run_indi(state.angular_velocity.x, command.x.value, rate_kp_.x, indi_g_.x, indi_omega_dot_.x,
+                       indi_torque_.x, eq_torque_.x);
+    else if (command.x.type == RATE)
+      out.x = roll_rate_.run(dt, state.angular_velocity.x, command.x.value, update_integrators);
+    else if (command.x.type == ANGLE)
+      out.x = roll_.run(dt, roll, command.x.value, update_integrators, state.angular_velocity.x);
+    else
+      out.x = command.x.value;
+
+    // PITCH
+    if (command.y.type == RATE && rate_control_type_ == RATE_CONTROL_INDI)
+      out.y = run_indi(state.angular_velocity.y, command.y.value, rate_kp_.y, indi_g_.y, indi_omega_dot_.y,
+                       indi_torque_.y, eq_torque_.y);
+    else if (command.y.type == RATE)
+      out.y = pitch_rate_.run(dt, state.angular_velocity.y, command.y.value, update_integrators);
+    else if (command.y.type == ANGLE)
+      out.y = pitch_.run(dt, pitch, command.y.value, update_integrators, state.angular_velocity.y);
+    else
+      out.y = command.y.value;
+  }
 
   // YAW
-  if (command.z.type == RATE)
+  if (command.z.type == RATE && rate_control_type_ == RATE_CONTROL_INDI)
+    out.z = run_indi(state.angular_velocity.z, command.z.value, rate_kp_.z, indi_g_.z, indi_omega_dot_.z,
+                     indi_torque_.z, eq_torque_.z);
+  else if (command.z.type == RATE)
     out.z = yaw_rate_.run(dt, state.angular_velocity.z, command.z.value, update_integrators);
   else
     out.z = command.z.value;
@@ -208,6 +292,84 @@ turbomath::Vector Controller::run_pid_loops(uint32_t dt_us,
   return out;
 }
 
+turbomath::Vector Controller::attitude_error(const turbomath::Quaternion &q, float roll_c, float pitch_c) const
+{
+  // Pull the heading out of the current attitude without any trig: the first column of the rotation matrix is the
+  // body x-axis expressed in the world frame, and the yaw quaternion is the half-angle rotation to its projection
+  float r11 = 1.0f - 2.0f * (q.y * q.y + q.z * q.z);
+  float r21 = 2.0f * (q.x * q.y + q.w * q.z);
+  float n = sqrtf(r11 * r11 + r21 * r21);
+  turbomath::Quaternion q_yaw;
+  if (n + r11 > 1e-6f)
+    q_yaw = turbomath::Quaternion(n + r11, 0.0f, 0.0f, r21).normalize();
+  else
+    q_yaw = turbomath::Quaternion(0.0f, 0.0f, 0.0f, 1.0f);
+
+  // Commanded attitude holds the current heading, so only roll and pitch produce an error
+  // turbomath composes quaternions in the reverse of Hamilton order, so a * b applies a first and then b
+  turbomath::Quaternion q_c = turbomath::Quaternion(roll_c, pitch_c, 0.0f) * q_yaw;
+
+  // Error rotation from the body frame to the commanded frame, taking the short way around
+  turbomath::Quaternion q_e = q_c * q.inverse();
+  if (q_e.w < 0.0f)
+  {
+    q_e.w = -q_e.w;
+    q_e.x = -q_e.x;
+    q_e.y = -q_e.y;
+    q_e.z = -q_e.z;
+  }
+
+  if (attitude_control_type_ == ATT_CONTROL_TILT_PRIORITIZED)
+  {
+    // Reduced attitude: only correct the angle between the current and commanded thrust axes (body z),
+    // so a large yaw error never steals control authority from tilt
+    turbomath::Vector e3(0.0f, 0.0f, 1.0f);
+    turbomath::Vector z_c = q_e.inverse().rotate(e3);
+    q_e = turbomath::Quaternion(e3, z_c);
+  }
+
+  return turbomath::Vector(2.0f * q_e.x, 2.0f * q_e.y, 2.0f * q_e.z);
+}
+
+void Controller::update_indi_filters(float dt, const turbomath::Vector &rate, const turbomath::Vector &torque)
+{
+  if (dt < 0.0001f)
+    return;
+
+  // Both signals go through the same two stages: the first is applied to the rate before differentiating it
+  const float alpha = indi_alpha_;
+  turbomath::Vector rate_lpf = indi_rate_ * alpha + rate * (1.0f - alpha);
+  turbomath::Vector omega_dot = (rate_lpf - indi_rate_) / dt;
+  indi_rate_ = rate_lpf;
+  indi_omega_dot_ = indi_omega_dot_ * alpha + omega_dot * (1.0f - alpha);
+
+  indi_torque_lpf_ = indi_torque_lpf_ * alpha + torque * (1.0f - alpha);
+  indi_torque_ = indi_torque_ * alpha + indi_torque_lpf_ * (1.0f - alpha);
+}
+
+float Controller::run_indi(float rate,
+                           float rate_c,
+                           float kp,
+                           float g,
+                           float omega_dot,
+                           float torque,
+                           float eq_torque) const
+{
+  if (g <= 0.0f)
+    return 0.0f;
+
+  // The desired angular acceleration comes from the rate error, scaled so the rate P gains keep their units. The
+  // increment on top of the applied torque cancels whatever acceleration the vehicle is actually seeing, so model
+  // error and disturbances are rejected without an integrator.
+  float nu = g * kp * (rate_c - rate);
+  float u = torque + (nu - omega_dot) / g;
+
+  // The applied torque already contains the equilibrium offset that run() adds back on
+  u -= eq_torque;
+
+  return (u > max_command_) ? max_command_ : (u < -max_command_) ? -max_command_ : u;
+}
+
 Controller::PID::PID() :
   kp_(0.0f),
   ki_(0.0f),
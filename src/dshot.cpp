@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2017, James Jackson and Daniel Koch, BYU MAGICC Lab
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "dshot.h"
+
+#include <cstdbool>
+#include <cstdint>
+
+namespace rosflight_firmware
+{
+namespace
+{
+// 5-bit GCR symbol to nibble, 0xFF marks symbols that are never sent
+const uint8_t gcr_decode_table[32] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x9,  0xA,
+                                      0xB,  0xFF, 0xD,  0xE,  0xF,  0xFF, 0xFF, 0x2,  0x3,  0xFF, 0x5,
+                                      0x6,  0x7,  0xFF, 0x0,  0x8,  0x1,  0xFF, 0x4,  0xC,  0xFF};
+
+uint8_t dshot_crc(uint16_t packet)
+{
+  return (packet ^ (packet >> 4) ^ (packet >> 8)) & 0x0F;
+}
+} // namespace
+
+uint16_t dshot_encode_frame(uint16_t value, bool telemetry_request, bool bidirectional)
+{
+  uint16_t packet = static_cast<uint16_t>(((value & 0x07FF) << 1) | (telemetry_request ? 1 : 0));
+  uint8_t crc = dshot_crc(packet);
+  if (bidirectional)
+    crc = ~crc & 0x0F;
+  return static_cast<uint16_t>((packet << 4) | crc);
+}
+
+uint16_t dshot_throttle_to_value(float throttle)
+{
+  if (throttle <= 0.0f)
+    return DSHOT_CMD_MOTOR_STOP;
+  if (throttle >= 1.0f)
+    return DSHOT_MAX_THROTTLE;
+  return static_cast<uint16_t>(DSHOT_MIN_THROTTLE + throttle * (DSHOT_MAX_THROTTLE - DSHOT_MIN_THROTTLE) + 0.5f);
+}
+
+bool dshot_decode_erpm(uint32_t gcr_frame, uint32_t *period_us)
+{
+  // The reply is transition encoded: every 1 in the GCR stream is an edge on the wire
+  uint32_t gcr = (gcr_frame ^ (gcr_frame >> 1)) & 0xFFFFF;
+
+  uint16_t value = 0;
+  for (int8_t shift = 15; shift >= 0; shift -= 5)
+  {
+    uint8_t nibble = gcr_decode_table[(gcr >> shift) & 0x1F];
+    if (nibble == 0xFF)
+      return false;
+    value = static_cast<uint16_t>((value << 4) | nibble);
+  }
+
+  // The 4-bit CRC is the inverted XOR of the other three nibbles, so all four XOR to 0xF
+  if (((value ^ (value >> 4) ^ (value >> 8) ^ (value >> 12)) & 0x0F) != 0x0F)
+    return false;
+
+  // eeem mmmm mmmm: 9-bit mantissa shifted left by a 3-bit exponent, all ones means the motor is stopped
+  uint16_t payload = value >> 4;
+  if (payload == 0x0FFF)
+    *period_us = 0;
+  else
+    *period_us = static_cast<uint32_t>(payload & 0x01FF) << (payload >> 9);
+  return true;
+}
+
+float dshot_period_to_rpm(uint32_t period_us, uint8_t motor_poles)
+{
+  if (period_us == 0 || motor_poles < 2)
+    return 0.0f;
+
+  // One electrical revolution per pole pair
+  return 60.0e6f / static_cast<float>(period_us) / static_cast<float>(motor_poles / 2);
+}
+
+} // namespace rosflight_firmware
@@ -48,9 +48,6 @@ void Estimator::reset_state()
   state_.angular_velocity.y = 0.0f;
   state_.angular_velocity.z = 0.0f;
 
-  state_.roll = 0.0f;
-  state_.pitch = 0.0f;
-  state_.yaw = 0.0f;
 
   w1_.x = 0.0f;
   w1_.y = 0.0f;
@@ -220,9 +217,6 @@ void Estimator::run()
   // Post-Processing
   //
 
-  // Extract Euler Angles for controller
-  state_.attitude.get_RPY(&state_.roll, &state_.pitch, &state_.yaw);
-
   // Save off adjust gyro measurements with estimated biases for control
   state_.angular_velocity = gyro_LPF_ - bias_;
 
@@ -31,39 +31,121 @@
 
 #include "mixer.h"
 
+#include "dshot.h"
 #include "rosflight.h"
 
+#include <cmath>
 #include <cstdint>
 
 namespace rosflight_firmware
 {
+constexpr Mixer::mixer_t Mixer::esc_calibration_mixing;
+constexpr Mixer::mixer_t Mixer::quadcopter_plus_mixing;
+constexpr Mixer::mixer_t Mixer::quadcopter_x_mixing;
+constexpr Mixer::mixer_t Mixer::hex_plus_mixing;
+constexpr Mixer::mixer_t Mixer::hex_x_mixing;
+constexpr Mixer::mixer_t Mixer::octocopter_plus_mixing;
+constexpr Mixer::mixer_t Mixer::octocopter_x_mixing;
+constexpr Mixer::mixer_t Mixer::Y6_mixing;
+constexpr Mixer::mixer_t Mixer::X8_mixing;
+constexpr Mixer::mixer_t Mixer::tricopter_mixing;
+constexpr Mixer::mixer_t Mixer::fixedwing_mixing;
+constexpr Mixer::mixer_t Mixer::passthrough_mixing;
+
+const Mixer::mix_kernel_t Mixer::mix_kernels_[NUM_MIXER_OUTPUTS + 1] = {
+    &Mixer::mix_kernel<0>, &Mixer::mix_kernel<1>, &Mixer::mix_kernel<2>, &Mixer::mix_kernel<3>, &Mixer::mix_kernel<4>,
+    &Mixer::mix_kernel<5>, &Mixer::mix_kernel<6>, &Mixer::mix_kernel<7>, &Mixer::mix_kernel<8>};
+
 Mixer::Mixer(ROSflight &_rf) : RF_(_rf)
 {
+  for (uint8_t i = 0; i < NUM_MIXER_OUTPUTS; i++)
+  {
+    custom_mixing_.output_type[i] = NONE;
+    custom_mixing_.F[i] = 0.0f;
+    custom_mixing_.x[i] = 0.0f;
+    custom_mixing_.y[i] = 0.0f;
+    custom_mixing_.z[i] = 0.0f;
+  }
+  custom_mixing_.default_pwm_rate = 50;
+
+  dshot_enabled_ = false;
+  dshot_bidirectional_ = false;
+  dshot_mask_ = 0;
+  for (uint8_t i = 0; i < NUM_TOTAL_OUTPUTS; i++)
+  {
+    pwm_outputs_[i] = 0.0f;
+    pwm_output_type_[i] = NONE;
+    dshot_frames_[i] = 0;
+    motor_rpm_[i] = 0.0f;
+  }
+
   mixer_to_use_ = nullptr;
+  mix_kernel_ = mix_kernels_[0];
+  num_mixer_outputs_ = 0;
+  init_torque_inverse();
+
+  for (uint8_t i = 0; i < THRUST_LUT_SIZE; i++)
+    thrust_lut_[i] = static_cast<float>(i) / (THRUST_LUT_SIZE - 1);
+  thrust_model_ = 0.0f;
+  for (uint8_t i = 0; i < NUM_MIXER_OUTPUTS; i++)
+    thrust_outputs_[i] = 0.0f;
 }
 
 void Mixer::init()
 {
   init_mixing();
+  init_thrust_lut();
 }
 
 void Mixer::param_change_callback(uint16_t param_id)
+{
+  apply_param_updates(param_updates(param_id));
+}
+
+void Mixer::param_batch_change_callback(const uint16_t *param_ids, uint16_t count)
+{
+  uint8_t updates = 0;
+  for (uint16_t i = 0; i < count; i++)
+    updates = static_cast<uint8_t>(updates | param_updates(param_ids[i]));
+  apply_param_updates(updates);
+}
+
+bool Mixer::param_is_relevant(uint16_t param_id) const
+{
+  return param_updates(param_id) != 0;
+}
+
+uint8_t Mixer::param_updates(uint16_t param_id) const
 {
   switch (param_id)
   {
   case PARAM_MIXER:
-    init_mixing();
-    break;
+    return UPDATE_MIXING;
   case PARAM_MOTOR_PWM_SEND_RATE:
   case PARAM_RC_TYPE:
-    init_PWM();
-    break;
+  case PARAM_MOTOR_PROTOCOL:
+  case PARAM_DSHOT_BIDIRECTIONAL:
+    return UPDATE_PWM;
+  case PARAM_MOTOR_THRUST_MODEL:
+    return UPDATE_THRUST_LUT;
   default:
-    // do nothing
-    break;
+    if (param_id >= PARAM_CUSTOM_MIXER_TYPES && param_id <= PARAM_CUSTOM_MIXER_Z_7)
+      return UPDATE_CUSTOM_MIXING;
+    return 0;
   }
 }
 
+void Mixer::apply_param_updates(uint8_t updates)
+{
+  if ((updates & UPDATE_MIXING)
+      || ((updates & UPDATE_CUSTOM_MIXING) && RF_.params_.get_param_int(PARAM_MIXER) == CUSTOM))
+    init_mixing();
+  if (updates & UPDATE_PWM)
+    init_PWM();
+  if (updates & UPDATE_THRUST_LUT)
+    init_thrust_lut();
+}
+
 void Mixer::init_mixing()
 {
   // clear the invalid mixer error
@@ -73,24 +155,45 @@ void Mixer::init_mixing()
 
   if (mixer_choice >= NUM_MIXERS)
   {
-    RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, "Invalid Mixer Choice");
+    RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, LOG_MSG_INVALID_MIXER);
 
     // set the invalid mixer flag
     RF_.state_manager_.set_error(StateManager::ERROR_INVALID_MIXER);
     mixer_to_use_ = nullptr;
   }
+  else if (mixer_choice == CUSTOM && !load_custom_mixer())
+  {
+    // set the invalid mixer flag
+    RF_.state_manager_.set_error(StateManager::ERROR_INVALID_MIXER);
+    mixer_to_use_ = nullptr;
+  }
   else
   {
     mixer_to_use_ = array_of_mixers_[mixer_choice];
   }
 
+  // Only run the kernel over the outputs up to the last one the mixer drives
+  num_mixer_outputs_ = 0;
+  if (mixer_to_use_ != nullptr)
+  {
+    for (uint8_t i = 0; i < NUM_MIXER_OUTPUTS; i++)
+    {
+      if (mixer_to_use_->output_type[i] != NONE)
+        num_mixer_outputs_ = i + 1;
+    }
+  }
+  mix_kernel_ = mix_kernels_[num_mixer_outputs_];
+
   init_PWM();
+  init_torque_inverse();
 
   for (int8_t i = 0; i < NUM_TOTAL_OUTPUTS; i++)
   {
     raw_outputs_[i] = 0.0f;
     outputs_[i] = 0.0f;
   }
+  for (uint8_t i = 0; i < NUM_MIXER_OUTPUTS; i++)
+    thrust_outputs_[i] = 0.0f;
 }
 
 void Mixer::init_PWM()
@@ -106,6 +209,296 @@ void Mixer::init_PWM()
     RF_.board_.pwm_init(50, 0);
   else
     RF_.board_.pwm_init(refresh_rate, off_pwm);
+
+  init_dshot();
+}
+
+void Mixer::init_dshot()
+{
+  dshot_enabled_ = false;
+  dshot_mask_ = 0;
+  for (uint8_t i = 0; i < NUM_TOTAL_OUTPUTS; i++)
+    motor_rpm_[i] = 0.0f;
+
+  int protocol = RF_.params_.get_param_int(PARAM_MOTOR_PROTOCOL);
+  if (protocol == 0 || mixer_to_use_ == nullptr)
+    return;
+
+  static const uint16_t bitrates_kbps[] = {150, 300, 600};
+  if (protocol < 0 || protocol > 3)
+  {
+    RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, LOG_MSG_INVALID_MOTOR_PROTOCOL);
+    return;
+  }
+
+  // Only the mixer's motor outputs are driven digitally, servos and aux outputs stay on PWM
+  for (uint8_t i = 0; i < NUM_MIXER_OUTPUTS; i++)
+  {
+    if (mixer_to_use_->output_type[i] == M)
+      dshot_mask_ |= (1 << i);
+  }
+
+  dshot_bidirectional_ = RF_.params_.get_param_int(PARAM_DSHOT_BIDIRECTIONAL);
+  if (RF_.board_.dshot_init(bitrates_kbps[protocol - 1], dshot_bidirectional_, dshot_mask_))
+  {
+    dshot_enabled_ = true;
+  }
+  else
+  {
+    dshot_mask_ = 0;
+    RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, LOG_MSG_DSHOT_UNSUPPORTED);
+  }
+}
+
+void Mixer::update_dshot()
+{
+  RF_.board_.dshot_write(dshot_frames_, NUM_TOTAL_OUTPUTS);
+
+  if (!dshot_bidirectional_)
+    return;
+
+  // Telemetry arrives in reply to the previous frame, so RPM lags the command by one loop
+  uint8_t poles = static_cast<uint8_t>(RF_.params_.get_param_int(PARAM_MOTOR_POLES));
+  for (uint8_t i = 0; i < NUM_MIXER_OUTPUTS; i++)
+  {
+    uint32_t gcr_frame;
+    uint32_t period_us;
+    if ((dshot_mask_ & (1 << i)) && RF_.board_.dshot_read_telemetry(i, &gcr_frame)
+        && dshot_decode_erpm(gcr_frame, &period_us))
+      motor_rpm_[i] = dshot_period_to_rpm(period_us, poles);
+  }
+}
+
+bool Mixer::load_custom_mixer()
+{
+  mixer_t mixer;
+  uint32_t types = static_cast<uint32_t>(RF_.params_.get_param_int(PARAM_CUSTOM_MIXER_TYPES));
+  bool has_output = false;
+  bool has_motor = false;
+
+  for (uint8_t i = 0; i < NUM_MIXER_OUTPUTS; i++)
+  {
+    mixer.output_type[i] = static_cast<output_type_t>((types >> (2 * i)) & 0x03);
+    mixer.F[i] = RF_.params_.get_param_float(PARAM_CUSTOM_MIXER_F_0 + i);
+    mixer.x[i] = RF_.params_.get_param_float(PARAM_CUSTOM_MIXER_X_0 + i);
+    mixer.y[i] = RF_.params_.get_param_float(PARAM_CUSTOM_MIXER_Y_0 + i);
+    mixer.z[i] = RF_.params_.get_param_float(PARAM_CUSTOM_MIXER_Z_0 + i);
+
+    if (mixer.output_type[i] == NONE)
+    {
+      mixer.F[i] = mixer.x[i] = mixer.y[i] = mixer.z[i] = 0.0f;
+      continue;
+    }
+
+    // Reject anything that would put a NaN or a runaway value on an output
+    if (!std::isfinite(mixer.F[i]) || !std::isfinite(mixer.x[i]) || !std::isfinite(mixer.y[i])
+        || !std::isfinite(mixer.z[i]))
+    {
+      RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, LOG_MSG_CUSTOM_MIXER_NOT_FINITE, i);
+      return false;
+    }
+    if (mixer.output_type[i] == M && mixer.F[i] < 0.0f)
+    {
+      RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, LOG_MSG_CUSTOM_MIXER_NEGATIVE_THRUST, i);
+      return false;
+    }
+
+    has_output = true;
+    has_motor |= (mixer.output_type[i] == M);
+  }
+
+  if (types >> (2 * NUM_MIXER_OUTPUTS) != 0 || !has_output)
+  {
+    RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, LOG_MSG_CUSTOM_MIXER_INVALID_TYPES);
+    return false;
+  }
+
+  // Normalize each column so its largest coefficient is 1, matching the built-in mixers. This keeps controller gains
+  // meaningful across airframes and is done once here so mix_output() is the same loop for every mixer.
+  float *columns[4] = {mixer.F, mixer.x, mixer.y, mixer.z};
+  for (uint8_t c = 0; c < 4; c++)
+  {
+    float max = 0.0f;
+    for (uint8_t i = 0; i < NUM_MIXER_OUTPUTS; i++)
+    {
+      float value = (columns[c][i] < 0.0f) ? -columns[c][i] : columns[c][i];
+      max = (value > max) ? value : max;
+    }
+    if (max > 0.0f)
+    {
+      for (uint8_t i = 0; i < NUM_MIXER_OUTPUTS; i++)
+        columns[c][i] /= max;
+    }
+  }
+
+  mixer.default_pwm_rate = has_motor ? 490 : 50;
+  custom_mixing_ = mixer;
+  return true;
+}
+
+void Mixer::init_torque_inverse()
+{
+  for (uint8_t i = 0; i < NUM_MIXER_OUTPUTS; i++)
+  {
+    torque_inv_x_[i] = 0.0f;
+    torque_inv_y_[i] = 0.0f;
+    torque_inv_z_[i] = 0.0f;
+  }
+
+  if (mixer_to_use_ == nullptr)
+    return;
+
+  // Least-squares inverse (B^T B)^-1 B^T of the allocation matrix B = [F x y z], so the torque estimate is exact for
+  // any full-rank mixer, including ones whose columns are not orthogonal (the tricopter's x and y columns share the
+  // tail motor). Only the x, y and z rows are kept, since only torque is fed back.
+  const float *columns[4] = {mixer_to_use_->F, mixer_to_use_->x, mixer_to_use_->y, mixer_to_use_->z};
+
+  // Augmented [B^T B | I], reduced in place by Gauss-Jordan elimination
+  float m[4][8];
+  for (uint8_t r = 0; r < 4; r++)
+  {
+    for (uint8_t c = 0; c < 4; c++)
+    {
+      float dot = 0.0f;
+      for (uint8_t i = 0; i < NUM_MIXER_OUTPUTS; i++)
+      {
+        if (mixer_to_use_->output_type[i] != NONE)
+          dot += columns[r][i] * columns[c][i];
+      }
+      m[r][c] = dot;
+      m[r][c + 4] = (r == c) ? 1.0f : 0.0f;
+    }
+  }
+
+  // A column the mixer doesn't drive (e.g. no thrust on a fixed wing) can't be estimated, so drop it from the fit
+  // rather than letting it make the whole system singular
+  bool used[4];
+  for (uint8_t r = 0; r < 4; r++)
+  {
+    used[r] = m[r][r] > 1e-6f;
+    if (!used[r])
+    {
+      for (uint8_t c = 0; c < 4; c++)
+      {
+        m[r][c] = (r == c) ? 1.0f : 0.0f;
+        m[c][r] = (r == c) ? 1.0f : 0.0f;
+      }
+    }
+  }
+
+  for (uint8_t c = 0; c < 4; c++)
+  {
+    uint8_t pivot = c;
+    for (uint8_t r = c + 1; r < 4; r++)
+    {
+      if (fabsf(m[r][c]) > fabsf(m[pivot][c]))
+        pivot = r;
+    }
+    // Dependent columns: the torque can't be recovered from the outputs, so leave the estimate at zero
+    if (fabsf(m[pivot][c]) < 1e-6f)
+      return;
+
+    if (pivot != c)
+    {
+      for (uint8_t k = 0; k < 8; k++)
+      {
+        float tmp = m[c][k];
+        m[c][k] = m[pivot][k];
+        m[pivot][k] = tmp;
+      }
+    }
+
+    float inv_pivot = 1.0f / m[c][c];
+    for (uint8_t k = 0; k < 8; k++)
+      m[c][k] *= inv_pivot;
+
+    for (uint8_t r = 0; r < 4; r++)
+    {
+      if (r == c)
+        continue;
+      float factor = m[r][c];
+      for (uint8_t k = 0; k < 8; k++)
+        m[r][k] -= factor * m[c][k];
+    }
+  }
+
+  // Row r of the pseudo-inverse is row r of (B^T B)^-1 times B^T
+  float *rows[3] = {torque_inv_x_, torque_inv_y_, torque_inv_z_};
+  for (uint8_t r = 1; r < 4; r++)
+  {
+    if (!used[r])
+      continue;
+    for (uint8_t i = 0; i < NUM_MIXER_OUTPUTS; i++)
+    {
+      if (mixer_to_use_->output_type[i] == NONE)
+        continue;
+      float value = 0.0f;
+      for (uint8_t c = 0; c < 4; c++)
+        value += m[r][c + 4] * columns[c][i];
+      rows[r - 1][i] = value;
+    }
+  }
+}
+
+turbomath::Vector Mixer::get_output_torque() const
+{
+  turbomath::Vector torque(0.0f, 0.0f, 0.0f);
+  for (uint8_t i = 0; i < NUM_MIXER_OUTPUTS; i++)
+  {
+    torque.x += torque_inv_x_[i] * thrust_outputs_[i];
+    torque.y += torque_inv_y_[i] * thrust_outputs_[i];
+    torque.z += torque_inv_z_[i] * thrust_outputs_[i];
+  }
+  return torque;
+}
+
+void Mixer::init_thrust_lut()
+{
+  // Model thrust as T = a*u^2 + (1 - a)*u and invert it once here, so the per-output cost is a table lookup
+  float a = RF_.params_.get_param_float(PARAM_MOTOR_THRUST_MODEL);
+  a = (a < 0.0f) ? 0.0f : (a > 1.0f) ? 1.0f : a;
+  thrust_model_ = a;
+
+  for (uint8_t i = 0; i < THRUST_LUT_SIZE; i++)
+  {
+    float thrust = static_cast<float>(i) / (THRUST_LUT_SIZE - 1);
+    if (a < 1e-4f)
+      thrust_lut_[i] = thrust;
+    else
+      thrust_lut_[i] = (-(1.0f - a) + sqrtf((1.0f - a) * (1.0f - a) + 4.0f * a * thrust)) / (2.0f * a);
+  }
+}
+
+float Mixer::voltage_compensation() const
+{
+  float nominal = RF_.params_.get_param_float(PARAM_MOTOR_VOLTAGE_NOMINAL);
+  const Sensors::Data &data = RF_.sensors_.data();
+  if (nominal <= 0.0f || !data.battery_monitor_present || data.battery_voltage <= 0.0f)
+    return 1.0f;
+
+  // Available thrust drops with the battery, so scale the thrust request up to hold the same loop gain
+  float gain = nominal / data.battery_voltage;
+  if (gain > MAX_VOLTAGE_COMPENSATION)
+    gain = MAX_VOLTAGE_COMPENSATION;
+  return gain;
+}
+
+float Mixer::linearize_thrust(float thrust) const
+{
+  if (thrust <= 0.0f)
+    return thrust;
+  if (thrust >= 1.0f)
+    return thrust_lut_[THRUST_LUT_SIZE - 1];
+
+  float index = thrust * (THRUST_LUT_SIZE - 1);
+  uint8_t lower = static_cast<uint8_t>(index);
+  float fraction = index - lower;
+  return thrust_lut_[lower] + fraction * (thrust_lut_[lower + 1] - thrust_lut_[lower]);
+}
+
+float Mixer::motor_thrust(float command) const
+{
+  return thrust_model_ * command * command + (1.0f - thrust_model_) * command;
 }
 
 void Mixer::write_motor(uint8_t index, float value)
@@ -131,7 +524,15 @@ void Mixer::write_motor(uint8_t index, float value)
     value = 0.0;
   }
   raw_outputs_[index] = value;
-  RF_.board_.pwm_write(index, raw_outputs_[index]);
+  if (dshot_mask_ & (1 << index))
+  {
+    dshot_frames_[index] = dshot_encode_frame(dshot_throttle_to_value(value), false, dshot_bidirectional_);
+  }
+  else
+  {
+    pwm_outputs_[index] = raw_outputs_[index];
+    pwm_output_type_[index] = M;
+  }
 }
 
 void Mixer::write_servo(uint8_t index, float value)
@@ -145,7 +546,8 @@ void Mixer::write_servo(uint8_t index, float value)
     value = -1.0;
   }
   raw_outputs_[index] = value;
-  RF_.board_.pwm_write(index, raw_outputs_[index] * 0.5 + 0.5);
+  pwm_outputs_[index] = raw_outputs_[index] * 0.5f + 0.5f;
+  pwm_output_type_[index] = S;
 }
 
 void Mixer::set_new_aux_command(aux_command_t new_aux_command)
@@ -157,41 +559,28 @@ void Mixer::set_new_aux_command(aux_command_t new_aux_command)
   }
 }
 
-void Mixer::mix_output()
+void Mixer::mix_scaled(const float F, const float x, const float y, const float z, const float gain)
 {
-  Controller::Output commands = RF_.controller_.output();
-  float max_output = 1.0f;
+  mix_kernel_(*mixer_to_use_, F, x, y, z, outputs_);
 
-  // Reverse fixed-wing channels just before mixing if we need to
-  if (RF_.params_.get_param_int(PARAM_FIXED_WING))
+  // Voltage compensation goes in ahead of saturation, so a boosted request is scaled back into range like any other
+  if (gain != 1.0f)
   {
-    commands.x *= RF_.params_.get_param_int(PARAM_AILERON_REVERSE) ? -1 : 1;
-    commands.y *= RF_.params_.get_param_int(PARAM_ELEVATOR_REVERSE) ? -1 : 1;
-    commands.z *= RF_.params_.get_param_int(PARAM_RUDDER_REVERSE) ? -1 : 1;
-  }
-  else if (commands.F < RF_.params_.get_param_float(PARAM_MOTOR_IDLE_THROTTLE))
-  {
-    // For multirotors, disregard yaw commands if throttle is low to prevent motor spin-up while
-    // arming/disarming
-    commands.z = 0.0;
+    for (uint8_t i = 0; i < num_mixer_outputs_; i++)
+    {
+      if (mixer_to_use_->output_type[i] == M)
+        outputs_[i] *= gain;
+    }
   }
 
-  if (mixer_to_use_ == nullptr)
-    return;
-
-  for (uint8_t i = 0; i < NUM_MIXER_OUTPUTS; i++)
+  // Save off the largest control output if it is greater than 1.0 for future scaling. Unused outputs inside the
+  // kernel's range have all-zero coefficients, so they can't affect the maximum.
+  float max_output = 1.0f;
+  for (uint8_t i = 0; i < num_mixer_outputs_; i++)
   {
-    if (mixer_to_use_->output_type[i] != NONE)
+    if (outputs_[i] > max_output)
     {
-      // Matrix multiply to mix outputs
-      outputs_[i] = (commands.F * mixer_to_use_->F[i] + commands.x * mixer_to_use_->x[i]
-                     + commands.y * mixer_to_use_->y[i] + commands.z * mixer_to_use_->z[i]);
-
-      // Save off the largest control output if it is greater than 1.0 for future scaling
-      if (outputs_[i] > max_output)
-      {
-        max_output = outputs_[i];
-      }
+      max_output = outputs_[i];
     }
   }
 
@@ -203,11 +592,136 @@ void Mixer::mix_output()
   }
 
   // Perform Motor Output Scaling
-  for (uint8_t i = 0; i < NUM_MIXER_OUTPUTS; i++)
+  for (uint8_t i = 0; i < num_mixer_outputs_; i++)
   {
     // scale all motor outputs by scale factor (this is usually 1.0, unless we saturated)
     outputs_[i] *= scale_factor;
   }
+}
+
+void Mixer::mix_prioritized(const float F, const float x, const float y, const float z, const float gain)
+{
+  // Allocation is done in three fixed passes over the outputs, so the cost is bounded regardless of how saturated
+  // the request is. Servos and other non-motor outputs are mixed directly and left to saturate on their own.
+  float rp[NUM_MIXER_OUTPUTS];
+  float yaw[NUM_MIXER_OUTPUTS];
+  float rp_min = 0.0f;
+  float rp_max = 0.0f;
+  bool has_motor = false;
+
+  // Pass 1: roll and pitch come first. If the differential alone doesn't fit in the motor range, scale it down.
+  for (uint8_t i = 0; i < NUM_MIXER_OUTPUTS; i++)
+  {
+    if (mixer_to_use_->output_type[i] == NONE)
+      continue;
+
+    rp[i] = x * mixer_to_use_->x[i] + y * mixer_to_use_->y[i];
+    yaw[i] = z * mixer_to_use_->z[i];
+
+    if (mixer_to_use_->output_type[i] != M)
+    {
+      outputs_[i] = F * mixer_to_use_->F[i] + rp[i] + yaw[i];
+      continue;
+    }
+
+    // Motor requests carry the voltage compensation into the allocation, so it is limited along with everything else
+    rp[i] *= gain;
+    yaw[i] *= gain;
+
+    if (!has_motor || rp[i] < rp_min)
+      rp_min = rp[i];
+    if (!has_motor || rp[i] > rp_max)
+      rp_max = rp[i];
+    has_motor = true;
+  }
+
+  if (!has_motor)
+    return;
+
+  float rp_scale = (rp_max - rp_min > 1.0f) ? 1.0f / (rp_max - rp_min) : 1.0f;
+
+  // Pass 2: thrust. Find the range of collective that keeps every motor in [0, 1] and move the commanded thrust into
+  // it, up or down (airmode).
+  float F_min = -1.0e6f;
+  float F_max = 1.0e6f;
+  for (uint8_t i = 0; i < NUM_MIXER_OUTPUTS; i++)
+  {
+    if (mixer_to_use_->output_type[i] != M)
+      continue;
+
+    rp[i] *= rp_scale;
+    if (mixer_to_use_->F[i] <= 0.0f)
+      continue;
+
+    float lower = -rp[i] / mixer_to_use_->F[i];
+    float upper = (1.0f - rp[i]) / mixer_to_use_->F[i];
+    F_min = (lower > F_min) ? lower : F_min;
+    F_max = (upper < F_max) ? upper : F_max;
+  }
+
+  float thrust = F * gain;
+  if (F_min > F_max)
+    thrust = 0.5f * (F_min + F_max);
+  else if (thrust < F_min)
+    thrust = F_min;
+  else if (thrust > F_max)
+    thrust = F_max;
+
+  // Pass 3: yaw gets whatever headroom is left
+  float yaw_scale = 1.0f;
+  for (uint8_t i = 0; i < NUM_MIXER_OUTPUTS; i++)
+  {
+    if (mixer_to_use_->output_type[i] != M)
+      continue;
+
+    outputs_[i] = rp[i] + thrust * mixer_to_use_->F[i];
+
+    float limit = 1.0f;
+    if (outputs_[i] + yaw[i] > 1.0f)
+      limit = (1.0f - outputs_[i]) / yaw[i];
+    else if (outputs_[i] + yaw[i] < 0.0f)
+      limit = -outputs_[i] / yaw[i];
+    limit = (limit < 0.0f) ? 0.0f : limit;
+    yaw_scale = (limit < yaw_scale) ? limit : yaw_scale;
+  }
+
+  for (uint8_t i = 0; i < NUM_MIXER_OUTPUTS; i++)
+  {
+    if (mixer_to_use_->output_type[i] == M)
+      outputs_[i] += yaw_scale * yaw[i];
+  }
+}
+
+void Mixer::mix_output()
+{
+  Controller::Output commands = RF_.controller_.output();
+
+  // Reverse fixed-wing channels just before mixing if we need to
+  if (RF_.params_.get_param_int(PARAM_FIXED_WING))
+  {
+    commands.x *= RF_.params_.get_param_int(PARAM_AILERON_REVERSE) ? -1 : 1;
+    commands.y *= RF_.params_.get_param_int(PARAM_ELEVATOR_REVERSE) ? -1 : 1;
+    commands.z *= RF_.params_.get_param_int(PARAM_RUDDER_REVERSE) ? -1 : 1;
+  }
+  else if (commands.F < RF_.params_.get_param_float(PARAM_MOTOR_IDLE_THROTTLE))
+  {
+    // For multirotors, disregard yaw commands if throttle is low to prevent motor spin-up while
+    // arming/disarming
+    commands.z = 0.0;
+  }
+
+  if (mixer_to_use_ == nullptr)
+    return;
+
+  // Motor commands are linearized and compensated for battery sag, except during ESC calibration, which needs the raw
+  // throttle. The compensation is applied inside the allocation so the saturation logic sees the real request.
+  bool linearize = RF_.params_.get_param_int(PARAM_MIXER) != ESC_CALIBRATION;
+  float gain = linearize ? voltage_compensation() : 1.0f;
+
+  if (RF_.params_.get_param_int(PARAM_MIXER_AIRMODE))
+    mix_prioritized(commands.F, commands.x, commands.y, commands.z, gain);
+  else
+    mix_scaled(commands.F, commands.x, commands.y, commands.z, gain);
 
   // Insert AUX Commands, and assemble combined_output_types array (Does not override mixer values)
 
@@ -233,9 +747,20 @@ void Mixer::mix_output()
     combined_output_type_[i] = aux_command_.channel[i].type;
   }
 
-  // Write to outputs
+  // Turn the mixed thrust requests into motor commands
+  if (linearize)
+  {
+    for (uint8_t i = 0; i < NUM_MIXER_OUTPUTS; i++)
+    {
+      if (mixer_to_use_->output_type[i] == M)
+        outputs_[i] = linearize_thrust(outputs_[i]);
+    }
+  }
+
+  // Stage every output, then hand them to the board in a single call so they update together
   for (uint8_t i = 0; i < NUM_TOTAL_OUTPUTS; i++)
   {
+    pwm_output_type_[i] = NONE;
     if (combined_output_type_[i] == S)
     {
       write_servo(i, outputs_[i]);
@@ -245,6 +770,21 @@ void Mixer::mix_output()
       write_motor(i, outputs_[i]);
     }
   }
+
+  RF_.board_.pwm_write_all(pwm_outputs_, pwm_output_type_, NUM_TOTAL_OUTPUTS);
+
+  // Recover the thrust each output actually delivers, after the arming and idle limits in write_motor(), in the same
+  // units as the controller commands, for the torque estimate
+  for (uint8_t i = 0; i < NUM_MIXER_OUTPUTS; i++)
+  {
+    if (mixer_to_use_->output_type[i] == M && linearize)
+      thrust_outputs_[i] = motor_thrust(raw_outputs_[i]) / gain;
+    else
+      thrust_outputs_[i] = raw_outputs_[i];
+  }
+
+  if (dshot_enabled_)
+    update_dshot();
 }
 
 } // namespace rosflight_firmware
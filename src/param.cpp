@@ -35,7 +35,10 @@
 #include "mixer.h"
 
 #include "rosflight.h"
+#include "util.h"
 
+#include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 
@@ -56,43 +59,72 @@
 
 namespace rosflight_firmware
 {
-Params::Params(ROSflight &_rf) : RF_(_rf), listeners_(nullptr), num_listeners_(0) {}
-
-// local function definitions
-void Params::init_param_int(uint16_t id, const char name[PARAMS_NAME_LENGTH], int32_t value)
+// Constant per-parameter tables generated from param_list.h, so they are placed in flash rather than RAM. The extra
+// name character keeps the terminator for names that use all PARAMS_NAME_LENGTH characters.
+static constexpr char PARAM_NAMES[PARAMS_COUNT][Params::PARAMS_NAME_LENGTH + 1] = {
+#define PARAM_INT(id, name, default_value, min, max) name,
+#define PARAM_FLOAT(id, name, default_value, min, max) name,
+#include "param_list.h"
+};
+
+static constexpr param_type_t PARAM_TYPES[PARAMS_COUNT] = {
+#define PARAM_INT(id, name, default_value, min, max) PARAM_TYPE_INT32,
+#define PARAM_FLOAT(id, name, default_value, min, max) PARAM_TYPE_FLOAT,
+#include "param_list.h"
+};
+
+static constexpr Params::param_value_t PARAM_DEFAULTS[PARAMS_COUNT] = {
+#define PARAM_INT(id, name, default_value, min, max) Params::param_value_t(static_cast<int32_t>(default_value)),
+#define PARAM_FLOAT(id, name, default_value, min, max) Params::param_value_t(static_cast<float>(default_value)),
+#include "param_list.h"
+};
+
+// Every default has to lie inside its parameter's documented range
+#define PARAM_INT(id, name, default_value, min, max)                                     \
+  static_assert(static_cast<int32_t>(min) <= static_cast<int32_t>(default_value)         \
+                    && static_cast<int32_t>(default_value) <= static_cast<int32_t>(max), \
+                name " default is outside its range");
+#define PARAM_FLOAT(id, name, default_value, min, max)                               \
+  static_assert(static_cast<float>(min) <= static_cast<float>(default_value)         \
+                    && static_cast<float>(default_value) <= static_cast<float>(max), \
+                name " default is outside its range");
+#include "param_list.h"
+
+// 32-bit FNV-1a, evaluated at compile time for the tag table below
+static constexpr uint32_t FNV_OFFSET_BASIS = 2166136261u;
+static constexpr uint32_t FNV_PRIME = 16777619u;
+
+static constexpr uint32_t fnv1a(const char *str, uint32_t hash)
 {
-  // copy cstr including '\0' or until maxlen
-  const uint8_t len = (strlen(name) >= PARAMS_NAME_LENGTH) ? PARAMS_NAME_LENGTH : strlen(name) + 1;
-  memcpy(params.names[id], name, len);
-  params.values[id].ivalue = value;
-  params.types[id] = PARAM_TYPE_INT32;
+  return *str == '\0' ? hash : fnv1a(str + 1, (hash ^ static_cast<uint8_t>(*str)) * FNV_PRIME);
 }
 
-void Params::init_param_float(uint16_t id, const char name[PARAMS_NAME_LENGTH], float value)
+static constexpr uint32_t param_tag(const char *name, param_type_t type)
 {
-  // copy cstr including '\0' or until maxlen
-  const uint8_t len = (strlen(name) >= PARAMS_NAME_LENGTH) ? PARAMS_NAME_LENGTH : strlen(name) + 1;
-  memcpy(params.names[id], name, len);
-  params.values[id].fvalue = value;
-  params.types[id] = PARAM_TYPE_FLOAT;
+  return fnv1a(name, (FNV_OFFSET_BASIS ^ static_cast<uint8_t>(type)) * FNV_PRIME);
 }
 
-uint8_t Params::compute_checksum(void)
+static constexpr uint32_t PARAM_TAGS[PARAMS_COUNT] = {
+#define PARAM_INT(id, name, default_value, min, max) param_tag(name, PARAM_TYPE_INT32),
+#define PARAM_FLOAT(id, name, default_value, min, max) param_tag(name, PARAM_TYPE_FLOAT),
+#include "param_list.h"
+};
+
+Params::stored_params_t Params::storage_;
+
+Params::Params(ROSflight &_rf) :
+  RF_(_rf),
+  journal_sector_(0),
+  journal_sequence_(0),
+  journal_offset_(0),
+  listeners_(nullptr),
+  num_listeners_(0),
+  transaction_depth_(0)
 {
-  uint8_t chk = 0;
-  const char *p;
-
-  for (p = reinterpret_cast<const char *>(&params.values);
-       p < reinterpret_cast<const char *>(&params.values) + 4 * PARAMS_COUNT; p++)
-    chk ^= *p;
-  for (p = reinterpret_cast<const char *>(&params.names);
-       p < reinterpret_cast<const char *>(&params.names) + PARAMS_COUNT * PARAMS_NAME_LENGTH; p++)
-    chk ^= *p;
-  for (p = reinterpret_cast<const char *>(&params.types);
-       p < reinterpret_cast<const char *>(&params.types) + PARAMS_COUNT; p++)
-    chk ^= *p;
-
-  return chk;
+  memset(unsaved_, 0, sizeof(unsaved_));
+  memset(listener_masks_, 0, sizeof(listener_masks_));
+  memset(changed_, 0, sizeof(changed_));
+  build_lookup_index();
 }
 
 // function definitions
@@ -101,275 +133,382 @@ void Params::init()
   RF_.board_.memory_init();
   if (!read())
   {
-    RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_WARNING,
-                          "Unable to load parameters; using default values");
+    RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_WARNING, LOG_MSG_PARAMS_DEFAULTED);
     set_defaults();
     write();
   }
 }
 
-// clang-format off
 void Params::set_defaults(void)
 {
-  /******************************/
-  /*** HARDWARE CONFIGURATION ***/
-  /******************************/
-  init_param_int(PARAM_BAUD_RATE, "BAUD_RATE", 921600); // Baud rate of MAVlink communication with companion computer | 9600 | 921600
-  init_param_int(PARAM_SERIAL_DEVICE, "SERIAL_DEVICE", 0); // Serial Port (for supported devices) | 0 | 3
-
-  /*****************************/
-  /*** MAVLINK CONFIGURATION ***/
-  /*****************************/
-  init_param_int(PARAM_SYSTEM_ID, "SYS_ID", 1); // Mavlink System ID  | 1 | 255
-  init_param_int(PARAM_STREAM_HEARTBEAT_RATE, "STRM_HRTBT", 1); // Rate of heartbeat stream (Hz) | 0 | 1000
-  init_param_int(PARAM_STREAM_STATUS_RATE, "STRM_STATUS", 10); // Rate of status stream (Hz) | 0 | 1000
-
-  init_param_int(PARAM_STREAM_ATTITUDE_RATE, "STRM_ATTITUDE", 200); // Rate of attitude stream (Hz) | 0 | 1000
-  init_param_int(PARAM_STREAM_IMU_RATE, "STRM_IMU", 250); // Rate of IMU stream (Hz) | 0 | 1000
-  init_param_int(PARAM_STREAM_MAG_RATE, "STRM_MAG", 50); // Rate of magnetometer stream (Hz) | 0 | 75
-  init_param_int(PARAM_STREAM_BARO_RATE, "STRM_BARO", 50); // Rate of barometer stream (Hz) | 0 | 100
-  init_param_int(PARAM_STREAM_AIRSPEED_RATE, "STRM_AIRSPEED", 50); // Rate of airspeed stream (Hz) | 0 |  50
-  init_param_int(PARAM_STREAM_SONAR_RATE, "STRM_SONAR", 40); // Rate of sonar stream (Hz) | 0 | 40
-  init_param_int(PARAM_STREAM_GNSS_RATE, "STRM_GNSS", 1000); // Maximum rate of GNSS stream (Hz) | 0 | 10
-  init_param_int(PARAM_STREAM_GNSS_FULL_RATE, "STRM_GNSS_FULL", 10); //Rate of GNSS full stream (Hz) | 0 | 10
-  init_param_int(PARAM_STREAM_BATTERY_STATUS_RATE, "STRM_BATTERY", 10); //Rate of battery status stream (Hz) | 0 | 10
-
-  init_param_int(PARAM_STREAM_OUTPUT_RAW_RATE, "STRM_SERVO", 50); // Rate of raw output stream | 0 |  490
-  init_param_int(PARAM_STREAM_RC_RAW_RATE, "STRM_RC", 50); // Rate of raw RC input stream | 0 | 50
-
-  /********************************/
-  /*** CONTROLLER CONFIGURATION ***/
-  /********************************/
-  init_param_float(PARAM_MAX_COMMAND, "PARAM_MAX_CMD", 1.0); // saturation point for PID controller output | 0 | 1.0
-
-  init_param_float(PARAM_PID_ROLL_RATE_P, "PID_ROLL_RATE_P", 0.070f); // Roll Rate Proportional Gain | 0.0 | 1000.0
-  init_param_float(PARAM_PID_ROLL_RATE_I, "PID_ROLL_RATE_I", 0.000f); // Roll Rate Integral Gain | 0.0 | 1000.0
-  init_param_float(PARAM_PID_ROLL_RATE_D, "PID_ROLL_RATE_D", 0.000f); // Roll Rate Derivative Gain | 0.0 | 1000.0
-
-  init_param_float(PARAM_PID_PITCH_RATE_P, "PID_PITCH_RATE_P", 0.070f);  // Pitch Rate Proportional Gain | 0.0 | 1000.0
-  init_param_float(PARAM_PID_PITCH_RATE_I, "PID_PITCH_RATE_I", 0.0000f); // Pitch Rate Integral Gain | 0.0 | 1000.0
-  init_param_float(PARAM_PID_PITCH_RATE_D, "PID_PITCH_RATE_D", 0.0000f); // Pitch Rate Derivative Gain | 0.0 | 1000.0
-
-  init_param_float(PARAM_PID_YAW_RATE_P, "PID_YAW_RATE_P", 0.25f);   // Yaw Rate Proportional Gain | 0.0 | 1000.0
-  init_param_float(PARAM_PID_YAW_RATE_I, "PID_YAW_RATE_I", 0.0f);  // Yaw Rate Integral Gain | 0.0 | 1000.0
-  init_param_float(PARAM_PID_YAW_RATE_D, "PID_YAW_RATE_D", 0.0f);  // Yaw Rate Derivative Gain | 0.0 | 1000.0
-
-  init_param_float(PARAM_PID_ROLL_ANGLE_P, "PID_ROLL_ANG_P", 0.15f);   // Roll Angle Proportional Gain | 0.0 | 1000.0
-  init_param_float(PARAM_PID_ROLL_ANGLE_I, "PID_ROLL_ANG_I", 0.0f);   // Roll Angle Integral Gain | 0.0 | 1000.0
-  init_param_float(PARAM_PID_ROLL_ANGLE_D, "PID_ROLL_ANG_D", 0.05f);  // Roll Angle Derivative Gain | 0.0 | 1000.0
-
-  init_param_float(PARAM_PID_PITCH_ANGLE_P, "PID_PITCH_ANG_P", 0.15f);  // Pitch Angle Proportional Gain | 0.0 | 1000.0
-  init_param_float(PARAM_PID_PITCH_ANGLE_I, "PID_PITCH_ANG_I", 0.0f);  // Pitch Angle Integral Gain | 0.0 | 1000.0
-  init_param_float(PARAM_PID_PITCH_ANGLE_D, "PID_PITCH_ANG_D", 0.05f); // Pitch Angle Derivative Gain | 0.0 | 1000.0
-
-  init_param_float(PARAM_X_EQ_TORQUE, "X_EQ_TORQUE", 0.0f); // Equilibrium torque added to output of controller on x axis | -1.0 | 1.0
-  init_param_float(PARAM_Y_EQ_TORQUE, "Y_EQ_TORQUE", 0.0f); // Equilibrium torque added to output of controller on y axis | -1.0 | 1.0
-  init_param_float(PARAM_Z_EQ_TORQUE, "Z_EQ_TORQUE", 0.0f); // Equilibrium torque added to output of controller on z axis | -1.0 | 1.0
-
-  init_param_float(PARAM_PID_TAU, "PID_TAU", 0.05f); // Dirty Derivative time constant - See controller documentation | 0.0 | 1.0
-
-
-  /*************************/
-  /*** PWM CONFIGURATION ***/
-  /*************************/
-  init_param_int(PARAM_MOTOR_PWM_SEND_RATE, "MOTOR_PWM_UPDATE", 0); // Overrides default PWM rate specified by mixer if non-zero - Requires reboot to take effect | 0 | 490
-  init_param_float(PARAM_MOTOR_IDLE_THROTTLE, "MOTOR_IDLE_THR", 0.1); // min throttle command sent to motors when armed (Set above 0.1 to spin when armed) | 0.0 | 1.0
-  init_param_float(PARAM_FAILSAFE_THROTTLE, "FAILSAFE_THR", -1.0); // Throttle sent to motors in failsafe condition (set just below hover throttle) | 0.0 | 1.0
-  init_param_int(PARAM_SPIN_MOTORS_WHEN_ARMED, "ARM_SPIN_MOTORS", true); // Enforce MOTOR_IDLE_THR | 0 | 1
-
-  /*******************************/
-  /*** ESTIMATOR CONFIGURATION ***/
-  /*******************************/
-  init_param_int(PARAM_INIT_TIME, "FILTER_INIT_T", 3000); // Time in ms to initialize estimator | 0 | 100000
-  init_param_float(PARAM_FILTER_KP_ACC, "FILTER_KP_ACC", 0.5f); // estimator proportional gain on accel-based error - See estimator documentation | 0 | 10.0
-  init_param_float(PARAM_FILTER_KI, "FILTER_KI", 0.01f); // estimator integral gain - See estimator documentation | 0 | 1.0
-  init_param_float(PARAM_FILTER_KP_EXT, "FILTER_KP_EXT", 1.5f); // estimator proportional gain on external attitude-based error - See estimator documentation | 0 | 10.0
-  init_param_float(PARAM_FILTER_ACCEL_MARGIN, "FILTER_ACCMARGIN", 0.1f); // allowable accel norm margin around 1g to determine if accel is usable | 0 | 1.0
-
-  init_param_int(PARAM_FILTER_USE_QUAD_INT, "FILTER_QUAD_INT", 1); // Perform a quadratic averaging of LPF gyro data prior to integration (adds ~20 us to estimation loop on F1 processors) | 0 | 1
-  init_param_int(PARAM_FILTER_USE_MAT_EXP, "FILTER_MAT_EXP", 1); // 1 - Use matrix exponential to improve gyro integration (adds ~90 us to estimation loop in F1 processors) 0 - use euler integration | 0 | 1
-  init_param_int(PARAM_FILTER_USE_ACC, "FILTER_USE_ACC", 1);  // Use accelerometer to correct gyro integration drift (adds ~70 us to estimation loop) | 0 | 1
-
-  init_param_int(PARAM_CALIBRATE_GYRO_ON_ARM, "CAL_GYRO_ARM", false); // True if desired to calibrate gyros on arm | 0 | 1
-
-  init_param_float(PARAM_GYRO_XY_ALPHA, "GYROXY_LPF_ALPHA", 0.3f); // Low-pass filter constant on gyro X and Y axes - See estimator documentation | 0 | 1.0
-  init_param_float(PARAM_GYRO_Z_ALPHA, "GYROZ_LPF_ALPHA", 0.3f); // Low-pass filter constant on gyro Z axis - See estimator documentation | 0 | 1.0
-  init_param_float(PARAM_ACC_ALPHA, "ACC_LPF_ALPHA", 0.5f); // Low-pass filter constant on all accel axes - See estimator documentation | 0 | 1.0
-
-  init_param_float(PARAM_GYRO_X_BIAS, "GYRO_X_BIAS", 0.0f); // Constant x-bias of gyroscope readings | -1.0 | 1.0
-  init_param_float(PARAM_GYRO_Y_BIAS, "GYRO_Y_BIAS", 0.0f); // Constant y-bias of gyroscope readings | -1.0 | 1.0
-  init_param_float(PARAM_GYRO_Z_BIAS, "GYRO_Z_BIAS", 0.0f); // Constant z-bias of gyroscope readings | -1.0 | 1.0
-  init_param_float(PARAM_ACC_X_BIAS,  "ACC_X_BIAS", 0.0f); // Constant x-bias of accelerometer readings | -2.0 | 2.0
-  init_param_float(PARAM_ACC_Y_BIAS,  "ACC_Y_BIAS", 0.0f); // Constant y-bias of accelerometer readings | -2.0 | 2.0
-  init_param_float(PARAM_ACC_Z_BIAS,  "ACC_Z_BIAS", 0.0f); // Constant z-bias of accelerometer readings | -2.0 | 2.0
-  init_param_float(PARAM_ACC_X_TEMP_COMP,  "ACC_X_TEMP_COMP", 0.0f); // Linear x-axis temperature compensation constant | -2.0 | 2.0
-  init_param_float(PARAM_ACC_Y_TEMP_COMP,  "ACC_Y_TEMP_COMP", 0.0f); // Linear y-axis temperature compensation constant | -2.0 | 2.0
-  init_param_float(PARAM_ACC_Z_TEMP_COMP,  "ACC_Z_TEMP_COMP", 0.0f); // Linear z-axis temperature compensation constant | -2.0 | 2.0
-
-  init_param_float(PARAM_MAG_A11_COMP,  "MAG_A11_COMP", 1.0f); // Soft iron compensation constant | -999.0 | 999.0
-  init_param_float(PARAM_MAG_A12_COMP,  "MAG_A12_COMP", 0.0f); // Soft iron compensation constant | -999.0 | 999.0
-  init_param_float(PARAM_MAG_A13_COMP,  "MAG_A13_COMP", 0.0f); // Soft iron compensation constant | -999.0 | 999.0
-  init_param_float(PARAM_MAG_A21_COMP,  "MAG_A21_COMP", 0.0f); // Soft iron compensation constant | -999.0 | 999.0
-  init_param_float(PARAM_MAG_A22_COMP,  "MAG_A22_COMP", 1.0f); // Soft iron compensation constant | -999.0 | 999.0
-  init_param_float(PARAM_MAG_A23_COMP,  "MAG_A23_COMP", 0.0f); // Soft iron compensation constant | -999.0 | 999.0
-  init_param_float(PARAM_MAG_A31_COMP,  "MAG_A31_COMP", 0.0f); // Soft iron compensation constant | -999.0 | 999.0
-  init_param_float(PARAM_MAG_A32_COMP,  "MAG_A32_COMP", 0.0f); // Soft iron compensation constant | -999.0 | 999.0
-  init_param_float(PARAM_MAG_A33_COMP,  "MAG_A33_COMP", 1.0f); // Soft iron compensation constant | -999.0 | 999.0
-  init_param_float(PARAM_MAG_X_BIAS,  "MAG_X_BIAS", 0.0f); // Hard iron compensation constant | -999.0 | 999.0
-  init_param_float(PARAM_MAG_Y_BIAS,  "MAG_Y_BIAS", 0.0f); // Hard iron compensation constant | -999.0 | 999.0
-  init_param_float(PARAM_MAG_Z_BIAS,  "MAG_Z_BIAS", 0.0f); // Hard iron compensation constant | -999.0 | 999.0
-
-  init_param_float(PARAM_BARO_BIAS, "BARO_BIAS", 0.0f); // Barometer measurement bias (Pa) | 0 | inf
-  init_param_float(PARAM_GROUND_LEVEL, "GROUND_LEVEL", 1387.0f); // Altitude of ground level (m) | -1000 | 10000
-
-  init_param_float(PARAM_DIFF_PRESS_BIAS, "DIFF_PRESS_BIAS", 0.0f); // Differential Pressure Bias (Pa) | -10 | 10
-
-  /************************/
-  /*** RC CONFIGURATION ***/
-  /************************/
-  init_param_int(PARAM_RC_TYPE, "RC_TYPE", 0); // Type of RC input 0 - PPM, 1 - SBUS | 0 | 1
-  init_param_int(PARAM_RC_X_CHANNEL, "RC_X_CHN", 0); // RC input channel mapped to x-axis commands [0 - indexed] | 0 | 3
-  init_param_int(PARAM_RC_Y_CHANNEL, "RC_Y_CHN", 1); // RC input channel mapped to y-axis commands [0 - indexed] | 0 | 3
-  init_param_int(PARAM_RC_Z_CHANNEL, "RC_Z_CHN", 3); // RC input channel mapped to z-axis commands [0 - indexed] | 0 | 3
-  init_param_int(PARAM_RC_F_CHANNEL, "RC_F_CHN", 2); // RC input channel mapped to F-axis commands [0 - indexed] | 0 | 3
-  init_param_int(PARAM_RC_ATTITUDE_OVERRIDE_CHANNEL, "RC_ATT_OVRD_CHN", 4); // RC switch mapped to attitude override [0 indexed, -1 to disable] | 4 | 7
-  init_param_int(PARAM_RC_THROTTLE_OVERRIDE_CHANNEL, "RC_THR_OVRD_CHN", 4); // RC switch channel mapped to throttle override [0 indexed, -1 to disable] | 4 | 7
-  init_param_int(PARAM_RC_ATT_CONTROL_TYPE_CHANNEL,  "RC_ATT_CTRL_CHN",-1); // RC switch channel mapped to attitude control type [0 indexed, -1 to disable] | 4 | 7
-  init_param_int(PARAM_RC_ARM_CHANNEL, "ARM_CHANNEL",-1); // RC switch channel mapped to arming (only if PARAM_ARM_STICKS is false) [0 indexed, -1 to disable] | 4 | 7
-  init_param_int(PARAM_RC_NUM_CHANNELS, "RC_NUM_CHN", 6); // number of RC input channels | 1 | 8
-
-  init_param_int(PARAM_RC_SWITCH_5_DIRECTION, "SWITCH_5_DIR", 1); // RC switch 5 toggle direction | -1 | 1
-  init_param_int(PARAM_RC_SWITCH_6_DIRECTION, "SWITCH_6_DIR", 1); // RC switch 6 toggle direction | -1 | 1
-  init_param_int(PARAM_RC_SWITCH_7_DIRECTION, "SWITCH_7_DIR", 1); // RC switch 7 toggle direction | -1 | 1
-  init_param_int(PARAM_RC_SWITCH_8_DIRECTION, "SWITCH_8_DIR", 1); // RC switch 8 toggle direction | -1 | 1
-
-  init_param_float(PARAM_RC_OVERRIDE_DEVIATION, "RC_OVRD_DEV", 0.1); // RC stick deviation from center for override | 0.0 | 1.0
-  init_param_int(PARAM_OVERRIDE_LAG_TIME, "OVRD_LAG_TIME", 1000); // RC stick deviation lag time before returning control (ms) | 0 | 100000
-  init_param_int(PARAM_RC_OVERRIDE_TAKE_MIN_THROTTLE, "MIN_THROTTLE", true); // Take minimum throttle between RC and computer at all times | 0 | 1
-
-  init_param_int(PARAM_RC_ATTITUDE_MODE, "RC_ATT_MODE", 1); // Attitude mode for RC sticks (0: rate, 1: angle). Overridden if RC_ATT_CTRL_CHN is set. | 0 | 1
-  init_param_float(PARAM_RC_MAX_ROLL, "RC_MAX_ROLL", 0.786f); // Maximum roll angle command sent by full deflection of RC sticks | 0.0 | 3.14159
-  init_param_float(PARAM_RC_MAX_PITCH, "RC_MAX_PITCH", 0.786f); // Maximum pitch angle command sent by full stick deflection of RC sticks | 0.0 | 3.14159
-  init_param_float(PARAM_RC_MAX_ROLLRATE, "RC_MAX_ROLLRATE", 3.14159f); // Maximum roll rate command sent by full stick deflection of RC sticks | 0.0 | 9.42477796077
-  init_param_float(PARAM_RC_MAX_PITCHRATE, "RC_MAX_PITCHRATE", 3.14159f); // Maximum pitch command sent by full stick deflection of RC sticks | 0.0 | 3.14159
-  init_param_float(PARAM_RC_MAX_YAWRATE, "RC_MAX_YAWRATE", 1.507f); // Maximum pitch command sent by full stick deflection of RC sticks | 0.0 | 3.14159
-
-  /***************************/
-  /*** FRAME CONFIGURATION ***/
-  /***************************/
-  init_param_int(PARAM_MIXER, "MIXER", Mixer::INVALID_MIXER); // Which mixer to choose - See Mixer documentation | 0 | 10
-
-  init_param_int(PARAM_FIXED_WING, "FIXED_WING", false); // switches on pass-through commands for fixed-wing operation | 0 | 1
-  init_param_int(PARAM_ELEVATOR_REVERSE, "ELEVATOR_REV", 0); // reverses elevator servo output | 0 | 1
-  init_param_int(PARAM_AILERON_REVERSE, "AIL_REV", 0); // reverses aileron servo output | 0 | 1
-  init_param_int(PARAM_RUDDER_REVERSE, "RUDDER_REV", 0); // reverses rudder servo output | 0 | 1
-
-  init_param_float(PARAM_FC_ROLL, "FC_ROLL", 0.0f); // roll angle (deg) of flight controller wrt aircraft body | 0 | 360
-  init_param_float(PARAM_FC_PITCH, "FC_PITCH", 0.0f); // pitch angle (deg) of flight controller wrt aircraft body | 0 | 360
-  init_param_float(PARAM_FC_YAW, "FC_YAW", 0.0f); // yaw angle (deg) of flight controller wrt aircraft body | 0 | 360
-
-
-  /********************/
-  /*** ARMING SETUP ***/
-  /********************/
-  init_param_float(PARAM_ARM_THRESHOLD, "ARM_THRESHOLD", 0.15); // RC deviation from max/min in yaw and throttle for arming and disarming check (us) | 0 | 500
-
-  /*****************************/
-  /*** BATTERY MONITOR SETUP ***/
-  /*****************************/
-  init_param_float(PARAM_BATTERY_VOLTAGE_MULTIPLIER, "BATT_VOLT_MULT", 0.0f);
-  init_param_float(PARAM_BATTERY_CURRENT_MULTIPLIER, "BATT_CURR_MULT", 0.0f);
-  init_param_float(PARAM_BATTERY_VOLTAGE_ALPHA, "BATT_VOLT_ALPHA", 0.995f);
-  init_param_float(PARAM_BATTERY_CURRENT_ALPHA, "BATT_CURR_ALPHA", 0.995f);
-
-  /************************/
-  /*** OFFBOARD CONTROL ***/
-  /************************/
-  init_param_int(PARAM_OFFBOARD_TIMEOUT, "OFFBOARD_TIMEOUT", 100); // Timeout in milliseconds for offboard commands, after which RC override is activated | 0 | 100000
+  memcpy(values_, PARAM_DEFAULTS, sizeof(values_));
+  memset(unsaved_, 0xFF, sizeof(unsaved_));
 }
-// clang-format on
 
 void Params::set_listeners(ParamListenerInterface *const listeners[], size_t num_listeners)
 {
   listeners_ = listeners;
   num_listeners_ = num_listeners;
+  if (num_listeners_ > MAX_LISTENERS)
+    num_listeners_ = MAX_LISTENERS;
+
+  // ask each listener once which parameters it cares about, so changes skip the ones that don't
+  for (uint16_t id = 0; id < PARAMS_COUNT; id++)
+  {
+    listener_masks_[id] = 0;
+    for (size_t i = 0; i < num_listeners_; i++)
+    {
+      if (listeners_[i]->param_is_relevant(id))
+        listener_masks_[id] = static_cast<uint8_t>(listener_masks_[id] | (1u << i));
+    }
+  }
 }
 
 bool Params::read(void)
 {
-  if (!RF_.board_.memory_read(&params, sizeof(params_t)))
+  if (!journal_supported())
+    return read_image();
+
+  if (journal_read())
+    return true;
+
+  // Nothing journaled yet, e.g. on the first boot after an update from firmware that stored a single image. Load the
+  // image and start the journal from it.
+  if (!read_image())
     return false;
+  journal_compact();
+  return true;
+}
+
+bool Params::write(void)
+{
+  if (!journal_supported())
+  {
+    memset(unsaved_, 0, sizeof(unsaved_));
+    return write_image();
+  }
+
+  if (journal_offset_ == 0)
+    return journal_compact();
+
+  for (uint16_t id = 0; id < PARAMS_COUNT; id++)
+  {
+    if ((unsaved_[id / 32] & (1u << (id % 32))) && !journal_append(id))
+      return journal_compact(); // the active sector is full
+  }
+  return true;
+}
 
-  if (params.version != GIT_VERSION_HASH)
+bool Params::read_image()
+{
+  if (!RF_.board_.memory_read(&storage_, sizeof(storage_)))
     return false;
 
-  if (params.size != sizeof(params_t) || params.magic_be != 0xBE || params.magic_ef != 0xEF)
+  if (storage_.magic_be != 0xBE || storage_.magic_ef != 0xEF || storage_.format != STORAGE_FORMAT
+      || storage_.count > STORAGE_CAPACITY)
     return false;
 
-  if (compute_checksum() != params.chk)
+  size_t entries_len = storage_.count * sizeof(stored_param_t);
+  if (checksum_fletcher16(reinterpret_cast<const uint8_t *>(storage_.entries), entries_len) != storage_.chk)
     return false;
 
+  set_defaults();
+  uint16_t loaded = 0;
+  for (uint16_t i = 0; i < storage_.count; i++)
+  {
+    uint16_t id = lookup_param_tag(storage_.entries[i].tag);
+    if (id < PARAMS_COUNT)
+    {
+      values_[id] = storage_.entries[i].value;
+      loaded++;
+    }
+  }
+
+  if (loaded != PARAMS_COUNT || storage_.count != PARAMS_COUNT)
+    RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_INFO, LOG_MSG_PARAMS_MIGRATED, loaded,
+                          PARAMS_COUNT - loaded, storage_.count - loaded);
+  memset(unsaved_, 0, sizeof(unsaved_));
   return true;
 }
 
-bool Params::write(void)
+bool Params::write_image()
 {
-  params.version = GIT_VERSION_HASH;
-  params.size = sizeof(params_t);
-  params.magic_be = 0xBE;
-  params.magic_ef = 0xEF;
-  params.chk = compute_checksum();
+  storage_.magic_be = 0xBE;
+  storage_.format = STORAGE_FORMAT;
+  storage_.count = PARAMS_COUNT;
+  storage_.version = GIT_VERSION_HASH;
+  storage_.reserved = 0;
+  storage_.magic_ef = 0xEF;
+  for (uint16_t id = 0; id < PARAMS_COUNT; id++)
+  {
+    storage_.entries[id].tag = PARAM_TAGS[id];
+    storage_.entries[id].value = values_[id];
+  }
+  size_t entries_len = PARAMS_COUNT * sizeof(stored_param_t);
+  storage_.chk = checksum_fletcher16(reinterpret_cast<const uint8_t *>(storage_.entries), entries_len);
 
-  if (!RF_.board_.memory_write(&params, sizeof(params_t)))
+  if (!RF_.board_.memory_write(&storage_, offsetof(stored_params_t, entries) + entries_len))
     return false;
   return true;
 }
 
+bool Params::journal_supported()
+{
+  // the sectors need to hold a full compaction with room to spare, or nearly every write would compact
+  return RF_.board_.param_journal_sector_size()
+         >= sizeof(journal_header_t) + 2 * PARAMS_COUNT * sizeof(journal_record_t);
+}
+
+uint32_t Params::journal_check(const journal_record_t &record)
+{
+  // never matches an erased record, where tag, value and check are all 0xFFFFFFFF
+  return record.tag ^ static_cast<uint32_t>(record.value.ivalue) ^ JOURNAL_MAGIC;
+}
+
+bool Params::journal_read()
+{
+  journal_header_t headers[2];
+  bool valid[2];
+  for (uint8_t sector = 0; sector < 2; sector++)
+  {
+    valid[sector] = RF_.board_.param_journal_read(sector, 0, &headers[sector], sizeof(journal_header_t))
+                    && headers[sector].magic == JOURNAL_MAGIC;
+  }
+  if (!valid[0] && !valid[1])
+    return false;
+
+  uint8_t sector = valid[0] ? 0 : 1;
+  if (valid[0] && valid[1] && static_cast<int32_t>(headers[1].sequence - headers[0].sequence) > 0)
+    sector = 1;
+
+  // replay the records over the defaults; the last record for a parameter holds its value
+  set_defaults();
+  size_t sector_size = RF_.board_.param_journal_sector_size();
+  size_t offset = sizeof(journal_header_t);
+  journal_record_t record;
+  while (offset + sizeof(journal_record_t) <= sector_size)
+  {
+    if (!RF_.board_.param_journal_read(sector, offset, &record, sizeof(journal_record_t)))
+      return false;
+    if (record.check != journal_check(record))
+    {
+      // The end of the journal, unless a write was cut short. The remains of that can't be programmed over, so the
+      // next write compacts.
+      if (record.tag != 0xFFFFFFFF || record.value.ivalue != -1 || record.check != 0xFFFFFFFF)
+        offset = sector_size;
+      break;
+    }
+
+    uint16_t id = lookup_param_tag(record.tag);
+    if (id < PARAMS_COUNT)
+      values_[id] = record.value;
+    offset += sizeof(journal_record_t);
+  }
+
+  journal_sector_ = sector;
+  journal_sequence_ = headers[sector].sequence;
+  journal_offset_ = offset;
+  memset(unsaved_, 0, sizeof(unsaved_));
+  return true;
+}
+
+bool Params::journal_append(uint16_t id)
+{
+  if (journal_offset_ + sizeof(journal_record_t) > RF_.board_.param_journal_sector_size())
+    return false;
+
+  journal_record_t record;
+  record.tag = PARAM_TAGS[id];
+  record.value = values_[id];
+  record.check = journal_check(record);
+  if (!RF_.board_.param_journal_program(journal_sector_, journal_offset_, &record, sizeof(journal_record_t)))
+  {
+    journal_offset_ = RF_.board_.param_journal_sector_size(); // don't program over whatever made it in
+    return false;
+  }
+
+  journal_offset_ += sizeof(journal_record_t);
+  unsaved_[id / 32] &= ~(1u << (id % 32));
+  return true;
+}
+
+bool Params::journal_compact()
+{
+  uint8_t sector = journal_offset_ == 0 ? 0 : static_cast<uint8_t>(journal_sector_ ^ 1);
+  if (!RF_.board_.param_journal_erase(sector))
+    return false;
+
+  size_t offset = sizeof(journal_header_t);
+  journal_record_t record;
+  for (uint16_t id = 0; id < PARAMS_COUNT; id++)
+  {
+    record.tag = PARAM_TAGS[id];
+    record.value = values_[id];
+    record.check = journal_check(record);
+    if (!RF_.board_.param_journal_program(sector, offset, &record, sizeof(journal_record_t)))
+      return false;
+    offset += sizeof(journal_record_t);
+  }
+
+  journal_header_t header;
+  header.magic = JOURNAL_MAGIC;
+  header.sequence = journal_sequence_ + 1;
+  if (!RF_.board_.param_journal_program(sector, 0, &header, sizeof(journal_header_t)))
+    return false;
+
+  journal_sector_ = sector;
+  journal_sequence_ = header.sequence;
+  journal_offset_ = offset;
+  memset(unsaved_, 0, sizeof(unsaved_));
+  return true;
+}
+
+void Params::mark_unsaved(uint16_t id)
+{
+  unsaved_[id / 32] |= 1u << (id % 32);
+}
+
 void Params::change_callback(uint16_t id)
 {
-  // call the callback function for all listeners
+  if (transaction_depth_ > 0)
+  {
+    changed_[id / 32] |= 1u << (id % 32);
+    return;
+  }
+
+  // call the callback function for all listeners interested in this parameter
   if (listeners_ != nullptr)
   {
     for (size_t i = 0; i < num_listeners_; i++)
     {
-      listeners_[i]->param_change_callback(id);
+      if (listener_masks_[id] & (1u << i))
+        listeners_[i]->param_change_callback(id);
     }
   }
 }
 
-uint16_t Params::lookup_param_id(const char name[PARAMS_NAME_LENGTH])
+void Params::begin_transaction()
 {
-  for (uint16_t id = 0; id < PARAMS_COUNT; id++)
+  transaction_depth_++;
+}
+
+void Params::commit_transaction()
+{
+  if (transaction_depth_ == 0 || --transaction_depth_ > 0)
+    return;
+
+  // take the set first, so parameters a listener changes while handling it are dispatched on their own
+  uint32_t changed[sizeof(changed_) / sizeof(changed_[0])];
+  memcpy(changed, changed_, sizeof(changed));
+  memset(changed_, 0, sizeof(changed_));
+
+  if (listeners_ == nullptr)
+    return;
+
+  uint16_t ids[PARAMS_COUNT];
+  for (size_t i = 0; i < num_listeners_; i++)
   {
-    bool match = true;
-    for (uint8_t i = 0; i < PARAMS_NAME_LENGTH; i++)
+    uint16_t count = 0;
+    for (uint16_t id = 0; id < PARAMS_COUNT; id++)
     {
-      // compare each character
-      if (name[i] != params.names[id][i])
-      {
-        match = false;
-        break;
-      }
-
-      // stop comparing if end of string is reached
-      if (params.names[id][i] == '\0')
-        break;
+      if ((changed[id / 32] & (1u << (id % 32))) && (listener_masks_[id] & (1u << i)))
+        ids[count++] = id;
     }
+    if (count > 0)
+      listeners_[i]->param_batch_change_callback(ids, count);
+  }
+}
 
-    if (match)
+const char *Params::get_param_name(uint16_t id) const
+{
+  return PARAM_NAMES[id];
+}
+
+param_type_t Params::get_param_type(uint16_t id) const
+{
+  return PARAM_TYPES[id];
+}
+
+uint32_t Params::get_param_tag(uint16_t id) const
+{
+  return PARAM_TAGS[id];
+}
+
+uint16_t Params::lookup_param_tag(uint32_t tag) const
+{
+  // a linear scan is plenty for something that only runs when the parameters are read
+  for (uint16_t id = 0; id < PARAMS_COUNT; id++)
+  {
+    if (PARAM_TAGS[id] == tag)
       return id;
   }
+  return PARAMS_COUNT;
+}
+
+void Params::build_lookup_index()
+{
+  // insertion sort, run once at construction since the names never change
+  for (uint16_t i = 0; i < PARAMS_COUNT; i++)
+  {
+    uint16_t j = i;
+    while (j > 0 && strncmp(PARAM_NAMES[sorted_ids_[j - 1]], PARAM_NAMES[i], PARAMS_NAME_LENGTH) > 0)
+    {
+      sorted_ids_[j] = sorted_ids_[j - 1];
+      j--;
+    }
+    sorted_ids_[j] = i;
+  }
+}
+
+uint16_t Params::lookup_param_id(const char name[PARAMS_NAME_LENGTH])
+{
+  // binary search over the names in sorted order; names that fill all PARAMS_NAME_LENGTH characters have no
+  // terminator, which strncmp() handles the same way on both sides
+  uint16_t lo = 0;
+  uint16_t hi = PARAMS_COUNT;
+  while (lo < hi)
+  {
+    uint16_t mid = static_cast<uint16_t>((lo + hi) / 2);
+    int cmp = strncmp(PARAM_NAMES[sorted_ids_[mid]], name, PARAMS_NAME_LENGTH);
+    if (cmp == 0)
+      return sorted_ids_[mid];
+    if (cmp < 0)
+      lo = static_cast<uint16_t>(mid + 1);
+    else
+      hi = mid;
+  }
 
   return PARAMS_COUNT;
 }
 
+uint16_t Params::checksum(uint16_t first, uint16_t count) const
+{
+  uint16_t end = static_cast<uint16_t>(PARAMS_COUNT);
+  if (first < PARAMS_COUNT && count < PARAMS_COUNT - first)
+    end = static_cast<uint16_t>(first + count);
+  uint16_t chk = 0;
+  for (uint16_t id = first; id < end; id++)
+  {
+    size_t name_len = 0;
+    while (name_len < PARAMS_NAME_LENGTH && PARAM_NAMES[id][name_len] != '\0')
+      name_len++;
+    uint8_t type = static_cast<uint8_t>(PARAM_TYPES[id]);
+
+    chk = checksum_fletcher16(reinterpret_cast<const uint8_t *>(PARAM_NAMES[id]), name_len, false, chk);
+    chk = checksum_fletcher16(&type, 1, false, chk);
+    chk = checksum_fletcher16(reinterpret_cast<const uint8_t *>(&values_[id]), sizeof(param_value_t), false, chk);
+  }
+  return checksum_fletcher16(nullptr, 0, true, chk);
+}
+
 bool Params::set_param_int(uint16_t id, int32_t value)
 {
-  if (id < PARAMS_COUNT && value != params.values[id].ivalue)
+  if (id < PARAMS_COUNT && value != values_[id].ivalue)
   {
-    params.values[id].ivalue = value;
+    values_[id].ivalue = value;
+    mark_unsaved(id);
     change_callback(id);
-    RF_.comm_manager_.send_param_value(id);
+    RF_.comm_manager_.queue_param_value(id);
     return true;
   }
   return false;
@@ -377,11 +516,12 @@ bool Params::set_param_int(uint16_t id, int32_t value)
 
 bool Params::set_param_float(uint16_t id, float value)
 {
-  if (id < PARAMS_COUNT && value != params.values[id].fvalue)
+  if (id < PARAMS_COUNT && value != values_[id].fvalue)
   {
-    params.values[id].fvalue = value;
+    values_[id].fvalue = value;
+    mark_unsaved(id);
     change_callback(id);
-    RF_.comm_manager_.send_parameter_list();
+    RF_.comm_manager_.queue_param_value(id);
     return true;
   }
   return false;
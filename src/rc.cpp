@@ -33,8 +33,6 @@
 
 #include "rosflight.h"
 
-#include <cstring>
-
 namespace rosflight_firmware
 {
 RC::RC(ROSflight &_rf) : RF_(_rf) {}
@@ -53,18 +51,34 @@ void RC::init_rc()
 }
 
 void RC::param_change_callback(uint16_t param_id)
+{
+  apply_param_updates(param_updates(param_id));
+}
+
+void RC::param_batch_change_callback(const uint16_t *param_ids, uint16_t count)
+{
+  uint8_t updates = 0;
+  for (uint16_t i = 0; i < count; i++)
+    updates = static_cast<uint8_t>(updates | param_updates(param_ids[i]));
+  apply_param_updates(updates);
+}
+
+bool RC::param_is_relevant(uint16_t param_id) const
+{
+  return param_updates(param_id) != 0;
+}
+
+uint8_t RC::param_updates(uint16_t param_id) const
 {
   switch (param_id)
   {
   case PARAM_RC_TYPE:
-    RF_.board_.rc_init(static_cast<Board::rc_type_t>(RF_.params_.get_param_int(PARAM_RC_TYPE)));
-    break;
+    return UPDATE_RC_TYPE;
   case PARAM_RC_X_CHANNEL:
   case PARAM_RC_Y_CHANNEL:
   case PARAM_RC_Z_CHANNEL:
   case PARAM_RC_F_CHANNEL:
-    init_sticks();
-    break;
+    return UPDATE_STICKS;
   case PARAM_RC_ATTITUDE_OVERRIDE_CHANNEL:
   case PARAM_RC_THROTTLE_OVERRIDE_CHANNEL:
   case PARAM_RC_ATT_CONTROL_TYPE_CHANNEL:
@@ -73,14 +87,22 @@ void RC::param_change_callback(uint16_t param_id)
   case PARAM_RC_SWITCH_6_DIRECTION:
   case PARAM_RC_SWITCH_7_DIRECTION:
   case PARAM_RC_SWITCH_8_DIRECTION:
-    init_switches();
-    break;
+    return UPDATE_SWITCHES;
   default:
-    // do nothing
-    break;
+    return 0;
   }
 }
 
+void RC::apply_param_updates(uint8_t updates)
+{
+  if (updates & UPDATE_RC_TYPE)
+    RF_.board_.rc_init(static_cast<Board::rc_type_t>(RF_.params_.get_param_int(PARAM_RC_TYPE)));
+  if (updates & UPDATE_STICKS)
+    init_sticks();
+  if (updates & UPDATE_SWITCHES)
+    init_switches();
+}
+
 float RC::stick(Stick channel)
 {
   return stick_values[channel];
@@ -115,29 +137,35 @@ void RC::init_switches()
 {
   for (uint8_t chan = 0; chan < static_cast<uint8_t>(SWITCHES_COUNT); chan++)
   {
-    char channel_name[18];
+    LogMessageId mapped_msg;
+    LogMessageId not_mapped_msg;
     switch (chan)
     {
     case SWITCH_ARM:
-      strcpy(channel_name, "ARM");
+      mapped_msg = LOG_MSG_SWITCH_ARM_MAPPED;
+      not_mapped_msg = LOG_MSG_SWITCH_ARM_NOT_MAPPED;
       switches[chan].channel = RF_.params_.get_param_int(PARAM_RC_ARM_CHANNEL);
       break;
     case SWITCH_ATT_OVERRIDE:
-      strcpy(channel_name, "ATTITUDE OVERRIDE");
+      mapped_msg = LOG_MSG_SWITCH_ATT_OVERRIDE_MAPPED;
+      not_mapped_msg = LOG_MSG_SWITCH_ATT_OVERRIDE_NOT_MAPPED;
       switches[chan].channel = RF_.params_.get_param_int(PARAM_RC_ATTITUDE_OVERRIDE_CHANNEL);
       break;
     case SWITCH_THROTTLE_OVERRIDE:
-      strcpy(channel_name, "THROTTLE OVERRIDE");
+      mapped_msg = LOG_MSG_SWITCH_THROTTLE_OVERRIDE_MAPPED;
+      not_mapped_msg = LOG_MSG_SWITCH_THROTTLE_OVERRIDE_NOT_MAPPED;
       switches[chan].channel = RF_.params_.get_param_int(PARAM_RC_THROTTLE_OVERRIDE_CHANNEL);
       break;
     case SWITCH_ATT_TYPE:
-      strcpy(channel_name, "ATTITUDE TYPE");
+      mapped_msg = LOG_MSG_SWITCH_ATT_TYPE_MAPPED;
+      not_mapped_msg = LOG_MSG_SWITCH_ATT_TYPE_NOT_MAPPED;
       switches[chan].channel = RF_.params_.get_param_int(PARAM_RC_ATT_CONTROL_TYPE_CHANNEL);
       break;
     default:
-      strcpy(channel_name, "INVALID");
       switches[chan].channel = 255;
-      break;
+      switches[chan].mapped = false;
+      switches[chan].direction = 1;
+      continue;
     }
 
     switches[chan].mapped =
@@ -163,10 +191,9 @@ void RC::init_switches()
     }
 
     if (switches[chan].mapped)
-      RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_INFO, "%s switch mapped to RC channel %d", channel_name,
-                            switches[chan].channel);
+      RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_INFO, mapped_msg, switches[chan].channel);
     else
-      RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_INFO, "%s switch not mapped", channel_name);
+      RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_INFO, not_mapped_msg);
   }
 }
 
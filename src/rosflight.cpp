@@ -45,7 +45,8 @@ ROSflight::ROSflight(Board& board, CommLinkInterface& comm_link) :
   mixer_(*this),
   rc_(*this),
   sensors_(*this),
-  state_manager_(*this)
+  state_manager_(*this),
+  blackbox_(*this)
 {
   comm_link.set_listener(&comm_manager_);
   params_.set_listeners(param_listeners_, num_param_listeners_);
@@ -89,6 +90,9 @@ void ROSflight::init()
   // Initialize the command muxer
   command_manager_.init();
 
+  // Find where the flight log left off
+  blackbox_.init();
+
   /***************************/
   /***  Hardfault Recovery ***/
   /***************************/
@@ -110,6 +114,7 @@ void ROSflight::run()
     controller_.run();
     mixer_.mix_output();
     loop_time_us = board_.clock_micros() - start;
+    blackbox_.record();
   }
 
   /*********************/
@@ -129,6 +134,9 @@ void ROSflight::run()
 
   // update commands (internal logic tells whether or not we should do anything or not)
   command_manager_.run();
+
+  // hand recorded pages to the log storage
+  blackbox_.run();
 }
 
 uint32_t ROSflight::get_loop_time_us()
@@ -100,27 +100,52 @@ void Sensors::init_imu()
 }
 
 void Sensors::param_change_callback(uint16_t param_id)
+{
+  apply_param_updates(param_updates(param_id));
+}
+
+void Sensors::param_batch_change_callback(const uint16_t *param_ids, uint16_t count)
+{
+  uint8_t updates = 0;
+  for (uint16_t i = 0; i < count; i++)
+    updates = static_cast<uint8_t>(updates | param_updates(param_ids[i]));
+  apply_param_updates(updates);
+}
+
+bool Sensors::param_is_relevant(uint16_t param_id) const
+{
+  return param_updates(param_id) != 0;
+}
+
+uint8_t Sensors::param_updates(uint16_t param_id) const
 {
   switch (param_id)
   {
   case PARAM_FC_ROLL:
   case PARAM_FC_PITCH:
   case PARAM_FC_YAW:
-    init_imu();
-    break;
+    return UPDATE_IMU;
   case PARAM_BATTERY_VOLTAGE_MULTIPLIER:
   case PARAM_BATTERY_CURRENT_MULTIPLIER:
-    update_battery_monitor_multipliers();
-    break;
+    return UPDATE_BATTERY_MULTIPLIERS;
   case PARAM_BATTERY_VOLTAGE_ALPHA:
-    battery_voltage_alpha_ = rf_.params_.get_param_float(PARAM_BATTERY_VOLTAGE_ALPHA);
-    break;
   case PARAM_BATTERY_CURRENT_ALPHA:
-    battery_current_alpha_ = rf_.params_.get_param_float(PARAM_BATTERY_CURRENT_ALPHA);
-    break;
+    return UPDATE_BATTERY_ALPHAS;
   default:
-    // do nothing
-    break;
+    return 0;
+  }
+}
+
+void Sensors::apply_param_updates(uint8_t updates)
+{
+  if (updates & UPDATE_IMU)
+    init_imu();
+  if (updates & UPDATE_BATTERY_MULTIPLIERS)
+    update_battery_monitor_multipliers();
+  if (updates & UPDATE_BATTERY_ALPHAS)
+  {
+    battery_voltage_alpha_ = rf_.params_.get_param_float(PARAM_BATTERY_VOLTAGE_ALPHA);
+    battery_current_alpha_ = rf_.params_.get_param_float(PARAM_BATTERY_CURRENT_ALPHA);
   }
 }
 
@@ -255,18 +280,22 @@ bool Sensors::start_imu_calibration(void)
   start_gyro_calibration();
 
   calibrating_acc_flag_ = true;
+  rf_.params_.begin_transaction();
   rf_.params_.set_param_float(PARAM_ACC_X_BIAS, 0.0);
   rf_.params_.set_param_float(PARAM_ACC_Y_BIAS, 0.0);
   rf_.params_.set_param_float(PARAM_ACC_Z_BIAS, 0.0);
+  rf_.params_.commit_transaction();
   return true;
 }
 
 bool Sensors::start_gyro_calibration(void)
 {
   calibrating_gyro_flag_ = true;
+  rf_.params_.begin_transaction();
   rf_.params_.set_param_float(PARAM_GYRO_X_BIAS, 0.0);
   rf_.params_.set_param_float(PARAM_GYRO_Y_BIAS, 0.0);
   rf_.params_.set_param_float(PARAM_GYRO_Z_BIAS, 0.0);
+  rf_.params_.commit_transaction();
   return true;
 }
 
@@ -333,6 +362,8 @@ bool Sensors::update_imu(void)
     gyro_int_ += dt * data_.gyro;
     prev_imu_read_time_us_ = data_.imu_time;
 
+    push_imu_sample();
+
     return true;
   }
   else
@@ -367,6 +398,35 @@ void Sensors::get_filtered_IMU(turbomath::Vector &accel, turbomath::Vector &gyro
   stamp_us = data_.imu_time;
 }
 
+void Sensors::push_imu_sample()
+{
+  // quietly over-write the oldest sample if nobody is draining the ring
+  if (imu_ring_length_ == IMU_SAMPLE_RING_SIZE)
+  {
+    imu_ring_oldest_ = static_cast<uint8_t>((imu_ring_oldest_ + 1) % IMU_SAMPLE_RING_SIZE);
+    imu_ring_length_--;
+    imu_ring_overwritten_++;
+  }
+
+  ImuSample &sample = imu_ring_[(imu_ring_oldest_ + imu_ring_length_) % IMU_SAMPLE_RING_SIZE];
+  sample.time_us = data_.imu_time;
+  sample.accel = data_.accel;
+  sample.gyro = data_.gyro;
+  imu_ring_length_++;
+}
+
+uint8_t Sensors::read_imu_samples(ImuSample *dest, uint8_t max_count)
+{
+  uint8_t count = (max_count < imu_ring_length_) ? max_count : imu_ring_length_;
+  for (uint8_t i = 0; i < count; i++)
+  {
+    dest[i] = imu_ring_[imu_ring_oldest_];
+    imu_ring_oldest_ = static_cast<uint8_t>((imu_ring_oldest_ + 1) % IMU_SAMPLE_RING_SIZE);
+  }
+  imu_ring_length_ = static_cast<uint8_t>(imu_ring_length_ - count);
+  return count;
+}
+
 void Sensors::update_battery_monitor()
 {
   if (rf_.board_.battery_voltage_present())
@@ -397,9 +457,11 @@ void Sensors::calibrate_gyro()
 
     if (gyro_bias.norm() < 1.0)
     {
+      rf_.params_.begin_transaction();
       rf_.params_.set_param_float(PARAM_GYRO_X_BIAS, gyro_bias.x);
       rf_.params_.set_param_float(PARAM_GYRO_Y_BIAS, gyro_bias.y);
       rf_.params_.set_param_float(PARAM_GYRO_Z_BIAS, gyro_bias.z);
+      rf_.params_.commit_transaction();
 
       // Tell the estimator to reset it's bias estimate, because it should be zero now
       rf_.estimator_.reset_adaptive_bias();
@@ -411,7 +473,7 @@ void Sensors::calibrate_gyro()
     {
       // Tell the state manager that we just failed a gyro calibration
       rf_.state_manager_.set_event(StateManager::EVENT_CALIBRATION_FAILED);
-      rf_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, "Too much movement for gyro cal");
+      rf_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, LOG_MSG_GYRO_CAL_MOVEMENT);
     }
 
     // reset calibration in case we do it again
@@ -463,7 +525,7 @@ void Sensors::calibrate_accel(void)
     // then don't do anything
     if ((max_ - min_).norm() > 1.0)
     {
-      rf_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, "Too much movement for IMU cal");
+      rf_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, LOG_MSG_IMU_CAL_MOVEMENT);
       calibrating_acc_flag_ = false;
     }
     else
@@ -474,10 +536,12 @@ void Sensors::calibrate_accel(void)
 
       if (accel_bias.norm() < 3.0)
       {
+        rf_.params_.begin_transaction();
         rf_.params_.set_param_float(PARAM_ACC_X_BIAS, accel_bias.x);
         rf_.params_.set_param_float(PARAM_ACC_Y_BIAS, accel_bias.y);
         rf_.params_.set_param_float(PARAM_ACC_Z_BIAS, accel_bias.z);
-        rf_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_INFO, "IMU offsets captured");
+        rf_.params_.commit_transaction();
+        rf_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_INFO, LOG_MSG_IMU_CAL_DONE);
 
         // clear uncalibrated IMU flag
         rf_.state_manager_.clear_error(StateManager::ERROR_UNCALIBRATED_IMU);
@@ -486,7 +550,7 @@ void Sensors::calibrate_accel(void)
       {
         // This usually means the user has the FCU in the wrong orientation, or something is wrong
         // with the board IMU (like it's a cheap chinese clone)
-        rf_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, "large accel bias: norm = %d.%d",
+        rf_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, LOG_MSG_LARGE_ACCEL_BIAS,
                               static_cast<uint32_t>(accel_bias.norm()),
                               static_cast<uint32_t>(accel_bias.norm() * 1000) % 1000);
       }
@@ -522,11 +586,11 @@ void Sensors::calibrate_baro()
       {
         rf_.params_.set_param_float(PARAM_BARO_BIAS, baro_calibration_mean_);
         baro_calibrated_ = true;
-        rf_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_INFO, "Baro Cal successful!");
+        rf_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_INFO, LOG_MSG_BARO_CAL_DONE);
       }
       else
       {
-        rf_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, "Too much movement for barometer cal");
+        rf_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, LOG_MSG_BARO_CAL_MOVEMENT);
       }
       baro_calibration_mean_ = 0.0f;
       baro_calibration_var_ = 0.0f;
@@ -559,11 +623,11 @@ void Sensors::calibrate_diff_pressure()
       {
         rf_.params_.set_param_float(PARAM_DIFF_PRESS_BIAS, diff_pressure_calibration_mean_);
         diff_pressure_calibrated_ = true;
-        rf_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_INFO, "Airspeed Cal Successful!");
+        rf_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_INFO, LOG_MSG_AIRSPEED_CAL_DONE);
       }
       else
       {
-        rf_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, "Too much movement for diff pressure cal");
+        rf_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, LOG_MSG_AIRSPEED_CAL_MOVEMENT);
       }
       diff_pressure_calibration_mean_ = 0.0f;
       diff_pressure_calibration_var_ = 0.0f;
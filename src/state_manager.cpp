@@ -137,13 +137,12 @@ void StateManager::set_event(StateManager::Event event)
         }
         else
         {
-          RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR,
-                                "RC throttle override must be active to arm");
+          RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, LOG_MSG_ARM_NEEDS_THROTTLE_OVERRIDE);
         }
       }
       else
       {
-        RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, "Cannot arm with RC throttle high");
+        RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, LOG_MSG_ARM_THROTTLE_HIGH);
       }
       break;
     default:
@@ -170,19 +169,19 @@ void StateManager::set_event(StateManager::Event event)
       if (next_arming_error_msg_ms_ < RF_.board_.clock_millis())
       {
         if (state_.error_codes & StateManager::ERROR_INVALID_MIXER)
-          RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, "Unable to arm: Invalid mixer");
+          RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, LOG_MSG_ARM_INVALID_MIXER);
         if (state_.error_codes & StateManager::ERROR_IMU_NOT_RESPONDING)
-          RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, "Unable to arm: IMU not responding");
+          RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, LOG_MSG_ARM_IMU_NOT_RESPONDING);
         if (state_.error_codes & StateManager::ERROR_RC_LOST)
-          RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, "Unable to arm: RC signal lost");
+          RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, LOG_MSG_ARM_RC_LOST);
         if (state_.error_codes & StateManager::ERROR_UNHEALTHY_ESTIMATOR)
-          RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, "Unable to arm: Unhealthy estimator");
+          RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, LOG_MSG_ARM_UNHEALTHY_ESTIMATOR);
         if (state_.error_codes & StateManager::ERROR_TIME_GOING_BACKWARDS)
-          RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, "Unable to arm: Time going backwards");
+          RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, LOG_MSG_ARM_TIME_BACKWARDS);
         if (state_.error_codes & StateManager::ERROR_UNCALIBRATED_IMU)
-          RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, "Unable to arm: IMU not calibrated");
+          RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, LOG_MSG_ARM_UNCALIBRATED_IMU);
         if (state_.error_codes & StateManager::ERROR_INVALID_FAILSAFE)
-          RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, "Unable to arm: Invalid failsafe setting");
+          RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_ERROR, LOG_MSG_ARM_INVALID_FAILSAFE);
 
         next_arming_error_msg_ms_ = RF_.board_.clock_millis() + 1000; // throttle messages to 1 Hz
       }
@@ -304,17 +303,17 @@ void StateManager::check_backup_memory()
         {
           state_.armed = true;
           fsm_state_ = FSM_STATE_ARMED;
-          RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_CRITICAL, "Rearming after hardfault!!!");
+          RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_CRITICAL, LOG_MSG_HARDFAULT_REARMED);
         }
         else
         {
-          RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_CRITICAL, "Failed to rearm after hardfault!!!");
+          RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_CRITICAL, LOG_MSG_HARDFAULT_REARM_FAILED);
         }
       }
 
       // queue sending backup data over comm link
       RF_.comm_manager_.send_backup_data(data);
-      RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_CRITICAL, "Recovered from hardfault!!!");
+      RF_.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_CRITICAL, LOG_MSG_HARDFAULT_RECOVERED);
     }
 
     RF_.board_.backup_memory_clear(sizeof(data));
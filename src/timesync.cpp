@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2017, James Jackson and Daniel Koch, BYU MAGICC Lab
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "timesync.h"
+
+#include <cmath>
+
+namespace rosflight_firmware
+{
+constexpr uint8_t TimeSync::MIN_SAMPLES;
+constexpr uint8_t TimeSync::FIT_SAMPLES;
+
+void TimeSync::reset()
+{
+  round_trip_ = false;
+  resyncs_ = 0;
+  restart();
+}
+
+void TimeSync::restart()
+{
+  samples_ = 0;
+  outliers_ = 0;
+  skew_ = 0.0f;
+  jitter_us_ = 0.0f;
+}
+
+void TimeSync::add_round_trip(uint64_t request_us, uint64_t reply_us, uint64_t remote_us)
+{
+  if (reply_us < request_us)
+    return;
+
+  if (!round_trip_)
+  {
+    // the one way samples so far include the uplink delay, so the fit starts over without them
+    round_trip_ = true;
+    restart();
+  }
+  uint64_t midpoint_us = request_us + (reply_us - request_us) / 2;
+  add_sample(midpoint_us, static_cast<int64_t>(remote_us - midpoint_us));
+}
+
+void TimeSync::add_one_way(uint64_t receive_us, uint64_t remote_us)
+{
+  if (!round_trip_)
+    add_sample(receive_us, static_cast<int64_t>(remote_us - receive_us));
+}
+
+void TimeSync::add_sample(uint64_t local_us, int64_t offset)
+{
+  if (samples_ == 0)
+  {
+    ref_us_ = local_us;
+    offset_ = offset;
+    samples_ = 1;
+    return;
+  }
+
+  int64_t dt_us = static_cast<int64_t>(local_us - ref_us_);
+  if (dt_us <= 0)
+    return; // out of order
+
+  float dt = static_cast<float>(dt_us);
+  int64_t predicted = offset_ + static_cast<int64_t>(skew_ * dt);
+  float residual = static_cast<float>(offset - predicted);
+
+  if (valid())
+  {
+    float limit = OUTLIER_JITTERS * jitter_us_;
+    if (limit < OUTLIER_MIN_US)
+      limit = OUTLIER_MIN_US;
+    if (std::fabs(residual) > limit)
+    {
+      if (++outliers_ < MAX_OUTLIERS)
+        return;
+
+      // the companion clock was stepped
+      resyncs_++;
+      restart();
+      add_sample(local_us, offset);
+      return;
+    }
+  }
+  outliers_ = 0;
+
+  // Gains of the least squares line fit through the last k evenly spaced samples, with k growing to FIT_SAMPLES. With
+  // two samples the line goes through both.
+  if (samples_ < FIT_SAMPLES)
+    samples_++;
+  float k = static_cast<float>(samples_);
+  float alpha = 2.0f * (2.0f * k - 1.0f) / (k * (k + 1.0f));
+  float beta = 6.0f / (k * (k + 1.0f));
+
+  offset_ = predicted + static_cast<int64_t>(alpha * residual);
+  skew_ += beta * residual / dt;
+  jitter_us_ += JITTER_GAIN * (std::fabs(residual) - jitter_us_);
+  ref_us_ = local_us;
+}
+
+int64_t TimeSync::offset_us(uint64_t local_us) const
+{
+  int64_t dt_us = static_cast<int64_t>(local_us - ref_us_);
+  return offset_ + static_cast<int64_t>(skew_ * static_cast<float>(dt_us));
+}
+
+uint64_t TimeSync::to_local(uint64_t remote_us) const
+{
+  // the offset changes so slowly that evaluating it at the approximate board time is exact to well under 1 us
+  uint64_t approx_local_us = remote_us - static_cast<uint64_t>(offset_);
+  return remote_us - static_cast<uint64_t>(offset_us(approx_local_us));
+}
+
+} // namespace rosflight_firmware
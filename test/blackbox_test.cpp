@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2017, James Jackson and Daniel Koch, BYU MAGICC Lab
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "common.h"
+#include "mavlink.h"
+#include "test_board.h"
+
+#include "rosflight.h"
+
+#include <cstring>
+
+using namespace rosflight_firmware;
+
+class BlackboxTest : public ::testing::Test
+{
+public:
+  testBoard board;
+  Mavlink mavlink;
+  ROSflight rf;
+
+  BlackboxTest() : mavlink(board), rf(board, mavlink) {}
+
+  void SetUp() override
+  {
+    board.backup_memory_clear();
+    rf.init();
+    rf.state_manager_.clear_error(rf.state_manager_.state().error_codes);
+    rf.params_.set_param_int(PARAM_CALIBRATE_GYRO_ON_ARM, false);
+    rf.params_.set_param_int(PARAM_BLACKBOX_FIELDS, Blackbox::FIELD_IMU | Blackbox::FIELD_TIMING);
+  }
+
+  void fly(uint32_t us)
+  {
+    rf.state_manager_.set_event(StateManager::EVENT_REQUEST_ARM);
+    ASSERT_TRUE(rf.state_manager_.state().armed);
+    step_firmware(rf, board, us);
+    rf.state_manager_.set_event(StateManager::EVENT_REQUEST_DISARM);
+    step_firmware(rf, board, 10000);
+  }
+
+  Blackbox::page_header_t page_header(size_t page)
+  {
+    Blackbox::page_header_t header;
+    memcpy(&header, board.log_storage() + page * Blackbox::PAGE_SIZE, sizeof(header));
+    return header;
+  }
+};
+
+static uint64_t get_varint(const uint8_t *&p)
+{
+  uint64_t value = 0;
+  for (int shift = 0;; shift += 7)
+  {
+    uint8_t byte = *p++;
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if (!(byte & 0x80))
+      return value;
+  }
+}
+
+static int32_t get_zigzag(const uint8_t *&p)
+{
+  uint32_t zigzag = static_cast<uint32_t>(get_varint(p));
+  return static_cast<int32_t>((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+}
+
+TEST_F(BlackboxTest, NothingIsRecordedWhileDisarmed)
+{
+  step_firmware(rf, board, 100000);
+  EXPECT_EQ(rf.blackbox_.used_bytes(), 0u);
+  EXPECT_EQ(page_header(0).session, 0xFFFF);
+}
+
+TEST_F(BlackboxTest, PagesDecodeToTheRecordedFrames)
+{
+  fly(200000);
+  ASSERT_FALSE(rf.blackbox_.recording());
+  ASSERT_GT(rf.blackbox_.frames_recorded(), 150u);
+  EXPECT_EQ(rf.blackbox_.frames_dropped(), 0u);
+  ASSERT_GE(rf.blackbox_.used_bytes(), 2 * Blackbox::PAGE_SIZE);
+
+  uint32_t frames = 0;
+  for (size_t page = 0; page < rf.blackbox_.used_bytes() / Blackbox::PAGE_SIZE; page++)
+  {
+    Blackbox::page_header_t header = page_header(page);
+    EXPECT_EQ(header.session, 0);
+    EXPECT_EQ(header.version, Blackbox::FORMAT_VERSION);
+    EXPECT_EQ(header.fields, Blackbox::FIELD_IMU | Blackbox::FIELD_TIMING);
+
+    const uint8_t *p = board.log_storage() + page * Blackbox::PAGE_SIZE + sizeof(header);
+    const uint8_t *end = p + header.length;
+    int32_t values[7] = {0};
+    bool first = true;
+    while (p < end)
+    {
+      uint8_t type = *p++;
+      EXPECT_EQ(type, first ? Blackbox::FRAME_KEY : Blackbox::FRAME_DELTA);
+      uint64_t time = get_varint(p);
+      if (!first)
+      {
+        EXPECT_EQ(time, 1000u); // one frame per IMU sample
+      }
+      for (int i = 0; i < 7; i++)
+        values[i] = first ? get_zigzag(p) : values[i] + get_zigzag(p);
+      EXPECT_NEAR(values[2], -9807, 50); // accel z, mm/s^2
+      EXPECT_EQ(values[3], 0);           // gyro x
+      first = false;
+      frames++;
+    }
+    EXPECT_EQ(p, end);
+  }
+  EXPECT_EQ(frames, rf.blackbox_.frames_recorded());
+}
+
+TEST_F(BlackboxTest, DividerSkipsLoops)
+{
+  rf.params_.set_param_int(PARAM_BLACKBOX_DIVIDER, 4);
+  fly(100000);
+  EXPECT_NEAR(rf.blackbox_.frames_recorded(), 25u, 1u);
+}
+
+TEST_F(BlackboxTest, FramesAreDroppedWhileStorageIsBusy)
+{
+  board.set_log_storage_latency(1000);
+  fly(100000);
+  EXPECT_GT(rf.blackbox_.frames_dropped(), 0u);
+}
+
+TEST_F(BlackboxTest, SessionsAppendAcrossReboots)
+{
+  fly(100000);
+  size_t first_session_bytes = rf.blackbox_.used_bytes();
+  ASSERT_GT(first_session_bytes, 0u);
+
+  ROSflight rebooted(board, mavlink);
+  rebooted.init();
+  EXPECT_EQ(rebooted.blackbox_.used_bytes(), first_session_bytes);
+
+  rebooted.state_manager_.clear_error(rebooted.state_manager_.state().error_codes);
+  rebooted.params_.set_param_int(PARAM_CALIBRATE_GYRO_ON_ARM, false);
+  rebooted.params_.set_param_int(PARAM_BLACKBOX_FIELDS, Blackbox::FIELDS_ALL);
+  step_firmware(rebooted, board, 10000);
+  rebooted.state_manager_.set_event(StateManager::EVENT_REQUEST_ARM);
+  ASSERT_TRUE(rebooted.state_manager_.state().armed);
+  step_firmware(rebooted, board, 100000);
+  rebooted.state_manager_.set_event(StateManager::EVENT_REQUEST_DISARM);
+  step_firmware(rebooted, board, 10000);
+
+  ASSERT_GT(rebooted.blackbox_.used_bytes(), first_session_bytes);
+  Blackbox::page_header_t header = page_header(first_session_bytes / Blackbox::PAGE_SIZE);
+  EXPECT_EQ(header.session, 1);
+  EXPECT_EQ(header.fields, Blackbox::FIELDS_ALL);
+}
+
+TEST_F(BlackboxTest, RecordingStopsWhenStorageIsFullUntilErased)
+{
+  rf.params_.set_param_int(PARAM_BLACKBOX_FIELDS, Blackbox::FIELDS_ALL);
+  fly(2000000);
+  EXPECT_EQ(rf.blackbox_.used_bytes(), 16384u);
+
+  EXPECT_TRUE(rf.blackbox_.erase());
+  EXPECT_EQ(rf.blackbox_.used_bytes(), 0u);
+  EXPECT_EQ(page_header(0).session, 0xFFFF);
+}
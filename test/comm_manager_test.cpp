@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2017, James Jackson and Daniel Koch, BYU MAGICC Lab
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "common.h"
+#include "mavlink.h"
+#include "test_board.h"
+
+#include "rosflight.h"
+
+using namespace rosflight_firmware;
+
+class CommManagerTest : public ::testing::Test
+{
+public:
+  testBoard board;
+  Mavlink mavlink;
+  ROSflight rf;
+
+  CommManagerTest() : mavlink(board), rf(board, mavlink) {}
+
+  void SetUp() override
+  {
+    board.backup_memory_clear();
+    rf.init();
+    rf.state_manager_.clear_error(rf.state_manager_.state().error_codes);
+  }
+
+  CommManager::StreamStats stats(CommManager::StreamId id) { return rf.comm_manager_.stream_stats(id); }
+};
+
+TEST_F(CommManagerTest, StreamsRunAtRequestedRateWhenLinkHasRoom)
+{
+  step_firmware(rf, board, 2500000);
+
+  CommManager::StreamStats imu = stats(CommManager::STREAM_ID_IMU);
+  EXPECT_EQ(imu.scheduled_period_us, imu.requested_period_us);
+  EXPECT_NEAR(imu.achieved_rate_hz, 250.0f, 5.0f);
+  EXPECT_EQ(imu.dropped, 0u);
+
+  CommManager::StreamStats attitude = stats(CommManager::STREAM_ID_ATTITUDE);
+  EXPECT_EQ(attitude.scheduled_period_us, attitude.requested_period_us);
+  EXPECT_NEAR(attitude.achieved_rate_hz, 200.0f, 5.0f);
+}
+
+TEST_F(CommManagerTest, LowPriorityStreamsDegradeToFitLink)
+{
+  // 115200 baud carries roughly 9 kB/s of telemetry at the default link load
+  rf.params_.set_param_int(PARAM_BAUD_RATE, 115200);
+  rf.params_.set_param_int(PARAM_STREAM_IMU_RATE, 100);
+  rf.params_.set_param_int(PARAM_STREAM_ATTITUDE_RATE, 100);
+  step_firmware(rf, board, 1000000);
+
+  uint32_t start_bytes = mavlink.tx_byte_count();
+  step_firmware(rf, board, 2000000);
+  float bytes_per_s = static_cast<float>(mavlink.tx_byte_count() - start_bytes) / 2.0f;
+  EXPECT_LE(bytes_per_s, rf.comm_manager_.link_budget_bytes_per_s() * 1.05f);
+
+  // high-rate estimator data gets through untouched
+  EXPECT_NEAR(stats(CommManager::STREAM_ID_IMU).achieved_rate_hz, 100.0f, 2.0f);
+  EXPECT_NEAR(stats(CommManager::STREAM_ID_ATTITUDE).achieved_rate_hz, 100.0f, 2.0f);
+
+  // lower-priority streams are slowed down, but not starved
+  CommManager::StreamStats servo = stats(CommManager::STREAM_ID_SERVO_OUTPUT_RAW);
+  EXPECT_GT(servo.scheduled_period_us, servo.requested_period_us);
+  EXPECT_LT(servo.achieved_rate_hz, 50.0f);
+  EXPECT_GE(servo.achieved_rate_hz, 1.0f);
+}
+
+TEST_F(CommManagerTest, MissedDeadlinesAreCountedAsDrops)
+{
+  rf.params_.set_param_int(PARAM_STREAM_IMU_RATE, 100);
+  step_firmware(rf, board, 100000);
+  uint32_t dropped = stats(CommManager::STREAM_ID_IMU).dropped;
+
+  // stall the loop for five IMU periods
+  board.set_time(board.clock_micros() + 50000);
+  step_firmware(rf, board, 1000);
+
+  EXPECT_GE(stats(CommManager::STREAM_ID_IMU).dropped, dropped + 4);
+}
+
+TEST_F(CommManagerTest, EnabledStreamIsScheduledWithoutWaitingForOtherDeadlines)
+{
+  rf.params_.set_param_int(PARAM_STREAM_IMU_RATE, 0);
+  step_firmware(rf, board, 100000);
+  uint32_t sent = stats(CommManager::STREAM_ID_IMU).sent;
+
+  rf.params_.set_param_int(PARAM_STREAM_IMU_RATE, 100);
+  step_firmware(rf, board, 1000);
+  EXPECT_EQ(stats(CommManager::STREAM_ID_IMU).sent, sent + 1);
+}
+
+TEST_F(CommManagerTest, ImuBatchStreamDrainsEveryRawSample)
+{
+  // step_firmware produces a new IMU sample every millisecond
+  rf.params_.set_param_int(PARAM_STREAM_IMU_BATCH_RATE, 125);
+  step_firmware(rf, board, 1000000);
+  uint32_t overwritten = rf.sensors_.imu_samples_overwritten();
+  step_firmware(rf, board, 1000000);
+
+  EXPECT_EQ(rf.sensors_.imu_samples_overwritten(), overwritten);
+  EXPECT_LT(rf.sensors_.imu_samples_available(), static_cast<uint8_t>(CommLinkInterface::IMU_BATCH_MAX_SAMPLES));
+  EXPECT_NEAR(stats(CommManager::STREAM_ID_IMU_BATCH).achieved_rate_hz, 125.0f, 2.0f);
+}
+
+TEST_F(CommManagerTest, ImuSampleRingKeepsNewestSamples)
+{
+  step_firmware(rf, board, 100000);
+  EXPECT_GT(rf.sensors_.imu_samples_overwritten(), 0u);
+
+  Sensors::ImuSample samples[Sensors::IMU_SAMPLE_RING_SIZE];
+  uint8_t count = rf.sensors_.read_imu_samples(samples, Sensors::IMU_SAMPLE_RING_SIZE);
+  ASSERT_EQ(count, static_cast<uint8_t>(Sensors::IMU_SAMPLE_RING_SIZE));
+  EXPECT_EQ(rf.sensors_.imu_samples_available(), 0);
+  for (uint8_t i = 1; i < count; i++)
+    EXPECT_EQ(samples[i].time_us - samples[i - 1].time_us, 1000u);
+  EXPECT_EQ(samples[count - 1].time_us, rf.sensors_.data().imu_time);
+  EXPECT_CLOSE(samples[count - 1].accel.z, rf.sensors_.data().accel.z);
+}
+
+TEST_F(CommManagerTest, ParameterListIsSentInBurstsThatFitTheLink)
+{
+  CommLinkInterface::ListenerInterface& listener = rf.comm_manager_;
+  uint8_t sysid = static_cast<uint8_t>(rf.params_.get_param_int(PARAM_SYSTEM_ID));
+  listener.param_request_list_callback(sysid);
+  EXPECT_EQ(rf.comm_manager_.params_pending(), static_cast<uint16_t>(PARAMS_COUNT));
+
+  // the whole table fits in well under a second at the default baud rate
+  step_firmware(rf, board, 200000);
+  EXPECT_EQ(rf.comm_manager_.params_pending(), 0);
+
+  // a slow link still makes progress, but only with what the streams leave over
+  rf.params_.set_param_int(PARAM_BAUD_RATE, 57600);
+  listener.param_request_list_callback(sysid);
+  step_firmware(rf, board, 200000);
+  EXPECT_GT(rf.comm_manager_.params_pending(), 0);
+  EXPECT_LT(rf.comm_manager_.params_pending(), static_cast<uint16_t>(PARAMS_COUNT));
+}
+
+TEST_F(CommManagerTest, ParameterRangeRequestsMergeIntoOneTransfer)
+{
+  CommLinkInterface::ListenerInterface& listener = rf.comm_manager_;
+  uint8_t sysid = static_cast<uint8_t>(rf.params_.get_param_int(PARAM_SYSTEM_ID));
+
+  listener.param_request_range_callback(sysid, 10, 5);
+  listener.param_request_range_callback(sysid, 12, 5);
+  EXPECT_EQ(rf.comm_manager_.params_pending(), 7);
+
+  // out of range, addressed to someone else, or a table summary request: nothing to queue
+  listener.param_request_range_callback(sysid, PARAMS_COUNT, 5);
+  listener.param_request_range_callback(static_cast<uint8_t>(sysid + 1), 0, 5);
+  listener.param_request_range_callback(sysid, 0, 0);
+  EXPECT_EQ(rf.comm_manager_.params_pending(), 7);
+
+  listener.param_request_range_callback(sysid, PARAMS_COUNT - 2, 100);
+  EXPECT_EQ(rf.comm_manager_.params_pending(), 9);
+
+  step_firmware(rf, board, 20000);
+  EXPECT_EQ(rf.comm_manager_.params_pending(), 0);
+}
+
+TEST_F(CommManagerTest, ParameterChangesAreCoalescedUntilSent)
+{
+  step_firmware(rf, board, 20000);
+  ASSERT_EQ(rf.comm_manager_.params_pending(), 0);
+
+  rf.params_.set_param_float(PARAM_ACC_X_BIAS, 0.1f);
+  rf.params_.set_param_float(PARAM_ACC_Y_BIAS, 0.1f);
+  rf.params_.set_param_float(PARAM_ACC_Z_BIAS, 0.1f);
+  rf.params_.set_param_float(PARAM_ACC_X_BIAS, 0.2f);
+  rf.params_.set_param_int(PARAM_SPIN_MOTORS_WHEN_ARMED, 0);
+  EXPECT_EQ(rf.comm_manager_.params_pending(), 4);
+
+  step_firmware(rf, board, 20000);
+  EXPECT_EQ(rf.comm_manager_.params_pending(), 0);
+}
+
+TEST_F(CommManagerTest, OnlyParametersItAppliesAreRelevant)
+{
+  EXPECT_TRUE(rf.comm_manager_.param_is_relevant(PARAM_BAUD_RATE));
+  EXPECT_TRUE(rf.comm_manager_.param_is_relevant(PARAM_SYSTEM_ID));
+  EXPECT_TRUE(rf.comm_manager_.param_is_relevant(PARAM_STREAM_STATS_RATE));
+  EXPECT_TRUE(rf.comm_manager_.param_is_relevant(PARAM_STREAM_LINK_LOAD));
+  EXPECT_FALSE(rf.comm_manager_.param_is_relevant(PARAM_SERIAL_DEVICE));
+  EXPECT_FALSE(rf.comm_manager_.param_is_relevant(PARAM_LOG_BINARY));
+  EXPECT_FALSE(rf.comm_manager_.param_is_relevant(PARAM_TIMESYNC_STAMP));
+
+  rf.params_.set_param_int(PARAM_STREAM_STATS_RATE, 10);
+  EXPECT_EQ(stats(CommManager::STREAM_ID_STREAM_STATS).requested_period_us, 100000u);
+
+  float budget = rf.comm_manager_.link_budget_bytes_per_s();
+  rf.params_.set_param_float(PARAM_STREAM_LINK_LOAD, 0.4f);
+  EXPECT_NEAR(rf.comm_manager_.link_budget_bytes_per_s(), budget / 2.0f, 1.0f);
+}
+
+TEST_F(CommManagerTest, LogMessagesAreHeldUntilConnected)
+{
+  rf.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_INFO, LOG_MSG_PARAMS_DEFAULTED);
+  rf.comm_manager_.log(CommLinkInterface::LogSeverity::LOG_WARNING, LOG_MSG_PARAMS_MIGRATED, 3, 2, 1);
+  size_t queued = rf.comm_manager_.logs_pending();
+  ASSERT_GE(queued, 2u);
+
+  step_firmware(rf, board, 100000);
+  EXPECT_EQ(rf.comm_manager_.logs_pending(), queued);
+
+  rf.params_.set_param_int(PARAM_LOG_BINARY, 1);
+  static_cast<CommLinkInterface::ListenerInterface &>(rf.comm_manager_).heartbeat_callback();
+  step_firmware(rf, board, 2000000);
+  EXPECT_EQ(rf.comm_manager_.logs_pending(), 0u);
+}
+
+TEST_F(CommManagerTest, UplinkIsParsedWithinAByteBudgetPerLoop)
+{
+  uint8_t noise[2000];
+  for (size_t i = 0; i < sizeof(noise); i++)
+    noise[i] = static_cast<uint8_t>(i * 7);
+  board.serial_receive(noise, sizeof(noise));
+
+  rf.comm_manager_.receive();
+  EXPECT_GT(board.serial_rx_bytes(), 0u);
+  EXPECT_LT(board.serial_rx_bytes(), sizeof(noise));
+
+  for (int i = 0; i < 10 && board.serial_rx_bytes() > 0; i++)
+    rf.comm_manager_.receive();
+  EXPECT_EQ(board.serial_rx_bytes(), 0u);
+}
+
+TEST_F(CommManagerTest, CompanionClockIsLearnedFromTimesyncRequests)
+{
+  CommLinkInterface::ListenerInterface& listener = rf.comm_manager_;
+  for (int i = 0; i < 10; i++)
+  {
+    step_firmware(rf, board, 100000);
+    listener.timesync_callback(0, static_cast<int64_t>(board.clock_micros() + 5000000) * 1000);
+  }
+
+  ASSERT_TRUE(rf.comm_manager_.timesync().valid());
+  EXPECT_NEAR(static_cast<double>(rf.comm_manager_.timesync().offset_us(board.clock_micros())), 5000000.0, 10.0);
+}
+
+TEST_F(CommManagerTest, StaleStampedOffboardCommandsAreRejected)
+{
+  // the companion clock runs 5 s ahead of the board
+  CommLinkInterface::ListenerInterface& listener = rf.comm_manager_;
+  for (int i = 0; i < 10; i++)
+  {
+    step_firmware(rf, board, 100000);
+    listener.timesync_callback(0, static_cast<int64_t>(board.clock_micros() + 5000000) * 1000);
+  }
+  ASSERT_TRUE(rf.comm_manager_.timesync().valid());
+
+  CommLinkInterface::OffboardControl control;
+  control.mode = CommLinkInterface::OffboardControl::Mode::ROLLRATE_PITCHRATE_YAWRATE_THROTTLE;
+  control.x = {0.1f, true};
+  control.y = {0.0f, true};
+  control.z = {0.0f, true};
+  control.F = {0.5f, true};
+  control.stamp_us = board.clock_micros() + 5000000 - 10000; // 10 ms old
+  listener.offboard_control_callback(control);
+  EXPECT_TRUE(rf.command_manager_.offboard_control_active());
+
+  control.stamp_us = board.clock_micros() + 5000000 - 200000; // 200 ms old
+  listener.offboard_control_callback(control);
+
+  CommManager::CommandAgeStats ages = rf.comm_manager_.command_age_stats();
+  EXPECT_EQ(ages.count, 1u);
+  EXPECT_EQ(ages.stale, 1u);
+  EXPECT_NEAR(ages.mean_ms, 10.0f, 0.1f);
+  EXPECT_NEAR(ages.max_ms, 10.0f, 0.1f);
+  EXPECT_NEAR(ages.p95_ms, 10.0f, 0.1f);
+}
@@ -0,0 +1,192 @@
+#include "common.h"
+#include "mavlink.h"
+#include "test_board.h"
+
+#include "rosflight.h"
+
+#include <cmath>
+
+using namespace rosflight_firmware;
+
+namespace rosflight_firmware
+{
+class ControllerTest : public ::testing::Test
+{
+public:
+  testBoard board;
+  Mavlink mavlink;
+  ROSflight rf;
+
+  uint16_t rc_values[8];
+
+  ControllerTest() : mavlink(board), rf(board, mavlink) {}
+
+  void SetUp() override
+  {
+    rf.init();
+    rf.state_manager_.clear_error(rf.state_manager_.state().error_codes); // Clear All Errors to Start
+    rf.params_.set_param_int(PARAM_CALIBRATE_GYRO_ON_ARM, false);
+
+    for (int i = 0; i < 8; i++)
+    {
+      rc_values[i] = 1500;
+    }
+    rc_values[2] = 1000;
+  }
+
+  Controller::Output runWithRC(uint16_t roll_pwm, uint16_t pitch_pwm)
+  {
+    rc_values[0] = roll_pwm;
+    rc_values[1] = pitch_pwm;
+    board.set_rc(rc_values);
+    step_firmware(rf, board, 100000);
+    return rf.controller_.output();
+  }
+
+  turbomath::Vector attitudeError(const turbomath::Quaternion &q, float roll_c, float pitch_c) const
+  {
+    return rf.controller_.attitude_error(q, roll_c, pitch_c);
+  }
+
+  void updateINDIFilters(float dt, const turbomath::Vector &rate, const turbomath::Vector &torque)
+  {
+    rf.controller_.update_indi_filters(dt, rate, torque);
+  }
+  const turbomath::Vector &indiOmegaDot() const { return rf.controller_.indi_omega_dot_; }
+  const turbomath::Vector &indiTorque() const { return rf.controller_.indi_torque_; }
+};
+} // namespace rosflight_firmware
+
+TEST_F(ControllerTest, QuaternionErrorMatchesEulerForSmallAngles)
+{
+  rf.params_.set_param_int(PARAM_ATTITUDE_CONTROL_TYPE, Controller::ATT_CONTROL_EULER);
+  Controller::Output euler = runWithRC(1600, 1450);
+  EXPECT_GT(euler.x, 0.0);
+  EXPECT_LT(euler.y, 0.0);
+
+  rf.params_.set_param_int(PARAM_ATTITUDE_CONTROL_TYPE, Controller::ATT_CONTROL_QUATERNION);
+  Controller::Output quat = runWithRC(1600, 1450);
+  EXPECT_CLOSE(quat.x, euler.x);
+  EXPECT_CLOSE(quat.y, euler.y);
+  EXPECT_CLOSE(quat.z, euler.z);
+
+  rf.params_.set_param_int(PARAM_ATTITUDE_CONTROL_TYPE, Controller::ATT_CONTROL_TILT_PRIORITIZED);
+  Controller::Output tilt = runWithRC(1600, 1450);
+  EXPECT_CLOSE(tilt.x, euler.x);
+  EXPECT_CLOSE(tilt.y, euler.y);
+  EXPECT_CLOSE(tilt.z, euler.z);
+}
+
+TEST_F(ControllerTest, LevelCommandProducesNoTorqueInAllModes)
+{
+  for (int type = Controller::ATT_CONTROL_EULER; type <= Controller::ATT_CONTROL_TILT_PRIORITIZED; type++)
+  {
+    rf.params_.set_param_int(PARAM_ATTITUDE_CONTROL_TYPE, type);
+    Controller::Output out = runWithRC(1500, 1500);
+    EXPECT_SUPERCLOSE(out.x, 0.0);
+    EXPECT_SUPERCLOSE(out.y, 0.0);
+  }
+}
+
+TEST_F(ControllerTest, QuaternionErrorIsBodyFrameAtNonZeroHeading)
+{
+  // Rolled 0.2 rad while facing east, commanded to 0.3 rad: the error is a pure +0.1 rad roll in the body frame
+  turbomath::Quaternion q(0.2f, 0.0f, 1.5707963f);
+  for (int type = Controller::ATT_CONTROL_QUATERNION; type <= Controller::ATT_CONTROL_TILT_PRIORITIZED; type++)
+  {
+    rf.params_.set_param_int(PARAM_ATTITUDE_CONTROL_TYPE, type);
+    turbomath::Vector error = attitudeError(q, 0.3f, 0.0f);
+    EXPECT_CLOSE(error.x, 0.1);
+    EXPECT_SUPERCLOSE(error.y, 0.0);
+    EXPECT_SUPERCLOSE(error.z, 0.0);
+  }
+
+  // Same for pitch while facing southwest
+  q = turbomath::Quaternion(0.0f, -0.1f, -2.3561945f);
+  for (int type = Controller::ATT_CONTROL_QUATERNION; type <= Controller::ATT_CONTROL_TILT_PRIORITIZED; type++)
+  {
+    rf.params_.set_param_int(PARAM_ATTITUDE_CONTROL_TYPE, type);
+    turbomath::Vector error = attitudeError(q, 0.0f, 0.15f);
+    EXPECT_SUPERCLOSE(error.x, 0.0);
+    EXPECT_CLOSE(error.y, 0.25);
+    EXPECT_SUPERCLOSE(error.z, 0.0);
+  }
+}
+
+TEST_F(ControllerTest, QuaternionErrorDoesNotDependOnHeading)
+{
+  // The command holds the current heading, so the body-frame error for a given tilt is the same at every yaw
+  const float headings[] = {0.5f, 1.5707963f, 3.0f, -2.0f};
+  for (int type = Controller::ATT_CONTROL_QUATERNION; type <= Controller::ATT_CONTROL_TILT_PRIORITIZED; type++)
+  {
+    rf.params_.set_param_int(PARAM_ATTITUDE_CONTROL_TYPE, type);
+    turbomath::Vector level = attitudeError(turbomath::Quaternion(0.2f, -0.1f, 0.0f), 0.3f, 0.05f);
+    EXPECT_GT(level.x, 0.0);
+    EXPECT_GT(level.y, 0.0);
+    for (float yaw : headings)
+    {
+      turbomath::Vector error = attitudeError(turbomath::Quaternion(0.2f, -0.1f, yaw), 0.3f, 0.05f);
+      EXPECT_SUPERCLOSE(error.x, level.x);
+      EXPECT_SUPERCLOSE(error.y, level.y);
+      EXPECT_SUPERCLOSE(error.z, level.z);
+    }
+  }
+}
+
+TEST_F(ControllerTest, INDIMatchesProportionalRateLoopAtRest)
+{
+  // With the vehicle at rest and the outputs idle, the increment reduces to the proportional rate term
+  rf.params_.set_param_int(PARAM_RC_ATTITUDE_MODE, 0);
+  rf.params_.set_param_int(PARAM_RATE_CONTROL_TYPE, Controller::RATE_CONTROL_PID);
+  Controller::Output pid = runWithRC(1600, 1400);
+  EXPECT_GT(pid.x, 0.0);
+  EXPECT_LT(pid.y, 0.0);
+
+  rf.params_.set_param_int(PARAM_RATE_CONTROL_TYPE, Controller::RATE_CONTROL_INDI);
+  Controller::Output indi = runWithRC(1600, 1400);
+  EXPECT_CLOSE(indi.x, pid.x);
+  EXPECT_CLOSE(indi.y, pid.y);
+  EXPECT_CLOSE(indi.z, pid.z);
+}
+
+TEST_F(ControllerTest, INDIFeedbackSignalsHaveTheSameStepResponse)
+{
+  // A step in angular acceleration and the matching step in applied torque must come out of their filters together,
+  // or the increment carries the difference as a lag error
+  const float dt = 0.001f;
+  const float accel = 50.0f;
+  turbomath::Vector rate(0.0f, 0.0f, 0.0f);
+  for (int i = 0; i < 100; i++)
+  {
+    turbomath::Vector torque(0.0f, 0.0f, 0.0f);
+    if (i >= 10)
+    {
+      rate.x += accel * dt;
+      rate.y -= accel * dt;
+      torque = turbomath::Vector(accel, -accel, 0.0f);
+    }
+    updateINDIFilters(dt, rate, torque);
+    EXPECT_NEAR(indiOmegaDot().x, indiTorque().x, 0.01) << "step " << i;
+    EXPECT_NEAR(indiOmegaDot().y, indiTorque().y, 0.01) << "step " << i;
+    EXPECT_NEAR(indiOmegaDot().z, indiTorque().z, 0.01) << "step " << i;
+  }
+  EXPECT_CLOSE(indiTorque().x, accel);
+  EXPECT_CLOSE(indiOmegaDot().y, -accel);
+}
+
+TEST_F(ControllerTest, CachedGainsFollowParameterChanges)
+{
+  Controller::Output out = runWithRC(1500, 1500);
+  EXPECT_SUPERCLOSE(out.x, 0.0);
+
+  rf.params_.set_param_float(PARAM_X_EQ_TORQUE, 0.1f);
+  out = runWithRC(1500, 1500);
+  EXPECT_SUPERCLOSE(out.x, 0.1);
+
+  // With no control effectiveness INDI has nothing to invert, so only the equilibrium torque is left
+  rf.params_.set_param_int(PARAM_RC_ATTITUDE_MODE, 0);
+  rf.params_.set_param_int(PARAM_RATE_CONTROL_TYPE, Controller::RATE_CONTROL_INDI);
+  rf.params_.set_param_float(PARAM_INDI_G_ROLL, 0.0f);
+  out = runWithRC(1600, 1500);
+  EXPECT_SUPERCLOSE(out.x, 0.1);
+}
@@ -0,0 +1,124 @@
+#include "common.h"
+#include "dshot.h"
+#include "mavlink.h"
+#include "test_board.h"
+
+#include "rosflight.h"
+
+using namespace rosflight_firmware;
+
+namespace
+{
+// Build the 21-bit line capture an ESC would send for a 12-bit eRPM payload
+uint32_t encode_erpm_reply(uint16_t payload)
+{
+  static const uint8_t gcr_encode_table[16] = {0x19, 0x1B, 0x12, 0x13, 0x1D, 0x15, 0x16, 0x17,
+                                               0x1A, 0x09, 0x0A, 0x0B, 0x1E, 0x0D, 0x0E, 0x0F};
+  uint16_t crc = ~(payload ^ (payload >> 4) ^ (payload >> 8)) & 0x0F;
+  uint16_t value = static_cast<uint16_t>((payload << 4) | crc);
+
+  uint32_t gcr = 0;
+  for (int shift = 12; shift >= 0; shift -= 4)
+  {
+    gcr = (gcr << 5) | gcr_encode_table[(value >> shift) & 0x0F];
+  }
+
+  // Undo the edge encoding: each bit on the wire is the running XOR of the GCR bits
+  uint32_t raw = 0;
+  uint32_t level = 0;
+  for (int bit = 20; bit >= 0; bit--)
+  {
+    level ^= (gcr >> bit) & 1;
+    raw |= level << bit;
+  }
+  return raw;
+}
+} // namespace
+
+TEST(DShot, EncodeFrame)
+{
+  // Worked example from the DShot protocol description
+  EXPECT_EQ(dshot_encode_frame(1046, false, false), 0x82C6);
+  EXPECT_EQ(dshot_encode_frame(1046, true, false), 0x82D7);
+
+  // Bidirectional frames carry the inverted CRC
+  EXPECT_EQ(dshot_encode_frame(1046, false, true) & 0x0F, ~0x6 & 0x0F);
+  EXPECT_EQ(dshot_encode_frame(1046, false, true) >> 4, 0x82C);
+}
+
+TEST(DShot, ThrottleToValue)
+{
+  EXPECT_EQ(dshot_throttle_to_value(-0.1f), DSHOT_CMD_MOTOR_STOP);
+  EXPECT_EQ(dshot_throttle_to_value(0.0f), DSHOT_CMD_MOTOR_STOP);
+  EXPECT_EQ(dshot_throttle_to_value(1e-6f), DSHOT_MIN_THROTTLE);
+  EXPECT_EQ(dshot_throttle_to_value(0.5f), 1048);
+  EXPECT_EQ(dshot_throttle_to_value(1.0f), DSHOT_MAX_THROTTLE);
+  EXPECT_EQ(dshot_throttle_to_value(2.0f), DSHOT_MAX_THROTTLE);
+}
+
+TEST(DShot, DecodeERPM)
+{
+  uint32_t period_us = 0;
+
+  // 500 << 1 = 1000 us electrical period
+  ASSERT_TRUE(dshot_decode_erpm(encode_erpm_reply((1 << 9) | 500), &period_us));
+  EXPECT_EQ(period_us, 1000u);
+  EXPECT_FLOAT_EQ(dshot_period_to_rpm(period_us, 14), 60.0e6f / 1000.0f / 7.0f);
+
+  // All ones means the motor is stopped
+  ASSERT_TRUE(dshot_decode_erpm(encode_erpm_reply(0x0FFF), &period_us));
+  EXPECT_EQ(period_us, 0u);
+  EXPECT_EQ(dshot_period_to_rpm(period_us, 14), 0.0f);
+}
+
+TEST(DShot, RejectCorruptReply)
+{
+  uint32_t period_us = 0;
+  uint32_t reply = encode_erpm_reply((3 << 9) | 123);
+  ASSERT_TRUE(dshot_decode_erpm(reply, &period_us));
+  EXPECT_EQ(period_us, 123u << 3);
+
+  // Flipping any single bit either breaks a GCR symbol or the CRC
+  for (int bit = 0; bit < 20; bit++)
+  {
+    EXPECT_FALSE(dshot_decode_erpm(reply ^ (1u << bit), &period_us)) << "bit " << bit;
+  }
+}
+
+class DShotMixerTest : public ::testing::Test
+{
+public:
+  testBoard board;
+  Mavlink mavlink;
+  ROSflight rf;
+
+  DShotMixerTest() : mavlink(board), rf(board, mavlink) {}
+
+  void SetUp() override
+  {
+    rf.init();
+    rf.state_manager_.clear_error(rf.state_manager_.state().error_codes); // Clear All Errors to Start
+    rf.params_.set_param_int(PARAM_MIXER, Mixer::QUADCOPTER_X);
+    rf.params_.set_param_int(PARAM_MOTOR_PROTOCOL, 3);
+  }
+};
+
+TEST_F(DShotMixerTest, DisarmedMotorsAreStopped)
+{
+  step_firmware(rf, board, 20000);
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    EXPECT_EQ(board.dshot_frame(i), dshot_encode_frame(DSHOT_CMD_MOTOR_STOP, false, false));
+  }
+}
+
+TEST_F(DShotMixerTest, TelemetryIsDecodedToRPM)
+{
+  rf.params_.set_param_int(PARAM_DSHOT_BIDIRECTIONAL, true);
+  board.set_dshot_telemetry(2, encode_erpm_reply((1 << 9) | 500));
+  step_firmware(rf, board, 20000);
+
+  EXPECT_EQ(board.dshot_frame(2), dshot_encode_frame(DSHOT_CMD_MOTOR_STOP, false, true));
+  EXPECT_FLOAT_EQ(rf.mixer_.get_motor_rpm()[2], 60.0e6f / 1000.0f / 7.0f);
+  EXPECT_EQ(rf.mixer_.get_motor_rpm()[0], 0.0f);
+}
@@ -206,10 +206,13 @@ public:
   {
     Vector3d rpy = getTrueRPY();
 
+    float roll, pitch, yaw;
+    rf.estimator_.state().attitude.get_RPY(&roll, &pitch, &yaw);
+
     Vector3d err;
-    err(0) = rpy(0) - rf.estimator_.state().roll;
-    err(1) = rpy(1) - rf.estimator_.state().pitch;
-    err(2) = rpy(2) - rf.estimator_.state().yaw;
+    err(0) = rpy(0) - roll;
+    err(1) = rpy(1) - pitch;
+    err(2) = rpy(2) - yaw;
 
     return err;
   }
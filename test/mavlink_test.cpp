@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2017, James Jackson and Daniel Koch, BYU MAGICC Lab
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "common.h"
+#include "mavlink.h"
+#include "test_board.h"
+
+#include "rosflight.h"
+
+#include <cstring>
+
+using namespace rosflight_firmware;
+
+// Checksum and framing are rebuilt here from the MAVLink 2 spec rather than borrowed from the link, so the link is
+// checked against an independent implementation
+static uint16_t x25_crc(const uint8_t *buf, size_t len, uint16_t crc = 0xFFFF)
+{
+  for (size_t i = 0; i < len; i++)
+  {
+    uint8_t tmp = static_cast<uint8_t>(buf[i] ^ (crc & 0xFF));
+    tmp = static_cast<uint8_t>(tmp ^ (tmp << 4));
+    crc = static_cast<uint16_t>((crc >> 8) ^ (tmp << 8) ^ (tmp << 3) ^ (tmp >> 4));
+  }
+  return crc;
+}
+
+static uint16_t frame_crc(const uint8_t *frame, size_t len, uint8_t crc_extra)
+{
+  // everything after the start byte, then the message's CRC extra byte
+  uint16_t crc = x25_crc(frame + 1, len - 1);
+  return x25_crc(&crc_extra, 1, crc);
+}
+
+static const uint8_t SIGNATURE_LEN = 13;
+static const uint8_t IFLAG_SIGNED = 0x01;
+
+// Builds a MAVLink 2 TIMESYNC frame, dropping trailing zero payload bytes the way a MAVLink 2 sender does
+static size_t timesync_frame_v2(uint8_t *frame, int64_t tc1, int64_t ts1, uint8_t incompat_flags = 0)
+{
+  uint8_t payload[16];
+  memcpy(payload, &tc1, sizeof(tc1));
+  memcpy(payload + 8, &ts1, sizeof(ts1));
+  uint8_t len = sizeof(payload);
+  while (len > 1 && payload[len - 1] == 0)
+    len--;
+
+  const uint8_t header[10] = {0xFD, len, incompat_flags, 0, 7, 1, 1, MAVLINK_MSG_ID_TIMESYNC, 0, 0};
+  memcpy(frame, header, sizeof(header));
+  memcpy(frame + sizeof(header), payload, len);
+  size_t n = sizeof(header) + len;
+  uint16_t crc = frame_crc(frame, n, MAVLINK_MSG_ID_TIMESYNC_CRC);
+  frame[n++] = static_cast<uint8_t>(crc & 0xFF);
+  frame[n++] = static_cast<uint8_t>(crc >> 8);
+
+  if (incompat_flags & IFLAG_SIGNED)
+  {
+    // start bytes of both versions in the signature, which the parsers must not mistake for a new frame
+    for (uint8_t i = 0; i < SIGNATURE_LEN; i++)
+      frame[n++] = (i % 2) ? 0xFE : 0xFD;
+  }
+  return n;
+}
+
+static size_t timesync_frame_v1(uint8_t *frame, int64_t tc1, int64_t ts1)
+{
+  const uint8_t header[6] = {0xFE, 16, 7, 1, 1, MAVLINK_MSG_ID_TIMESYNC};
+  memcpy(frame, header, sizeof(header));
+  memcpy(frame + 6, &tc1, sizeof(tc1));
+  memcpy(frame + 14, &ts1, sizeof(ts1));
+  uint16_t crc = frame_crc(frame, 22, MAVLINK_MSG_ID_TIMESYNC_CRC);
+  frame[22] = static_cast<uint8_t>(crc & 0xFF);
+  frame[23] = static_cast<uint8_t>(crc >> 8);
+  return 24;
+}
+
+class MavlinkTest : public ::testing::Test
+{
+public:
+  testBoard board;
+  Mavlink mavlink;
+  ROSflight rf;
+
+  MavlinkTest() : mavlink(board), rf(board, mavlink) {}
+
+  void SetUp() override
+  {
+    board.backup_memory_clear();
+    rf.init();
+    rf.state_manager_.clear_error(rf.state_manager_.state().error_codes);
+  }
+
+  void receive(const uint8_t *frame, size_t len)
+  {
+    board.serial_receive(frame, len);
+    mavlink.receive();
+  }
+
+  // Decodes the last frame the board sent as a MAVLink 2 TIMESYNC, restoring truncated zeros
+  bool last_timesync_v2(int64_t *tc1, int64_t *ts1)
+  {
+    const uint8_t *frame = board.serial_tx_frame();
+    size_t len = board.serial_tx_frame_len();
+    if (len < 12 || frame[0] != 0xFD || frame[7] != MAVLINK_MSG_ID_TIMESYNC || len != 12u + frame[1])
+      return false;
+    uint16_t crc = frame_crc(frame, len - 2, MAVLINK_MSG_ID_TIMESYNC_CRC);
+    if (frame[len - 2] != (crc & 0xFF) || frame[len - 1] != (crc >> 8))
+      return false;
+
+    uint8_t payload[16] = {0};
+    memcpy(payload, frame + 10, frame[1]);
+    memcpy(tc1, payload, sizeof(*tc1));
+    memcpy(ts1, payload + 8, sizeof(*ts1));
+    return true;
+  }
+};
+
+TEST_F(MavlinkTest, ReframedMessageMatchesKnownMavlink2Frame)
+{
+  // any MAVLink 2 frame switches replies over to MAVLink 2
+  uint8_t request[64];
+  receive(request, timesync_frame_v2(request, 0, 1000));
+
+  mavlink.send_timesync(1, 0x0102030405060708, 0x1234);
+
+  // The six zero bytes at the top of ts1 are truncated, and the checksum covers the shortened payload. This is the
+  // frame with sequence number 0; the link's sequence number depends on what it sent before, so it is patched in.
+  uint8_t expected[] = {0xFD, 0x0A, 0x00, 0x00, 0x00, 0x01, 0xFA, 0x6F, 0x00, 0x00, 0x08,
+                        0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, 0x34, 0x12, 0x1B, 0x7F};
+  ASSERT_EQ(board.serial_tx_frame_len(), sizeof(expected));
+  EXPECT_EQ(frame_crc(expected, sizeof(expected) - 2, MAVLINK_MSG_ID_TIMESYNC_CRC), 0x7F1B);
+  expected[4] = board.serial_tx_frame()[4];
+  uint16_t crc = frame_crc(expected, sizeof(expected) - 2, MAVLINK_MSG_ID_TIMESYNC_CRC);
+  expected[20] = static_cast<uint8_t>(crc & 0xFF);
+  expected[21] = static_cast<uint8_t>(crc >> 8);
+
+  for (size_t i = 0; i < sizeof(expected); i++)
+    EXPECT_EQ(board.serial_tx_frame()[i], expected[i]) << "byte " << i;
+}
+
+TEST_F(MavlinkTest, TruncatedFrameRoundTrip)
+{
+  // Only ten payload bytes go over the wire. The parser has to put the zeros back for ts1 to survive the trip.
+  board.set_time(5000000);
+  uint8_t request[64];
+  size_t len = timesync_frame_v2(request, 0, 0x4321);
+  ASSERT_EQ(len, 22u);
+
+  uint32_t frames = board.serial_tx_frames();
+  receive(request, len);
+  ASSERT_EQ(board.serial_tx_frames(), frames + 1);
+
+  int64_t tc1 = 0;
+  int64_t ts1 = 0;
+  ASSERT_TRUE(last_timesync_v2(&tc1, &ts1));
+  EXPECT_EQ(ts1, 0x4321);
+  EXPECT_EQ(tc1, 5000000000);
+  EXPECT_LT(board.serial_tx_frame_len(), 12u + MAVLINK_MSG_ID_TIMESYNC_LEN);
+}
+
+TEST_F(MavlinkTest, SignedFramesAreHandledAndTheirSignatureSkipped)
+{
+  uint8_t stream[128];
+  size_t len = timesync_frame_v2(stream, 0, 1111, IFLAG_SIGNED);
+  ASSERT_EQ(len, 22u + SIGNATURE_LEN);
+  len += timesync_frame_v2(stream + len, 0, 2222);
+
+  uint32_t frames = board.serial_tx_frames();
+  receive(stream, len);
+  EXPECT_EQ(board.serial_tx_frames(), frames + 2);
+
+  int64_t tc1 = 0;
+  int64_t ts1 = 0;
+  ASSERT_TRUE(last_timesync_v2(&tc1, &ts1));
+  EXPECT_EQ(ts1, 2222);
+}
+
+TEST_F(MavlinkTest, FramesWithUnknownIncompatibilityFlagsAreDropped)
+{
+  uint8_t stream[128];
+  size_t len = timesync_frame_v2(stream, 0, 1111, 0x02);
+  len += timesync_frame_v2(stream + len, 0, 2222);
+
+  uint32_t frames = board.serial_tx_frames();
+  receive(stream, len);
+  EXPECT_EQ(board.serial_tx_frames(), frames + 1);
+
+  int64_t tc1 = 0;
+  int64_t ts1 = 0;
+  ASSERT_TRUE(last_timesync_v2(&tc1, &ts1));
+  EXPECT_EQ(ts1, 2222);
+}
+
+TEST_F(MavlinkTest, CompletedFrameResetsTheOtherParser)
+{
+  // ts1 puts a MAVLink 2 start byte and a 255-byte length inside a MAVLink 1 frame. Unless the MAVLink 2 parser is
+  // reset when the MAVLink 1 frame completes, it swallows the frame that follows.
+  uint8_t stream[128];
+  size_t len = timesync_frame_v1(stream, 0, 0xFFFD);
+  len += timesync_frame_v2(stream + len, 0, 2222);
+
+  uint32_t frames = board.serial_tx_frames();
+  receive(stream, len);
+  EXPECT_EQ(board.serial_tx_frames(), frames + 2);
+
+  // And the other way around, with a MAVLink 1 start byte inside a MAVLink 2 frame
+  len = timesync_frame_v2(stream, 0, 0xFFFE);
+  len += timesync_frame_v1(stream + len, 0, 3333);
+
+  frames = board.serial_tx_frames();
+  receive(stream, len);
+  EXPECT_EQ(board.serial_tx_frames(), frames + 2);
+}
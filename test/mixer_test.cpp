@@ -0,0 +1,302 @@
+#include "common.h"
+#include "mavlink.h"
+#include "test_board.h"
+
+#include "rosflight.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+using namespace rosflight_firmware;
+
+class MixerTest : public ::testing::Test
+{
+public:
+  testBoard board;
+  Mavlink mavlink;
+  ROSflight rf;
+
+  MixerTest() : mavlink(board), rf(board, mavlink) {}
+
+  void SetUp() override
+  {
+    rf.init();
+    rf.state_manager_.clear_error(rf.state_manager_.state().error_codes); // Clear All Errors to Start
+  }
+
+  void arm()
+  {
+    uint16_t rc_values[8] = {1500, 1500, 1000, 1500, 1500, 1500, 1500, 1500};
+    board.set_rc(rc_values);
+    step_firmware(rf, board, 50000);
+    rf.params_.set_param_int(PARAM_CALIBRATE_GYRO_ON_ARM, false);
+    rf.state_manager_.set_event(StateManager::EVENT_REQUEST_ARM);
+  }
+
+  void loadQuadXAsCustom(float scale)
+  {
+    const float x[4] = {-1.0f, -1.0f, 1.0f, 1.0f};
+    const float y[4] = {1.0f, -1.0f, -1.0f, 1.0f};
+    const float z[4] = {1.0f, -1.0f, 1.0f, -1.0f};
+    for (int i = 0; i < 4; i++)
+    {
+      rf.params_.set_param_float(PARAM_CUSTOM_MIXER_F_0 + i, scale);
+      rf.params_.set_param_float(PARAM_CUSTOM_MIXER_X_0 + i, scale * x[i]);
+      rf.params_.set_param_float(PARAM_CUSTOM_MIXER_Y_0 + i, scale * y[i]);
+      rf.params_.set_param_float(PARAM_CUSTOM_MIXER_Z_0 + i, scale * z[i]);
+    }
+    rf.params_.set_param_int(PARAM_CUSTOM_MIXER_TYPES, 0xAA); // outputs 0-3 are motors
+    rf.params_.set_param_int(PARAM_MIXER, Mixer::CUSTOM);
+  }
+};
+
+TEST_F(MixerTest, CustomMixerWithoutOutputsIsInvalid)
+{
+  rf.params_.set_param_int(PARAM_MIXER, Mixer::CUSTOM);
+  EXPECT_TRUE(rf.state_manager_.state().error_codes & StateManager::ERROR_INVALID_MIXER);
+}
+
+TEST_F(MixerTest, CustomMixerRejectsNegativeMotorThrust)
+{
+  loadQuadXAsCustom(1.0f);
+  EXPECT_FALSE(rf.state_manager_.state().error_codes & StateManager::ERROR_INVALID_MIXER);
+
+  rf.params_.set_param_float(PARAM_CUSTOM_MIXER_F_2, -1.0f);
+  EXPECT_TRUE(rf.state_manager_.state().error_codes & StateManager::ERROR_INVALID_MIXER);
+}
+
+TEST_F(MixerTest, CustomMixerIsNormalized)
+{
+  // Servos are written while disarmed, so load a scaled quad X layout onto servo outputs and check that the outputs
+  // come back at the built-in scale
+  loadQuadXAsCustom(3.0f);
+  rf.params_.set_param_int(PARAM_CUSTOM_MIXER_TYPES, 0x55);
+  EXPECT_FALSE(rf.state_manager_.state().error_codes & StateManager::ERROR_INVALID_MIXER);
+
+  uint16_t rc_values[8] = {1600, 1500, 1000, 1500, 1500, 1500, 1500, 1500};
+  board.set_rc(rc_values);
+  step_firmware(rf, board, 100000);
+
+  Controller::Output command = rf.controller_.output();
+  const float *outputs = rf.mixer_.get_outputs();
+  EXPECT_GT(command.x, 0.0);
+  EXPECT_CLOSE(outputs[0], -command.x + command.y + command.z);
+  EXPECT_CLOSE(outputs[2], command.x - command.y + command.z);
+
+  turbomath::Vector torque = rf.mixer_.get_output_torque();
+  EXPECT_CLOSE(torque.x, command.x);
+  EXPECT_CLOSE(torque.y, command.y);
+}
+
+TEST_F(MixerTest, OutputTorqueIsExactForTricopter)
+{
+  // The tail motor drives both roll and pitch, so the x and y columns are not orthogonal
+  rf.params_.set_param_int(PARAM_MIXER, Mixer::TRICOPTER);
+  arm();
+  ASSERT_TRUE(rf.state_manager_.state().armed);
+
+  // Enough yaw that the yaw motor stays above idle, where it would be clamped
+  uint16_t rc_values[8] = {1600, 1420, 1500, 1800, 1500, 1500, 1500, 1500};
+  board.set_rc(rc_values);
+  step_firmware(rf, board, 100000);
+
+  Controller::Output command = rf.controller_.output();
+  EXPECT_GT(fabs(command.x), 0.01);
+  EXPECT_GT(fabs(command.y), 0.01);
+  turbomath::Vector torque = rf.mixer_.get_output_torque();
+  EXPECT_CLOSE(torque.x, command.x);
+  EXPECT_CLOSE(torque.y, command.y);
+  EXPECT_CLOSE(torque.z, command.z);
+}
+
+TEST_F(MixerTest, OutputTorqueIsExactForSkewedCustomMixer)
+{
+  // An asymmetric layout whose roll column overlaps both the thrust and pitch columns, on servos so it runs disarmed
+  const float x[4] = {-1.0f, -1.0f, 1.0f, 0.5f};
+  const float y[4] = {1.0f, -1.0f, -1.0f, 1.0f};
+  const float z[4] = {1.0f, -1.0f, 1.0f, -1.0f};
+  for (int i = 0; i < 4; i++)
+  {
+    rf.params_.set_param_float(PARAM_CUSTOM_MIXER_F_0 + i, 1.0f);
+    rf.params_.set_param_float(PARAM_CUSTOM_MIXER_X_0 + i, x[i]);
+    rf.params_.set_param_float(PARAM_CUSTOM_MIXER_Y_0 + i, y[i]);
+    rf.params_.set_param_float(PARAM_CUSTOM_MIXER_Z_0 + i, z[i]);
+  }
+  rf.params_.set_param_int(PARAM_CUSTOM_MIXER_TYPES, 0x55);
+  rf.params_.set_param_int(PARAM_MIXER, Mixer::CUSTOM);
+  EXPECT_FALSE(rf.state_manager_.state().error_codes & StateManager::ERROR_INVALID_MIXER);
+
+  uint16_t rc_values[8] = {1600, 1420, 1300, 1500, 1500, 1500, 1500, 1500};
+  board.set_rc(rc_values);
+  step_firmware(rf, board, 100000);
+
+  Controller::Output command = rf.controller_.output();
+  EXPECT_GT(fabs(command.x), 0.01);
+  EXPECT_GT(fabs(command.y), 0.01);
+  turbomath::Vector torque = rf.mixer_.get_output_torque();
+  EXPECT_CLOSE(torque.x, command.x);
+  EXPECT_CLOSE(torque.y, command.y);
+  EXPECT_CLOSE(torque.z, command.z);
+}
+
+TEST_F(MixerTest, AirmodeKeepsRollPitchAuthorityAtFullThrottle)
+{
+  rf.params_.set_param_int(PARAM_MIXER, Mixer::QUADCOPTER_X);
+  arm();
+  ASSERT_TRUE(rf.state_manager_.state().armed);
+
+  uint16_t rc_values[8] = {2000, 1500, 2000, 1500, 1500, 1500, 1500, 1500};
+  board.set_rc(rc_values);
+
+  rf.params_.set_param_int(PARAM_MIXER_AIRMODE, false);
+  step_firmware(rf, board, 100000);
+  Controller::Output command = rf.controller_.output();
+  const float *outputs = rf.mixer_.get_outputs();
+  float scaled_differential = outputs[2] - outputs[0];
+  EXPECT_LT(scaled_differential, 2.0f * (command.x - command.y) - 0.01f);
+
+  rf.params_.set_param_int(PARAM_MIXER_AIRMODE, true);
+  step_firmware(rf, board, 20000);
+  command = rf.controller_.output();
+  EXPECT_CLOSE(outputs[2] - outputs[0], 2.0f * (command.x - command.y));
+  for (int i = 0; i < 4; i++)
+  {
+    EXPECT_LE(outputs[i], 1.0f);
+    EXPECT_GE(outputs[i], 0.0f);
+  }
+}
+
+TEST_F(MixerTest, AirmodeRaisesCollectiveAtLowThrottle)
+{
+  rf.params_.set_param_int(PARAM_MIXER, Mixer::QUADCOPTER_X);
+  rf.params_.set_param_int(PARAM_MIXER_AIRMODE, true);
+  rf.params_.set_param_int(PARAM_SPIN_MOTORS_WHEN_ARMED, false);
+  arm();
+  ASSERT_TRUE(rf.state_manager_.state().armed);
+
+  // Full roll with throttle at zero: the low side would normally clip, so the collective is raised instead
+  uint16_t rc_values[8] = {2000, 1500, 1000, 1500, 1500, 1500, 1500, 1500};
+  board.set_rc(rc_values);
+  step_firmware(rf, board, 100000);
+
+  Controller::Output command = rf.controller_.output();
+  const float *outputs = rf.mixer_.get_outputs();
+  EXPECT_GT(command.x, 0.0f);
+  EXPECT_CLOSE(outputs[2] - outputs[0], 2.0f * (command.x - command.y));
+  EXPECT_CLOSE(outputs[0] < outputs[1] ? outputs[0] : outputs[1], 0.0f);
+}
+
+TEST_F(MixerTest, MixerBenchmark)
+{
+  // Not a pass/fail test, just reports the per-call cost of each mixer with and without prioritized allocation
+  const int iterations = 20000;
+  for (uint8_t mixer = 0; mixer < Mixer::CUSTOM; mixer++)
+  {
+    rf.params_.set_param_int(PARAM_MIXER, mixer);
+    for (int airmode = 0; airmode <= 1; airmode++)
+    {
+      rf.params_.set_param_int(PARAM_MIXER_AIRMODE, airmode);
+      auto start = std::chrono::high_resolution_clock::now();
+      for (int i = 0; i < iterations; i++)
+      {
+        rf.mixer_.mix_output();
+      }
+      auto stop = std::chrono::high_resolution_clock::now();
+      double ns = std::chrono::duration<double, std::nano>(stop - start).count() / iterations;
+      printf("mixer %2d %-11s %7.1f ns/call\n", mixer, airmode ? "prioritized" : "scaled", ns);
+    }
+  }
+}
+
+TEST_F(MixerTest, ThrustCurveLinearizesMotorCommands)
+{
+  rf.params_.set_param_int(PARAM_MIXER, Mixer::QUADCOPTER_X);
+  arm();
+  ASSERT_TRUE(rf.state_manager_.state().armed);
+
+  uint16_t rc_values[8] = {1500, 1500, 1500, 1500, 1500, 1500, 1500, 1500};
+  board.set_rc(rc_values);
+  step_firmware(rf, board, 100000);
+  const float *outputs = rf.mixer_.get_outputs();
+  EXPECT_CLOSE(outputs[0], 0.5f);
+
+  // With a purely quadratic thrust curve, half thrust needs sqrt(0.5) command
+  rf.params_.set_param_float(PARAM_MOTOR_THRUST_MODEL, 1.0f);
+  step_firmware(rf, board, 20000);
+  EXPECT_CLOSE(outputs[0], std::sqrt(0.5f));
+
+  rf.params_.set_param_float(PARAM_MOTOR_THRUST_MODEL, 0.5f);
+  step_firmware(rf, board, 20000);
+  EXPECT_CLOSE(0.5f * outputs[0] * outputs[0] + 0.5f * outputs[0], 0.5f);
+}
+
+TEST_F(MixerTest, VoltageCompensationIsSaturatedWithTheRestOfTheRequest)
+{
+  rf.params_.set_param_int(PARAM_MIXER, Mixer::QUADCOPTER_X);
+  rf.params_.set_param_float(PARAM_BATTERY_VOLTAGE_ALPHA, 0.0f);
+  rf.params_.set_param_float(PARAM_MOTOR_VOLTAGE_NOMINAL, 16.0f);
+  board.set_battery_voltage(12.0f);
+  arm();
+  ASSERT_TRUE(rf.state_manager_.state().armed);
+
+  // Near full throttle the boosted request no longer fits, so the whole request is scaled down together instead of
+  // clipping the motors that ran over
+  uint16_t rc_values[8] = {1600, 1450, 1850, 1500, 1500, 1500, 1500, 1500};
+  board.set_rc(rc_values);
+  step_firmware(rf, board, 100000);
+
+  Controller::Output command = rf.controller_.output();
+  const float gain = 16.0f / 12.0f;
+  const float x[4] = {-1.0f, -1.0f, 1.0f, 1.0f};
+  const float y[4] = {1.0f, -1.0f, -1.0f, 1.0f};
+  const float z[4] = {1.0f, -1.0f, 1.0f, -1.0f};
+  float expected[4];
+  float max_output = 1.0f;
+  for (int i = 0; i < 4; i++)
+  {
+    expected[i] = gain * (command.F + command.x * x[i] + command.y * y[i] + command.z * z[i]);
+    max_output = (expected[i] > max_output) ? expected[i] : max_output;
+  }
+  ASSERT_GT(max_output, 1.0f);
+
+  const float *outputs = rf.mixer_.get_outputs();
+  for (int i = 0; i < 4; i++)
+    EXPECT_CLOSE(outputs[i], expected[i] / max_output);
+}
+
+TEST_F(MixerTest, OutputTorqueIsInCommandUnits)
+{
+  // Linearization and voltage compensation change the motor commands, but not the thrust they are meant to deliver
+  rf.params_.set_param_int(PARAM_MIXER, Mixer::QUADCOPTER_X);
+  rf.params_.set_param_float(PARAM_MOTOR_THRUST_MODEL, 0.7f);
+  rf.params_.set_param_float(PARAM_BATTERY_VOLTAGE_ALPHA, 0.0f);
+  rf.params_.set_param_float(PARAM_MOTOR_VOLTAGE_NOMINAL, 16.0f);
+  board.set_battery_voltage(14.0f);
+  arm();
+  ASSERT_TRUE(rf.state_manager_.state().armed);
+
+  uint16_t rc_values[8] = {1600, 1420, 1500, 1700, 1500, 1500, 1500, 1500};
+  board.set_rc(rc_values);
+  step_firmware(rf, board, 100000);
+
+  Controller::Output command = rf.controller_.output();
+  EXPECT_GT(fabs(command.x), 0.01);
+  EXPECT_GT(fabs(command.y), 0.01);
+  turbomath::Vector torque = rf.mixer_.get_output_torque();
+  EXPECT_CLOSE(torque.x, command.x);
+  EXPECT_CLOSE(torque.y, command.y);
+  EXPECT_CLOSE(torque.z, command.z);
+}
+
+TEST_F(MixerTest, OutputsAreWrittenInOneBatch)
+{
+  rf.params_.set_param_int(PARAM_MIXER, Mixer::FIXEDWING);
+  uint32_t writes = board.pwm_write_count();
+  rf.mixer_.mix_output();
+  EXPECT_EQ(board.pwm_write_count(), writes + 1);
+
+  // Centered servos land at mid-range, the disarmed throttle at zero
+  EXPECT_CLOSE(board.pwm_value(1), 0.5f);
+  EXPECT_CLOSE(board.pwm_value(2), 0.0f);
+}
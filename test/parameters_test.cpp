@@ -2,9 +2,14 @@
 #include "test_board.h"
 
 #include "rosflight.h"
+#include "util.h"
 
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
 using namespace rosflight_firmware;
 
 #define EXPECT_PARAM_EQ_INT(id, value) EXPECT_EQ(value, rf.params_.get_param_int(id))
@@ -76,3 +81,412 @@ TEST(Parameters, DefaultParameters)
   EXPECT_PARAM_EQ_INT(PARAM_FC_YAW, 0);
   EXPECT_PARAM_EQ_FLOAT(PARAM_ARM_THRESHOLD, 0.15f);
 }
+
+TEST(Parameters, ChecksumOnlyCoversItsRange)
+{
+  testBoard board;
+  Mavlink mavlink(board);
+  ROSflight rf(board, mavlink);
+
+  rf.init();
+
+  uint16_t table = rf.params_.checksum(0, PARAMS_COUNT);
+  uint16_t before = rf.params_.checksum(0, PARAM_MAX_COMMAND);
+  uint16_t after = rf.params_.checksum(PARAM_MAX_COMMAND, PARAMS_COUNT);
+  EXPECT_EQ(table, rf.params_.checksum(0, PARAMS_COUNT + 100));
+
+  rf.params_.set_param_float(PARAM_MAX_COMMAND, rf.params_.get_param_float(PARAM_MAX_COMMAND) + 0.5f);
+  EXPECT_EQ(before, rf.params_.checksum(0, PARAM_MAX_COMMAND));
+  EXPECT_NE(after, rf.params_.checksum(PARAM_MAX_COMMAND, PARAMS_COUNT));
+  EXPECT_NE(table, rf.params_.checksum(0, PARAMS_COUNT));
+}
+
+TEST(Parameters, LookupFindsEveryName)
+{
+  testBoard board;
+  Mavlink mavlink(board);
+  ROSflight rf(board, mavlink);
+
+  rf.init();
+
+  for (uint16_t id = 0; id < PARAMS_COUNT; id++)
+    EXPECT_EQ(id, rf.params_.lookup_param_id(rf.params_.get_param_name(id)));
+
+  // names that fill the whole field are not terminated
+  const char offboard_timeout[Params::PARAMS_NAME_LENGTH] = {'O', 'F', 'F', 'B', 'O', 'A', 'R', 'D',
+                                                             '_', 'T', 'I', 'M', 'E', 'O', 'U', 'T'};
+  EXPECT_EQ(PARAM_OFFBOARD_TIMEOUT, rf.params_.lookup_param_id(offboard_timeout));
+
+  EXPECT_EQ(PARAMS_COUNT, rf.params_.lookup_param_id("NOT_A_PARAM"));
+  EXPECT_EQ(PARAMS_COUNT, rf.params_.lookup_param_id(""));
+  EXPECT_EQ(PARAMS_COUNT, rf.params_.lookup_param_id("SYS_I"));
+  EXPECT_EQ(PARAMS_COUNT, rf.params_.lookup_param_id("SYS_IDX"));
+}
+
+// The list expanded independently of param.cpp, to check the tables the firmware generates from it
+struct ParamRow
+{
+  uint16_t id;
+  const char *name;
+  param_type_t type;
+  double default_value;
+  double min;
+  double max;
+};
+
+static const ParamRow PARAM_ROWS[] = {
+#define PARAM_INT(id, name, default_value, min, max) {id, name, PARAM_TYPE_INT32, default_value, min, max},
+#define PARAM_FLOAT(id, name, default_value, min, max) {id, name, PARAM_TYPE_FLOAT, default_value, min, max},
+#include "param_list.h"
+};
+
+TEST(Parameters, GeneratedTablesMatchTheList)
+{
+  testBoard board;
+  Mavlink mavlink(board);
+  ROSflight rf(board, mavlink);
+
+  rf.init();
+
+  ASSERT_EQ(sizeof(PARAM_ROWS) / sizeof(PARAM_ROWS[0]), static_cast<size_t>(PARAMS_COUNT));
+  for (uint16_t id = 0; id < PARAMS_COUNT; id++)
+  {
+    const ParamRow &row = PARAM_ROWS[id];
+    EXPECT_EQ(row.id, id);
+    EXPECT_STREQ(row.name, rf.params_.get_param_name(id));
+    EXPECT_EQ(row.type, rf.params_.get_param_type(id)) << row.name;
+    // compared in the parameter's own type, as it is stored
+    if (row.type == PARAM_TYPE_INT32)
+    {
+      int32_t value = rf.params_.get_param_int(id);
+      EXPECT_EQ(static_cast<int32_t>(row.default_value), value) << row.name;
+      EXPECT_LE(static_cast<int32_t>(row.min), value) << row.name;
+      EXPECT_LE(value, static_cast<int32_t>(row.max)) << row.name;
+    }
+    else
+    {
+      float value = rf.params_.get_param_float(id);
+      EXPECT_EQ(static_cast<float>(row.default_value), value) << row.name;
+      EXPECT_LE(static_cast<float>(row.min), value) << row.name;
+      EXPECT_LE(value, static_cast<float>(row.max)) << row.name;
+    }
+  }
+}
+
+TEST(Parameters, SetDefaultsRestoresTheDefaultsTable)
+{
+  testBoard board;
+  Mavlink mavlink(board);
+  ROSflight rf(board, mavlink);
+
+  rf.init();
+  rf.params_.set_param_int(PARAM_SYSTEM_ID, 7);
+  rf.params_.set_param_int(PARAM_STREAM_GNSS_RATE, 5);
+  rf.params_.set_param_float(PARAM_RC_MAX_PITCHRATE, 1.0f);
+  rf.params_.set_defaults();
+
+  EXPECT_PARAM_EQ_INT(PARAM_SYSTEM_ID, 1);
+  EXPECT_PARAM_EQ_INT(PARAM_STREAM_GNSS_RATE, 1000);
+  EXPECT_PARAM_EQ_FLOAT(PARAM_RC_MAX_PITCHRATE, 3.14159f);
+  EXPECT_PARAM_EQ_FLOAT(PARAM_FAILSAFE_THROTTLE, -1.0f);
+  EXPECT_PARAM_EQ_INT(PARAM_MIXER, Mixer::INVALID_MIXER);
+}
+
+TEST(Parameters, LookupBenchmark)
+{
+  testBoard board;
+  Mavlink mavlink(board);
+  ROSflight rf(board, mavlink);
+
+  rf.init();
+
+  // not a pass/fail criterion, just keeps the cost of name lookups visible in the test output
+  static constexpr int PASSES = 1000;
+  uint32_t found = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < PASSES; pass++)
+  {
+    for (uint16_t id = 0; id < PARAMS_COUNT; id++)
+      found += (rf.params_.lookup_param_id(rf.params_.get_param_name(id)) == id);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  EXPECT_EQ(found, static_cast<uint32_t>(PASSES) * PARAMS_COUNT);
+  double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+  printf("[ BENCH    ] %.1f ns per lookup over %d parameters\n", ns / (PASSES * PARAMS_COUNT), PARAMS_COUNT);
+}
+
+class RecordingListener : public ParamListenerInterface
+{
+public:
+  explicit RecordingListener(uint16_t relevant) : relevant_(relevant) {}
+
+  void param_change_callback(uint16_t param_id) override
+  {
+    single_calls++;
+    last_ids[0] = param_id;
+    last_count = 1;
+  }
+  void param_batch_change_callback(const uint16_t *param_ids, uint16_t count) override
+  {
+    batch_calls++;
+    for (uint16_t i = 0; i < count && i < 4; i++)
+      last_ids[i] = param_ids[i];
+    last_count = count;
+  }
+  bool param_is_relevant(uint16_t param_id) const override { return param_id <= relevant_; }
+
+  int single_calls = 0;
+  int batch_calls = 0;
+  uint16_t last_ids[4] = {};
+  uint16_t last_count = 0;
+
+private:
+  uint16_t relevant_;
+};
+
+TEST(Parameters, TransactionDispatchesEachListenerOnce)
+{
+  testBoard board;
+  Mavlink mavlink(board);
+  ROSflight rf(board, mavlink);
+  rf.init();
+
+  // listener a cares about the first three parameters, listener b only about the first
+  RecordingListener a(2), b(0);
+  ParamListenerInterface *const listeners[] = {&a, &b};
+  rf.params_.set_listeners(listeners, 2);
+
+  rf.params_.begin_transaction();
+  rf.params_.set_param_int(2, rf.params_.get_param_int(2) + 1);
+  rf.params_.begin_transaction(); // nested transactions are committed by the outermost one
+  rf.params_.set_param_int(1, rf.params_.get_param_int(1) + 1);
+  rf.params_.set_param_int(2, rf.params_.get_param_int(2) + 1);
+  rf.params_.set_param_int(5, rf.params_.get_param_int(5) + 1);
+  rf.params_.commit_transaction();
+  EXPECT_EQ(a.batch_calls, 0);
+
+  rf.params_.commit_transaction();
+  EXPECT_EQ(a.single_calls, 0);
+  EXPECT_EQ(a.batch_calls, 1);
+  ASSERT_EQ(a.last_count, 2);
+  EXPECT_EQ(a.last_ids[0], 1);
+  EXPECT_EQ(a.last_ids[1], 2);
+  EXPECT_EQ(b.batch_calls, 0);
+
+  // outside of a transaction only the interested listeners hear about a change
+  rf.params_.set_param_int(0, rf.params_.get_param_int(0) + 1);
+  EXPECT_EQ(a.single_calls, 1);
+  EXPECT_EQ(b.single_calls, 1);
+  rf.params_.set_param_int(1, rf.params_.get_param_int(1) + 1);
+  EXPECT_EQ(a.single_calls, 2);
+  EXPECT_EQ(b.single_calls, 1);
+  rf.params_.set_param_int(5, rf.params_.get_param_int(5) + 1);
+  EXPECT_EQ(a.single_calls, 2);
+  EXPECT_EQ(b.single_calls, 1);
+}
+
+TEST(Parameters, ModulesUpdateWhenTheTransactionCommits)
+{
+  testBoard board;
+  Mavlink mavlink(board);
+  ROSflight rf(board, mavlink);
+  rf.init();
+  rf.state_manager_.clear_error(StateManager::ERROR_INVALID_MIXER);
+
+  rf.params_.begin_transaction();
+  rf.params_.set_param_int(PARAM_MIXER, Mixer::NUM_MIXERS);
+  rf.params_.set_param_float(PARAM_PID_ROLL_RATE_P, 0.2f);
+  EXPECT_FALSE(rf.state_manager_.state().error_codes & StateManager::ERROR_INVALID_MIXER);
+
+  rf.params_.commit_transaction();
+  EXPECT_TRUE(rf.state_manager_.state().error_codes & StateManager::ERROR_INVALID_MIXER);
+}
+
+TEST(Parameters, WrittenParametersAreReadBack)
+{
+  testBoard board;
+  Mavlink mavlink(board);
+  {
+    ROSflight rf(board, mavlink);
+    rf.init();
+    rf.params_.set_param_float(PARAM_GYRO_X_BIAS, 0.25f);
+    rf.params_.set_param_int(PARAM_MIXER, Mixer::FIXEDWING);
+    ASSERT_TRUE(rf.params_.write());
+  }
+
+  ROSflight rf(board, mavlink);
+  rf.init();
+  EXPECT_PARAM_EQ_FLOAT(PARAM_GYRO_X_BIAS, 0.25f);
+  EXPECT_PARAM_EQ_INT(PARAM_MIXER, Mixer::FIXEDWING);
+}
+
+TEST(Parameters, ParametersFromAnotherVersionAreMigrated)
+{
+  testBoard board;
+  Mavlink mavlink(board);
+  ROSflight rf(board, mavlink);
+  board.set_param_journal_enabled(false); // boards without a journal store a single image
+
+  // an image written by firmware that stored SYS_ID and GYRO_X_BIAS in a different order, along with a parameter
+  // that no longer exists: magic, format, count, version, checksum, reserved, magic, then (tag, value) pairs
+  float bias = 0.5f;
+  int32_t sysid = 3;
+  int32_t retired = 7;
+  uint8_t entries[3][8];
+  uint32_t tag = rf.params_.get_param_tag(PARAM_GYRO_X_BIAS);
+  memcpy(entries[0], &tag, 4);
+  memcpy(entries[0] + 4, &bias, 4);
+  tag = 0x12345678;
+  memcpy(entries[1], &tag, 4);
+  memcpy(entries[1] + 4, &retired, 4);
+  tag = rf.params_.get_param_tag(PARAM_SYSTEM_ID);
+  memcpy(entries[2], &tag, 4);
+  memcpy(entries[2] + 4, &sysid, 4);
+
+  uint8_t *memory = board.memory();
+  uint16_t count = 3;
+  uint32_t version = 0xdeadbeef;
+  uint16_t chk = checksum_fletcher16(&entries[0][0], sizeof(entries));
+  memory[0] = 0xBE;
+  memory[1] = 1;
+  memcpy(memory + 2, &count, 2);
+  memcpy(memory + 4, &version, 4);
+  memcpy(memory + 8, &chk, 2);
+  memory[10] = 0;
+  memory[11] = 0xEF;
+  memcpy(memory + 12, entries, sizeof(entries));
+
+  rf.init();
+  EXPECT_PARAM_EQ_FLOAT(PARAM_GYRO_X_BIAS, 0.5f);
+  EXPECT_PARAM_EQ_INT(PARAM_SYSTEM_ID, 3);
+  EXPECT_PARAM_EQ_FLOAT(PARAM_GYRO_Y_BIAS, 0.0f);
+  EXPECT_PARAM_EQ_INT(PARAM_BAUD_RATE, 921600);
+
+  // a corrupted image is rejected without touching the current values
+  memory[12] ^= 0x01;
+  rf.params_.set_param_int(PARAM_SYSTEM_ID, 4);
+  EXPECT_FALSE(rf.params_.read());
+  EXPECT_PARAM_EQ_INT(PARAM_SYSTEM_ID, 4);
+}
+
+TEST(Parameters, ImagesWithMoreEntriesThanParametersAreRejected)
+{
+  testBoard board;
+  Mavlink mavlink(board);
+  ROSflight rf(board, mavlink);
+  board.set_param_journal_enabled(false);
+  rf.init();
+  rf.params_.set_param_int(PARAM_SYSTEM_ID, 3);
+  ASSERT_TRUE(rf.params_.write());
+
+  // firmware with one more parameter appends an entry the scratch image has no room for
+  uint8_t *memory = board.memory();
+  size_t entries_len = (PARAMS_COUNT + 1) * 8;
+  uint16_t count = PARAMS_COUNT + 1;
+  uint16_t chk = checksum_fletcher16(memory + 12, entries_len);
+  memcpy(memory + 2, &count, 2);
+  memcpy(memory + 8, &chk, 2);
+
+  rf.params_.set_param_int(PARAM_SYSTEM_ID, 4);
+  EXPECT_FALSE(rf.params_.read());
+  EXPECT_PARAM_EQ_INT(PARAM_SYSTEM_ID, 4);
+}
+
+TEST(Parameters, TagsAreUnique)
+{
+  testBoard board;
+  Mavlink mavlink(board);
+  ROSflight rf(board, mavlink);
+
+  for (uint16_t i = 0; i < PARAMS_COUNT; i++)
+  {
+    for (uint16_t j = static_cast<uint16_t>(i + 1); j < PARAMS_COUNT; j++)
+      EXPECT_NE(rf.params_.get_param_tag(i), rf.params_.get_param_tag(j)) << rf.params_.get_param_name(i);
+  }
+}
+
+TEST(Parameters, JournalAppendsOnlyChangedParameters)
+{
+  testBoard board;
+  Mavlink mavlink(board);
+  ROSflight rf(board, mavlink);
+  rf.init(); // nothing stored yet, so the defaults are compacted into the first sector
+
+  EXPECT_EQ(board.param_journal_erase_count(0), 1u);
+  EXPECT_EQ(board.param_journal_erase_count(1), 0u);
+
+  // one record of tag, value and check follows the header and the compacted values
+  size_t end = 8 + PARAMS_COUNT * 12;
+  rf.params_.set_param_float(PARAM_GYRO_Z_BIAS, 0.125f);
+  ASSERT_TRUE(rf.params_.write());
+  uint32_t tag;
+  float value;
+  memcpy(&tag, board.param_journal_sector(0) + end, 4);
+  memcpy(&value, board.param_journal_sector(0) + end + 4, 4);
+  EXPECT_EQ(tag, rf.params_.get_param_tag(PARAM_GYRO_Z_BIAS));
+  EXPECT_EQ(value, 0.125f);
+  EXPECT_EQ(board.param_journal_sector(0)[end + 12], 0xFF);
+
+  // writing again without changes appends nothing
+  ASSERT_TRUE(rf.params_.write());
+  EXPECT_EQ(board.param_journal_sector(0)[end + 12], 0xFF);
+  EXPECT_EQ(board.param_journal_erase_count(0), 1u);
+
+  ROSflight rebooted(board, mavlink);
+  rebooted.init();
+  EXPECT_EQ(rebooted.params_.get_param_float(PARAM_GYRO_Z_BIAS), 0.125f);
+}
+
+TEST(Parameters, JournalCompactionAlternatesSectors)
+{
+  testBoard board;
+  Mavlink mavlink(board);
+  ROSflight rf(board, mavlink);
+  rf.init();
+
+  for (int i = 1; i <= 2000; i++)
+  {
+    rf.params_.set_param_int(PARAM_SYSTEM_ID, i % 200 + 1);
+    ASSERT_TRUE(rf.params_.write());
+  }
+
+  // each compaction erases the sector that was not active, so the wear is shared
+  uint32_t erases_0 = board.param_journal_erase_count(0);
+  uint32_t erases_1 = board.param_journal_erase_count(1);
+  EXPECT_GT(erases_1, 5u);
+  EXPECT_LE(erases_0 > erases_1 ? erases_0 - erases_1 : erases_1 - erases_0, 1u);
+
+  ROSflight rebooted(board, mavlink);
+  rebooted.init();
+  EXPECT_EQ(rebooted.params_.get_param_int(PARAM_SYSTEM_ID), 2000 % 200 + 1);
+}
+
+TEST(Parameters, JournalIgnoresARecordCutShort)
+{
+  testBoard board;
+  Mavlink mavlink(board);
+  ROSflight rf(board, mavlink);
+  rf.init();
+  rf.params_.set_param_int(PARAM_SYSTEM_ID, 5);
+  ASSERT_TRUE(rf.params_.write());
+  rf.params_.set_param_int(PARAM_SYSTEM_ID, 6);
+  ASSERT_TRUE(rf.params_.write());
+
+  // a reset while programming the second record left its check unwritten
+  size_t second = 8 + PARAMS_COUNT * 12 + 12;
+  memset(board.param_journal_sector(0) + second + 8, 0xFF, 4);
+
+  ROSflight rebooted(board, mavlink);
+  rebooted.init();
+  EXPECT_EQ(rebooted.params_.get_param_int(PARAM_SYSTEM_ID), 5);
+
+  // the partial record can't be programmed over, so the next write compacts into the other sector
+  rebooted.params_.set_param_int(PARAM_SYSTEM_ID, 7);
+  ASSERT_TRUE(rebooted.params_.write());
+  EXPECT_EQ(board.param_journal_erase_count(1), 1u);
+
+  ROSflight rebooted_again(board, mavlink);
+  rebooted_again.init();
+  EXPECT_EQ(rebooted_again.params_.get_param_int(PARAM_SYSTEM_ID), 7);
+}
@@ -54,6 +54,22 @@ void testBoard::set_pwm_lost(bool lost)
   rc_lost_ = lost;
 }
 
+float testBoard::pwm_value(uint8_t channel) const
+{
+  return (channel < NUM_PWM_CHANNELS) ? pwm_values_[channel] : 0.0f;
+}
+
+uint16_t testBoard::dshot_frame(uint8_t channel) const
+{
+  return (channel < NUM_DSHOT_CHANNELS) ? dshot_frames_[channel] : 0;
+}
+
+void testBoard::set_dshot_telemetry(uint8_t channel, uint32_t gcr_frame)
+{
+  if (channel < NUM_DSHOT_CHANNELS)
+    dshot_telemetry_[channel] = gcr_frame;
+}
+
 void testBoard::set_imu(float *acc, float *gyro, uint64_t time_us)
 {
   time_us_ = time_us;
@@ -65,6 +81,12 @@ void testBoard::set_imu(float *acc, float *gyro, uint64_t time_us)
   new_imu_ = true;
 }
 
+testBoard::testBoard()
+{
+  memset(param_journal_, 0xFF, sizeof(param_journal_));
+  memset(log_storage_, 0xFF, sizeof(log_storage_));
+}
+
 // setup
 void testBoard::init_board()
 {
@@ -85,14 +107,53 @@ void testBoard::clock_delay(uint32_t milliseconds) {}
 
 // serial
 void testBoard::serial_init(uint32_t baud_rate, uint32_t dev) {}
-void testBoard::serial_write(const uint8_t *src, size_t len) {}
+void testBoard::serial_write(const uint8_t *src, size_t len)
+{
+  serial_tx_bytes_ += len;
+  if (len > 0 && len <= SERIAL_TX_BUFFER_SIZE)
+  {
+    memcpy(serial_tx_buffer_, src, len);
+    serial_tx_frame_len_ = len;
+    serial_tx_frames_++;
+  }
+}
+uint8_t *testBoard::serial_reserve(size_t len)
+{
+  return (len <= SERIAL_TX_BUFFER_SIZE) ? serial_tx_buffer_ : nullptr;
+}
+void testBoard::serial_commit(size_t len)
+{
+  serial_tx_bytes_ += len;
+  if (len > 0)
+  {
+    serial_tx_frame_len_ = len;
+    serial_tx_frames_++;
+  }
+}
 uint16_t testBoard::serial_bytes_available()
 {
-  return 0;
+  return static_cast<uint16_t>(serial_rx_bytes());
 }
 uint8_t testBoard::serial_read()
 {
-  return 0;
+  return (serial_rx_head_ < serial_rx_tail_) ? serial_rx_buffer_[serial_rx_head_++] : 0;
+}
+size_t testBoard::serial_read(uint8_t *dest, size_t len)
+{
+  if (len > serial_rx_bytes())
+    len = serial_rx_bytes();
+  memcpy(dest, serial_rx_buffer_ + serial_rx_head_, len);
+  serial_rx_head_ += len;
+  return len;
+}
+void testBoard::serial_receive(const uint8_t *src, size_t len)
+{
+  if (serial_rx_head_ == serial_rx_tail_)
+    serial_rx_head_ = serial_rx_tail_ = 0;
+  if (len > SERIAL_RX_BUFFER_SIZE - serial_rx_tail_)
+    len = SERIAL_RX_BUFFER_SIZE - serial_rx_tail_;
+  memcpy(serial_rx_buffer_ + serial_rx_tail_, src, len);
+  serial_rx_tail_ += len;
 }
 void testBoard::serial_flush() {}
 
@@ -187,11 +248,11 @@ float testBoard::sonar_read()
 
 bool testBoard::battery_voltage_present() const
 {
-  return false;
+  return battery_voltage_ > 0;
 }
 float testBoard::battery_voltage_read() const
 {
-  return 0;
+  return battery_voltage_;
 }
 void testBoard::battery_voltage_set_multiplier(double multiplier)
 {
@@ -240,19 +301,126 @@ float testBoard::rc_read(uint8_t channel)
 {
   return static_cast<float>(rc_values[channel] - 1000) / 1000.0;
 }
-void testBoard::pwm_write(uint8_t channel, float value) {}
+void testBoard::pwm_write_all(const float *value, const Mixer::output_type_t *type, uint8_t count)
+{
+  pwm_write_count_++;
+  for (uint8_t i = 0; i < count && i < NUM_PWM_CHANNELS; i++)
+  {
+    if (type[i] == Mixer::S || type[i] == Mixer::M)
+      pwm_values_[i] = value[i];
+  }
+}
 void testBoard::pwm_init(uint32_t refresh_rate, uint16_t idle_pwm) {}
 void testBoard::pwm_disable() {}
 
+// DShot
+bool testBoard::dshot_init(uint16_t bitrate_kbps, bool bidirectional, uint16_t channel_mask)
+{
+  dshot_mask_ = channel_mask;
+  return true;
+}
+void testBoard::dshot_write(const uint16_t *frames, uint8_t count)
+{
+  for (uint8_t i = 0; i < count && i < NUM_DSHOT_CHANNELS; i++)
+  {
+    if (dshot_mask_ & (1 << i))
+      dshot_frames_[i] = frames[i];
+  }
+}
+bool testBoard::dshot_read_telemetry(uint8_t channel, uint32_t *gcr_frame)
+{
+  if (channel >= NUM_DSHOT_CHANNELS || dshot_telemetry_[channel] == 0)
+    return false;
+  *gcr_frame = dshot_telemetry_[channel];
+  return true;
+}
+
 // non-volatile memory
 void testBoard::memory_init() {}
 bool testBoard::memory_read(void *dest, size_t len)
 {
-  return false;
+  if (len > MEMORY_SIZE)
+    return false;
+  memcpy(dest, memory_, len);
+  return true;
 }
 bool testBoard::memory_write(const void *src, size_t len)
 {
-  return false;
+  if (len > MEMORY_SIZE)
+    return false;
+  memcpy(memory_, src, len);
+  return true;
+}
+
+// models NOR flash: erasing sets every bit and programming can only clear them
+size_t testBoard::param_journal_sector_size()
+{
+  return param_journal_enabled_ ? PARAM_JOURNAL_SECTOR_SIZE : 0;
+}
+bool testBoard::param_journal_erase(uint8_t sector)
+{
+  if (sector > 1)
+    return false;
+  memset(param_journal_[sector], 0xFF, PARAM_JOURNAL_SECTOR_SIZE);
+  param_journal_erase_count_[sector]++;
+  return true;
+}
+bool testBoard::param_journal_read(uint8_t sector, size_t offset, void *dest, size_t len)
+{
+  if (sector > 1 || offset + len > PARAM_JOURNAL_SECTOR_SIZE)
+    return false;
+  memcpy(dest, param_journal_[sector] + offset, len);
+  return true;
+}
+bool testBoard::param_journal_program(uint8_t sector, size_t offset, const void *src, size_t len)
+{
+  if (sector > 1 || offset + len > PARAM_JOURNAL_SECTOR_SIZE || offset % 4 != 0 || len % 4 != 0)
+    return false;
+  const uint8_t *bytes = static_cast<const uint8_t *>(src);
+  bool success = true;
+  for (size_t i = 0; i < len; i++)
+  {
+    param_journal_[sector][offset + i] &= bytes[i];
+    if (param_journal_[sector][offset + i] != bytes[i])
+      success = false;
+  }
+  return success;
+}
+size_t testBoard::log_storage_size()
+{
+  return LOG_STORAGE_SIZE;
+}
+bool testBoard::log_storage_busy()
+{
+  if (log_storage_busy_polls_ == 0)
+    return false;
+  log_storage_busy_polls_--;
+  return true;
+}
+bool testBoard::log_storage_erase()
+{
+  if (log_storage_busy_polls_ > 0)
+    return false;
+  memset(log_storage_, 0xFF, LOG_STORAGE_SIZE);
+  log_storage_busy_polls_ = log_storage_latency_;
+  return true;
+}
+bool testBoard::log_storage_write(size_t offset, const void *src, size_t len)
+{
+  if (log_storage_busy_polls_ > 0 || offset + len > LOG_STORAGE_SIZE)
+    return false;
+  const uint8_t *bytes = static_cast<const uint8_t *>(src);
+  for (size_t i = 0; i < len; i++)
+    log_storage_[offset + i] &= bytes[i];
+  log_storage_busy_polls_ = log_storage_latency_;
+  return true;
+}
+bool testBoard::log_storage_read(size_t offset, void *dest, size_t len)
+{
+  if (log_storage_busy_polls_ > 0 || offset + len > LOG_STORAGE_SIZE)
+    return false;
+  memcpy(dest, log_storage_ + offset, len);
+  return true;
 }
 
 // LEDs
@@ -45,11 +45,40 @@ private:
   bool rc_lost_ = false;
   float acc_[3] = {0, 0, 0};
   float gyro_[3] = {0, 0, 0};
+  float battery_voltage_ = 0; // not present while zero
   bool new_imu_ = false;
   static constexpr size_t BACKUP_MEMORY_SIZE{1024};
   uint8_t backup_memory_[BACKUP_MEMORY_SIZE];
+  static constexpr size_t NUM_PWM_CHANNELS{14};
+  float pwm_values_[NUM_PWM_CHANNELS] = {0};
+  uint32_t pwm_write_count_ = 0;
+  static constexpr size_t NUM_DSHOT_CHANNELS{14};
+  uint16_t dshot_mask_ = 0;
+  uint16_t dshot_frames_[NUM_DSHOT_CHANNELS] = {0};
+  uint32_t dshot_telemetry_[NUM_DSHOT_CHANNELS] = {0};
+  static constexpr size_t SERIAL_TX_BUFFER_SIZE{512};
+  uint8_t serial_tx_buffer_[SERIAL_TX_BUFFER_SIZE];
+  size_t serial_tx_bytes_ = 0;
+  size_t serial_tx_frame_len_ = 0; // length of the last write or commit, which is left in serial_tx_buffer_
+  uint32_t serial_tx_frames_ = 0;
+  static constexpr size_t SERIAL_RX_BUFFER_SIZE{4096};
+  uint8_t serial_rx_buffer_[SERIAL_RX_BUFFER_SIZE];
+  size_t serial_rx_head_ = 0;
+  size_t serial_rx_tail_ = 0;
+  static constexpr size_t MEMORY_SIZE{4096};
+  uint8_t memory_[MEMORY_SIZE] = {0};
+  static constexpr size_t PARAM_JOURNAL_SECTOR_SIZE{4096};
+  uint8_t param_journal_[2][PARAM_JOURNAL_SECTOR_SIZE];
+  uint32_t param_journal_erase_count_[2] = {0, 0};
+  bool param_journal_enabled_ = true;
+  static constexpr size_t LOG_STORAGE_SIZE{16384};
+  uint8_t log_storage_[LOG_STORAGE_SIZE];
+  uint32_t log_storage_latency_ = 0; // polls of log_storage_busy() an erase or write takes to complete
+  uint32_t log_storage_busy_polls_ = 0;
 
 public:
+  testBoard();
+
   // setup
   void init_board() override;
   void board_reset(bool bootloader) override;
@@ -62,8 +91,11 @@ public:
   // serial
   void serial_init(uint32_t baud_rate, uint32_t dev) override;
   void serial_write(const uint8_t *src, size_t len) override;
+  uint8_t *serial_reserve(size_t len) override;
+  void serial_commit(size_t len) override;
   uint16_t serial_bytes_available() override;
   uint8_t serial_read() override;
+  size_t serial_read(uint8_t *dest, size_t len) override;
   void serial_flush() override;
 
   // sensors
@@ -112,12 +144,26 @@ public:
   // PWM
   void pwm_init(uint32_t refresh_rate, uint16_t idle_pwm) override;
   void pwm_disable() override;
-  void pwm_write(uint8_t channel, float value) override;
+  void pwm_write_all(const float *value, const Mixer::output_type_t *type, uint8_t count) override;
+
+  // DShot
+  bool dshot_init(uint16_t bitrate_kbps, bool bidirectional, uint16_t channel_mask) override;
+  void dshot_write(const uint16_t *frames, uint8_t count) override;
+  bool dshot_read_telemetry(uint8_t channel, uint32_t *gcr_frame) override;
 
   // non-volatile memory
   void memory_init() override;
   bool memory_read(void *dest, size_t len) override;
   bool memory_write(const void *src, size_t len) override;
+  size_t param_journal_sector_size() override;
+  bool param_journal_erase(uint8_t sector) override;
+  bool param_journal_read(uint8_t sector, size_t offset, void *dest, size_t len) override;
+  bool param_journal_program(uint8_t sector, size_t offset, const void *src, size_t len) override;
+  size_t log_storage_size() override;
+  bool log_storage_busy() override;
+  bool log_storage_erase() override;
+  bool log_storage_write(size_t offset, const void *src, size_t len) override;
+  bool log_storage_read(size_t offset, void *dest, size_t len) override;
 
   // LEDs
   void led0_on() override;
@@ -139,6 +185,23 @@ public:
   void set_rc(uint16_t *values);
   void set_time(uint64_t time_us);
   void set_pwm_lost(bool lost);
+  void set_battery_voltage(float voltage) { battery_voltage_ = voltage; }
+  float pwm_value(uint8_t channel) const;
+  uint32_t pwm_write_count() const { return pwm_write_count_; }
+  uint16_t dshot_frame(uint8_t channel) const;
+  void set_dshot_telemetry(uint8_t channel, uint32_t gcr_frame);
+  size_t serial_tx_bytes() const { return serial_tx_bytes_; }
+  uint32_t serial_tx_frames() const { return serial_tx_frames_; }
+  const uint8_t *serial_tx_frame() const { return serial_tx_buffer_; }
+  size_t serial_tx_frame_len() const { return serial_tx_frame_len_; }
+  void serial_receive(const uint8_t *src, size_t len); // queues bytes for serial_read()
+  size_t serial_rx_bytes() const { return serial_rx_tail_ - serial_rx_head_; }
+  uint8_t *memory() { return memory_; }
+  uint8_t *param_journal_sector(uint8_t sector) { return param_journal_[sector]; }
+  uint32_t param_journal_erase_count(uint8_t sector) const { return param_journal_erase_count_[sector]; }
+  void set_param_journal_enabled(bool enabled) { param_journal_enabled_ = enabled; }
+  uint8_t *log_storage() { return log_storage_; }
+  void set_log_storage_latency(uint32_t polls) { log_storage_latency_ = polls; }
 };
 
 } // namespace rosflight_firmware
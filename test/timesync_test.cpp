@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2017, James Jackson and Daniel Koch, BYU MAGICC Lab
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "common.h"
+
+#include "timesync.h"
+
+#include <cstdlib>
+
+using namespace rosflight_firmware;
+
+// A companion clock that runs 50 ppm fast and started long before the board
+static uint64_t companion_us(uint64_t board_us)
+{
+  return 1600000000000000ull + board_us + board_us / 20000;
+}
+
+// a repeatable spread of link delays between 1 and 3 ms
+static uint64_t link_delay_us(int i)
+{
+  return 1000 + static_cast<uint64_t>((i * 7919) % 2000);
+}
+
+static void round_trip(TimeSync &timesync, uint64_t request_us, int i)
+{
+  uint64_t uplink_us = link_delay_us(i);
+  uint64_t reply_us = request_us + uplink_us + link_delay_us(i + 1);
+  timesync.add_round_trip(request_us, reply_us, companion_us(request_us + uplink_us));
+}
+
+TEST(TimeSyncTest, RoundTripsConvergeOnOffsetAndSkew)
+{
+  TimeSync timesync;
+  uint64_t t = 3000000;
+  for (int i = 0; i < TimeSync::MIN_SAMPLES - 1; i++, t += 1000000)
+    round_trip(timesync, t, i);
+  EXPECT_FALSE(timesync.valid());
+
+  for (int i = 0; i < 40; i++, t += 1000000)
+    round_trip(timesync, t, i);
+  ASSERT_TRUE(timesync.valid());
+
+  // asymmetric delays put up to 1 ms of error in each sample, which the fit averages down
+  EXPECT_NEAR(timesync.skew(), 50e-6, 10e-6);
+  int64_t error_us = static_cast<int64_t>(timesync.to_remote(t) - companion_us(t));
+  EXPECT_LT(std::abs(error_us), 500);
+  EXPECT_EQ(timesync.to_local(timesync.to_remote(t)), t);
+}
+
+TEST(TimeSyncTest, OneWaySamplesAreDroppedOnceRoundTripsArrive)
+{
+  TimeSync timesync;
+  uint64_t t = 0;
+  for (int i = 0; i < 10; i++, t += 1000000)
+    timesync.add_one_way(t + 20000, companion_us(t)); // 20 ms uplink
+  ASSERT_TRUE(timesync.valid());
+  int64_t offset_error_us = static_cast<int64_t>(timesync.to_remote(t) - companion_us(t));
+  EXPECT_NEAR(static_cast<double>(offset_error_us), -20000.0, 100.0); // the uplink delay is part of the offset
+
+  for (int i = 0; i < 10; i++, t += 1000000)
+  {
+    timesync.add_one_way(t + 20000, companion_us(t));
+    round_trip(timesync, t, i);
+  }
+  ASSERT_TRUE(timesync.valid());
+  int64_t error_us = static_cast<int64_t>(timesync.to_remote(t) - companion_us(t));
+  EXPECT_LT(std::abs(error_us), 1000);
+  EXPECT_EQ(timesync.resyncs(), 0u);
+}
+
+TEST(TimeSyncTest, SteppedCompanionClockRestartsTheFit)
+{
+  TimeSync timesync;
+  uint64_t t = 0;
+  for (int i = 0; i < 20; i++, t += 1000000)
+    round_trip(timesync, t, i);
+  ASSERT_TRUE(timesync.valid());
+
+  // a single late reply is ignored
+  timesync.add_round_trip(t, t + 100000, companion_us(t + 50000) + 40000);
+  t += 1000000;
+  EXPECT_TRUE(timesync.valid());
+  EXPECT_EQ(timesync.resyncs(), 0u);
+  round_trip(timesync, t, 0);
+  t += 1000000;
+
+  // the companion clock jumps forward 10 s and stays there
+  for (int i = 0; i < 3; i++, t += 1000000)
+  {
+    uint64_t request_us = t;
+    timesync.add_round_trip(request_us, request_us + 2000, companion_us(request_us + 1000) + 10000000);
+  }
+  EXPECT_EQ(timesync.resyncs(), 1u);
+  EXPECT_FALSE(timesync.valid());
+
+  for (int i = 0; i < 20; i++, t += 1000000)
+    timesync.add_round_trip(t, t + 2000, companion_us(t + 1000) + 10000000);
+  ASSERT_TRUE(timesync.valid());
+  int64_t error_us = static_cast<int64_t>(timesync.to_remote(t) - companion_us(t) - 10000000);
+  EXPECT_LT(std::abs(error_us), 100);
+}